@@ -0,0 +1,465 @@
+/*
+symhash.c
+Author: David Wang
+*/
+
+#include <assert.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "symhash.h"
+
+/* the key and the seed count are shared by every thread of the
+process, and are set up with the GCC atomic builtins */
+#ifndef __GNUC__
+#error "symhash.c requires the GCC __atomic builtins"
+#endif
+
+#if !defined(SYMHASH_LEGACY) && !defined(SYMHASH_SIPHASH)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#endif
+
+/* odd 64-bit multipliers with well-mixed bits */
+static const uint64_t uPrime1 = UINT64_C(0x9e3779b185ebca87);
+static const uint64_t uPrime2 = UINT64_C(0xc2b2ae3d27d4eb4f);
+static const uint64_t uPrime3 = UINT64_C(0x165667b19e3779f9);
+
+/* The secret key of the process, drawn from /dev/urandom the first
+   time a hash code or seed is needed. iKeyState goes from KEY_ABSENT
+   to KEY_DRAWING when one thread starts drawing it, and to KEY_READY,
+   with a release store, once it has. */
+static uint64_t auKey[2];
+enum {KEY_ABSENT, KEY_DRAWING, KEY_READY};
+static int iKeyState = KEY_ABSENT;
+
+/* the number of per-table seeds handed out so far, incremented
+   atomically since the concurrent table creates tables on any
+   thread */
+static uint64_t uSeedCount = 0;
+
+
+/* Return uHash with every input bit spread over every output bit. */
+static uint64_t SymHash_avalanche(uint64_t uHash)
+{
+    uHash ^= uHash >> 33;
+    uHash *= uPrime2;
+    uHash ^= uHash >> 29;
+    uHash *= uPrime3;
+    uHash ^= uHash >> 32;
+    return uHash;
+}
+
+
+#ifndef SYMHASH_LEGACY
+
+/* Return uWord rotated left by iBits, which must be in 1..63. */
+static uint64_t SymHash_rotl(uint64_t uWord, int iBits)
+{
+    return (uWord << iBits) | (uWord >> (64 - iBits));
+}
+
+
+/* Return the 8 bytes at pcBytes as a 64-bit word. */
+static uint64_t SymHash_load(const unsigned char *pcBytes)
+{
+    uint64_t uWord;
+
+    memcpy(&uWord, pcBytes, sizeof(uWord));
+    return uWord;
+}
+
+#endif
+
+
+#if !defined(SYMHASH_LEGACY) && !defined(SYMHASH_SIPHASH)
+
+static const uint64_t uPrime4 = UINT64_C(0x85ebca77c2b2ae63);
+
+/* the 32-bit multiplier used to scramble the lane accumulators */
+static const uint32_t uScramblePrime = 0x9e3779b1U;
+
+/* Keys of at least LANE_STRIPE bytes are consumed one stripe of
+   LANE_COUNT 8-byte lanes at a time, and the lanes are scrambled
+   after every LANE_STRIPES_PER_BLOCK stripes. */
+enum {LANE_COUNT = 8};
+enum {LANE_STRIPE = LANE_COUNT * 8};
+enum {LANE_STRIPES_PER_BLOCK = 16};
+
+/* The constants that stripe data is combined with, derived from the
+   process key. Each stripe of a block uses a window of LANE_COUNT
+   words starting one word further along than the last, so that
+   reordering stripes changes the hash code; the last LANE_COUNT words
+   are used to scramble. */
+static uint64_t auLaneSecret[LANE_STRIPES_PER_BLOCK + LANE_COUNT];
+
+#endif
+
+
+/* Draw the process key if that has not been done yet. Of threads that
+   call this at once, one draws the key and the others wait until it
+   is ready. */
+static void SymHash_initKey(void)
+{
+    FILE *psRandom;
+    size_t uRead = 0;
+    int iExpected = KEY_ABSENT;
+#if !defined(SYMHASH_LEGACY) && !defined(SYMHASH_SIPHASH)
+    size_t u;
+#endif
+
+    if (__atomic_load_n(&iKeyState, __ATOMIC_ACQUIRE) == KEY_READY)
+        return;
+    if (!__atomic_compare_exchange_n(&iKeyState, &iExpected, KEY_DRAWING,
+        0, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        /* another thread is drawing the key, which takes one read */
+        while (__atomic_load_n(&iKeyState, __ATOMIC_ACQUIRE) != KEY_READY)
+            ;
+        return;
+    }
+
+    psRandom = fopen("/dev/urandom", "rb");
+    if (psRandom != NULL) {
+        uRead = fread(auKey, sizeof(auKey), 1, psRandom);
+        fclose(psRandom);
+    }
+    /* without /dev/urandom, fall back on the clocks and the address
+    of the stack, which are at least different from run to run */
+    if (uRead != 1) {
+        auKey[0] = SymHash_avalanche((uint64_t)time(NULL) ^ uPrime1);
+        auKey[1] = SymHash_avalanche((uint64_t)clock() ^
+            (uint64_t)(size_t)&psRandom ^ auKey[0]);
+    }
+
+#if !defined(SYMHASH_LEGACY) && !defined(SYMHASH_SIPHASH)
+    for (u = 0; u < sizeof(auLaneSecret) / sizeof(auLaneSecret[0]); u++)
+        auLaneSecret[u] = SymHash_avalanche(auKey[1] + (u+1) * uPrime4);
+#endif
+    __atomic_store_n(&iKeyState, KEY_READY, __ATOMIC_RELEASE);
+}
+
+
+#if defined(SYMHASH_LEGACY)
+
+/* The original hash, which ignores the process key, so that the keys
+   that collide under it are known in advance. */
+uint64_t SymHash_hash(const void *pvKey, size_t uKeyLength)
+{
+    const uint64_t HASH_MULTIPLIER = 65599;
+    const char *pcKey = (const char *)pvKey;
+    size_t u;
+    uint64_t uHash = 0;
+
+    assert(pvKey != NULL);
+
+    SymHash_initKey();
+
+    for (u = 0; u < uKeyLength; u++)
+        uHash = uHash * HASH_MULTIPLIER + (uint64_t)pcKey[u];
+
+    /* spread the high-order bits into the low-order bits, which are
+    the only ones a power-of-2 mask keeps */
+    uHash ^= uHash >> 16;
+    uHash *= UINT64_C(0x7feb352d);
+    uHash ^= uHash >> 15;
+    uHash *= UINT64_C(0x846ca68b);
+    uHash ^= uHash >> 16;
+    return uHash;
+}
+
+#elif defined(SYMHASH_SIPHASH)
+
+/* Apply one SipRound to the state auV. */
+static void SymHash_sipRound(uint64_t auV[])
+{
+    auV[0] += auV[1];
+    auV[1] = SymHash_rotl(auV[1], 13);
+    auV[1] ^= auV[0];
+    auV[0] = SymHash_rotl(auV[0], 32);
+    auV[2] += auV[3];
+    auV[3] = SymHash_rotl(auV[3], 16);
+    auV[3] ^= auV[2];
+    auV[0] += auV[3];
+    auV[3] = SymHash_rotl(auV[3], 21);
+    auV[3] ^= auV[0];
+    auV[2] += auV[1];
+    auV[1] = SymHash_rotl(auV[1], 17);
+    auV[1] ^= auV[2];
+    auV[2] = SymHash_rotl(auV[2], 32);
+}
+
+
+/* SipHash-1-3 keyed with the process key: one SipRound per 8-byte
+   word and three to finish. */
+uint64_t SymHash_hash(const void *pvKey, size_t uKeyLength)
+{
+    const unsigned char *pcBytes = (const unsigned char *)pvKey;
+    const unsigned char *pcEnd;
+    uint64_t auV[4];
+    uint64_t uWord;
+    int i;
+
+    assert(pvKey != NULL);
+
+    SymHash_initKey();
+
+    auV[0] = auKey[0] ^ UINT64_C(0x736f6d6570736575);
+    auV[1] = auKey[1] ^ UINT64_C(0x646f72616e646f6d);
+    auV[2] = auKey[0] ^ UINT64_C(0x6c7967656e657261);
+    auV[3] = auKey[1] ^ UINT64_C(0x7465646279746573);
+
+    pcEnd = pcBytes + uKeyLength;
+    for (; pcEnd - pcBytes >= 8; pcBytes += 8) {
+        uWord = SymHash_load(pcBytes);
+        auV[3] ^= uWord;
+        SymHash_sipRound(auV);
+        auV[0] ^= uWord;
+    }
+
+    /* the last 0 to 7 bytes, with the low byte of the length on top */
+    uWord = 0;
+    memcpy(&uWord, pcBytes, (size_t)(pcEnd - pcBytes));
+    uWord |= (uint64_t)(uKeyLength & 0xff) << 56;
+    auV[3] ^= uWord;
+    SymHash_sipRound(auV);
+    auV[0] ^= uWord;
+
+    auV[2] ^= 0xff;
+    for (i = 0; i < 3; i++)
+        SymHash_sipRound(auV);
+    return auV[0] ^ auV[1] ^ auV[2] ^ auV[3];
+}
+
+#else
+
+/* Return uHash after it absorbs the 64-bit word uWord. */
+static uint64_t SymHash_round(uint64_t uHash, uint64_t uWord)
+{
+    uWord *= uPrime2;
+    uWord = SymHash_rotl(uWord, 31);
+    uWord *= uPrime1;
+    uHash ^= uWord;
+    return SymHash_rotl(uHash, 27) * uPrime1 + uPrime4;
+}
+
+
+#if defined(__AVX2__)
+
+/* Add the uStripes stripes at pcBytes into the accumulators auAcc,
+   combining the lanes of the n-th stripe of each block with
+   auLaneSecret[n..n+LANE_COUNT-1] and scrambling them after every
+   LANE_STRIPES_PER_BLOCK stripes, and return the address of the first
+   byte not consumed. */
+static const unsigned char *SymHash_lanes(uint64_t auAcc[],
+    const unsigned char *pcBytes, size_t uStripes)
+{
+    __m256i avAcc[2];
+    __m256i vSecret;
+    __m256i vPrime;
+    __m256i vData;
+    __m256i vKey;
+    __m256i vProduct;
+    size_t uStripe;
+    int i;
+
+    for (i = 0; i < 2; i++)
+        avAcc[i] = _mm256_loadu_si256((const __m256i *)(auAcc + 4*i));
+    vPrime = _mm256_set1_epi32((int)uScramblePrime);
+
+    for (uStripe = 1; uStripe <= uStripes; uStripe++) {
+        for (i = 0; i < 2; i++) {
+            vData = _mm256_loadu_si256((const __m256i *)(pcBytes + 32*i));
+            vSecret = _mm256_loadu_si256((const __m256i *)(auLaneSecret +
+                (uStripe - 1) % LANE_STRIPES_PER_BLOCK + 4*i));
+            vKey = _mm256_xor_si256(vData, vSecret);
+            /* low half of each lane times its high half, plus the
+            neighbouring lane's data */
+            vProduct = _mm256_mul_epu32(vKey,
+                _mm256_shuffle_epi32(vKey, 0x31));
+            avAcc[i] = _mm256_add_epi64(avAcc[i],
+                _mm256_add_epi64(vProduct,
+                    _mm256_shuffle_epi32(vData, 0x4e)));
+        }
+        pcBytes += LANE_STRIPE;
+
+        if (uStripe % LANE_STRIPES_PER_BLOCK == 0) {
+            for (i = 0; i < 2; i++) {
+                vData = _mm256_xor_si256(avAcc[i],
+                    _mm256_srli_epi64(avAcc[i], 47));
+                vSecret = _mm256_loadu_si256((const __m256i *)(
+                    auLaneSecret + LANE_STRIPES_PER_BLOCK + 4*i));
+                vData = _mm256_xor_si256(vData, vSecret);
+                /* 64-bit by 32-bit multiply from two 32-bit ones */
+                avAcc[i] = _mm256_add_epi64(
+                    _mm256_mul_epu32(vData, vPrime),
+                    _mm256_slli_epi64(_mm256_mul_epu32(
+                        _mm256_srli_epi64(vData, 32), vPrime), 32));
+            }
+        }
+    }
+
+    for (i = 0; i < 2; i++)
+        _mm256_storeu_si256((__m256i *)(auAcc + 4*i), avAcc[i]);
+    return pcBytes;
+}
+
+#elif defined(__SSE2__)
+
+/* Add the uStripes stripes at pcBytes into the accumulators auAcc,
+   combining the lanes of the n-th stripe of each block with
+   auLaneSecret[n..n+LANE_COUNT-1] and scrambling them after every
+   LANE_STRIPES_PER_BLOCK stripes, and return the address of the first
+   byte not consumed. */
+static const unsigned char *SymHash_lanes(uint64_t auAcc[],
+    const unsigned char *pcBytes, size_t uStripes)
+{
+    __m128i avAcc[4];
+    __m128i vSecret;
+    __m128i vPrime;
+    __m128i vData;
+    __m128i vKey;
+    __m128i vProduct;
+    size_t uStripe;
+    int i;
+
+    for (i = 0; i < 4; i++)
+        avAcc[i] = _mm_loadu_si128((const __m128i *)(auAcc + 2*i));
+    vPrime = _mm_set1_epi32((int)uScramblePrime);
+
+    for (uStripe = 1; uStripe <= uStripes; uStripe++) {
+        for (i = 0; i < 4; i++) {
+            vData = _mm_loadu_si128((const __m128i *)(pcBytes + 16*i));
+            vSecret = _mm_loadu_si128((const __m128i *)(auLaneSecret +
+                (uStripe - 1) % LANE_STRIPES_PER_BLOCK + 2*i));
+            vKey = _mm_xor_si128(vData, vSecret);
+            /* low half of each lane times its high half, plus the
+            neighbouring lane's data */
+            vProduct = _mm_mul_epu32(vKey, _mm_shuffle_epi32(vKey, 0x31));
+            avAcc[i] = _mm_add_epi64(avAcc[i],
+                _mm_add_epi64(vProduct, _mm_shuffle_epi32(vData, 0x4e)));
+        }
+        pcBytes += LANE_STRIPE;
+
+        if (uStripe % LANE_STRIPES_PER_BLOCK == 0) {
+            for (i = 0; i < 4; i++) {
+                vData = _mm_xor_si128(avAcc[i],
+                    _mm_srli_epi64(avAcc[i], 47));
+                vSecret = _mm_loadu_si128((const __m128i *)(
+                    auLaneSecret + LANE_STRIPES_PER_BLOCK + 2*i));
+                vData = _mm_xor_si128(vData, vSecret);
+                /* 64-bit by 32-bit multiply from two 32-bit ones */
+                avAcc[i] = _mm_add_epi64(_mm_mul_epu32(vData, vPrime),
+                    _mm_slli_epi64(_mm_mul_epu32(
+                        _mm_srli_epi64(vData, 32), vPrime), 32));
+            }
+        }
+    }
+
+    for (i = 0; i < 4; i++)
+        _mm_storeu_si128((__m128i *)(auAcc + 2*i), avAcc[i]);
+    return pcBytes;
+}
+
+#else
+
+/* Add the uStripes stripes at pcBytes into the accumulators auAcc,
+   combining the lanes of the n-th stripe of each block with
+   auLaneSecret[n..n+LANE_COUNT-1] and scrambling them after every
+   LANE_STRIPES_PER_BLOCK stripes, and return the address of the first
+   byte not consumed. */
+static const unsigned char *SymHash_lanes(uint64_t auAcc[],
+    const unsigned char *pcBytes, size_t uStripes)
+{
+    uint64_t uData;
+    uint64_t uKey;
+    size_t uStripe;
+    int i;
+
+    for (uStripe = 1; uStripe <= uStripes; uStripe++) {
+        for (i = 0; i < LANE_COUNT; i++) {
+            uData = SymHash_load(pcBytes + 8*i);
+            uKey = uData ^
+                auLaneSecret[(uStripe - 1) % LANE_STRIPES_PER_BLOCK + i];
+            /* low half of the lane times its high half, plus the
+            neighbouring lane's data */
+            auAcc[i] += (uKey & 0xffffffffU) * (uKey >> 32);
+            auAcc[i ^ 1] += uData;
+        }
+        pcBytes += LANE_STRIPE;
+
+        if (uStripe % LANE_STRIPES_PER_BLOCK == 0) {
+            for (i = 0; i < LANE_COUNT; i++) {
+                auAcc[i] ^= auAcc[i] >> 47;
+                auAcc[i] ^= auLaneSecret[LANE_STRIPES_PER_BLOCK + i];
+                auAcc[i] *= uScramblePrime;
+            }
+        }
+    }
+    return pcBytes;
+}
+
+#endif
+
+
+uint64_t SymHash_hash(const void *pvKey, size_t uKeyLength)
+{
+    const unsigned char *pcBytes = (const unsigned char *)pvKey;
+    const unsigned char *pcEnd;
+    uint64_t auAcc[LANE_COUNT];
+    uint64_t uHash;
+    uint64_t uTail;
+    int i;
+
+    assert(pvKey != NULL);
+
+    SymHash_initKey();
+
+    pcEnd = pcBytes + uKeyLength;
+    uHash = (auKey[0] ^ (uint64_t)uKeyLength * uPrime1) + uPrime3;
+
+    /* long keys: wide, independent lanes, folded into the hash */
+    if (uKeyLength >= LANE_STRIPE) {
+        for (i = 0; i < LANE_COUNT; i++)
+            auAcc[i] = auKey[1] + auLaneSecret[i];
+        pcBytes = SymHash_lanes(auAcc, pcBytes,
+            uKeyLength / LANE_STRIPE);
+        for (i = 0; i < LANE_COUNT; i++)
+            uHash = SymHash_round(uHash, auAcc[i]);
+    }
+
+    /* the rest, one 8-byte word per step */
+    for (; pcEnd - pcBytes >= 8; pcBytes += 8)
+        uHash = SymHash_round(uHash, SymHash_load(pcBytes));
+
+    /* the last 0 to 7 bytes, zero-padded into one word; the length
+    mixed in above tells such keys from their padded forms */
+    if (pcBytes < pcEnd) {
+        uTail = 0;
+        memcpy(&uTail, pcBytes, (size_t)(pcEnd - pcBytes));
+        uHash = SymHash_round(uHash, uTail);
+    }
+
+    return SymHash_avalanche(uHash);
+}
+
+#endif
+
+
+uint64_t SymHash_newSeed(void)
+{
+    SymHash_initKey();
+
+    return SymHash_avalanche(auKey[0] ^
+        __atomic_add_fetch(&uSeedCount, 1, __ATOMIC_RELAXED) * uPrime1);
+}
+
+
+uint64_t SymHash_tableHash(uint64_t uHash, uint64_t uSeed)
+{
+    return SymHash_avalanche(uHash ^ uSeed);
+}
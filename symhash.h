@@ -0,0 +1,34 @@
+/*
+symhash.h
+Author: David Wang
+*/
+
+#ifndef SYMHASH_INCLUDED
+#define SYMHASH_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+Return a hash code for the uKeyLength bytes at pvKey. Every bit of
+the result depends on every byte of the key, so the low-order bits
+may be used directly as a table index. The hash is keyed with a
+secret drawn from /dev/urandom once per process, so which keys
+collide cannot be predicted from outside. Keys are consumed 8 bytes
+per step, and keys of 64 bytes or more 64 bytes per step in SIMD
+lanes where SSE2 or AVX2 is available; every path returns the same
+hash code. Compiling with -DSYMHASH_SIPHASH selects SipHash-1-3
+instead, and -DSYMHASH_LEGACY the original, unkeyed 65599 hash.
+Any number of threads may call the functions of this module at once.
+*/
+uint64_t SymHash_hash(const void *pvKey, size_t uKeyLength);
+
+/* Return a new secret seed for one table, for use with
+SymHash_tableHash. */
+uint64_t SymHash_newSeed(void);
+
+/* Return the hash code uHash rehashed under the table seed uSeed. The
+mapping is one-to-one, so equal hash codes stay equal, but hash codes
+that share low-order bits in one table need not in another. */
+uint64_t SymHash_tableHash(uint64_t uHash, uint64_t uSeed);
+
+#endif
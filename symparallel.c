@@ -0,0 +1,268 @@
+/*
+symparallel.c
+Author: David Wang
+*/
+
+/* pthreads are POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "symparallel.h"
+
+/* the number of items in a chunk, the unit that threads take and
+steal: enough buckets or slots that taking one costs little beside
+visiting it, and few enough that there are many per thread */
+static const size_t uChunkItems = 1024;
+
+/* the size of the cache lines that each deque is kept apart from the
+others' by */
+enum {CACHE_LINE_SIZE = 64};
+
+/* A SymParallelDeque holds the chunks that one thread has not yet
+   started: its owner takes them from the front, and other threads
+   steal them from the back. */
+struct SymParallelDeque
+{
+    /* Held to take chunks from the deque or give it some */
+    pthread_mutex_t sLock;
+
+    /* The first chunk not yet taken */
+    size_t uNext;
+
+    /* One past the last chunk not yet taken */
+    size_t uEnd;
+
+    /* keeps the next deque out of the cache lines of this one */
+    char acPadding[CACHE_LINE_SIZE];
+};
+
+
+/* A SymParallelRun is one call of SymParallel_run, shared by all of
+   its threads. */
+struct SymParallelRun
+{
+    /* The number of items, and of chunks they make */
+    size_t uItemCount;
+    size_t uChunkCount;
+
+    /* The function that handles a range of items, and its extra
+    parameter */
+    void (*pfRange)(size_t uBegin, size_t uEnd, void *pvExtra);
+    void *pvExtra;
+
+    /* The number of threads, and their deques */
+    size_t uWorkerCount;
+    struct SymParallelDeque *asDeques;
+};
+
+
+/* A SymParallelWorker is one thread of a SymParallelRun. */
+struct SymParallelWorker
+{
+    /* The run that the thread works on */
+    struct SymParallelRun *psRun;
+
+    /* The index of the thread's deque */
+    size_t uIndex;
+
+    /* The thread, unless it is the calling thread */
+    pthread_t sThread;
+
+    /* 1 (TRUE) if sThread was started */
+    int iStarted;
+};
+
+
+/* Lock psLock. */
+static void SymParallel_lock(pthread_mutex_t *psLock)
+{
+    int iStatus;
+
+    assert(psLock != NULL);
+
+    iStatus = pthread_mutex_lock(psLock);
+    assert(iStatus == 0);
+    (void)iStatus;
+}
+
+
+/* Release psLock, which the calling thread holds. */
+static void SymParallel_unlock(pthread_mutex_t *psLock)
+{
+    int iStatus;
+
+    assert(psLock != NULL);
+
+    iStatus = pthread_mutex_unlock(psLock);
+    assert(iStatus == 0);
+    (void)iStatus;
+}
+
+
+/* Take the first chunk of psDeque, store its index in *puChunk, and
+   return 1 (TRUE). Return 0 (FALSE) if psDeque is empty. */
+static int SymParallel_take(struct SymParallelDeque *psDeque,
+    size_t *puChunk)
+{
+    int iTaken;
+
+    assert(psDeque != NULL);
+    assert(puChunk != NULL);
+
+    SymParallel_lock(&psDeque->sLock);
+    iTaken = psDeque->uNext < psDeque->uEnd;
+    if (iTaken)
+        *puChunk = psDeque->uNext++;
+    SymParallel_unlock(&psDeque->sLock);
+    return iTaken;
+}
+
+
+/* Move the later half of the chunks left in another deque of psRun,
+   trying each in turn from the one after the deque uIndex, into that
+   deque, which is empty, and return 1 (TRUE). Return 0 (FALSE) if
+   every deque is empty. */
+static int SymParallel_steal(struct SymParallelRun *psRun, size_t uIndex)
+{
+    struct SymParallelDeque *psVictim;
+    struct SymParallelDeque *psOwn;
+    size_t uStolen = 0;
+    size_t uBegin = 0;
+    size_t i;
+
+    assert(psRun != NULL);
+
+    for (i = 1; i < psRun->uWorkerCount && uStolen == 0; i++) {
+        psVictim = &psRun->asDeques[(uIndex + i) % psRun->uWorkerCount];
+        SymParallel_lock(&psVictim->sLock);
+        uStolen = (psVictim->uEnd - psVictim->uNext + 1) / 2;
+        psVictim->uEnd -= uStolen;
+        uBegin = psVictim->uEnd;
+        SymParallel_unlock(&psVictim->sLock);
+    }
+    if (uStolen == 0)
+        return 0;
+
+    psOwn = &psRun->asDeques[uIndex];
+    SymParallel_lock(&psOwn->sLock);
+    psOwn->uNext = uBegin;
+    psOwn->uEnd = uBegin + uStolen;
+    SymParallel_unlock(&psOwn->sLock);
+    return 1;
+}
+
+
+/* Handle chunks of the run of the SymParallelWorker pvWorker, from its
+   own deque and then from the others', until none is left. Every chunk
+   is taken by one thread, so a thread that finds all the deques empty
+   may stop while others still work. Return NULL. */
+static void *SymParallel_work(void *pvWorker)
+{
+    struct SymParallelWorker *psWorker =
+        (struct SymParallelWorker *)pvWorker;
+    struct SymParallelRun *psRun;
+    size_t uChunk;
+    size_t uBegin;
+    size_t uEnd;
+
+    assert(psWorker != NULL);
+
+    psRun = psWorker->psRun;
+    do {
+        while (SymParallel_take(&psRun->asDeques[psWorker->uIndex],
+            &uChunk)) {
+            uBegin = uChunk * uChunkItems;
+            uEnd = psRun->uItemCount - uBegin < uChunkItems ?
+                psRun->uItemCount : uBegin + uChunkItems;
+            (*psRun->pfRange)(uBegin, uEnd, psRun->pvExtra);
+        }
+    } while (SymParallel_steal(psRun, psWorker->uIndex));
+    return NULL;
+}
+
+
+void SymParallel_run(size_t uItemCount,
+    void (*pfRange)(size_t uBegin, size_t uEnd, void *pvExtra),
+    void *pvExtra, size_t uThreadCount)
+{
+    struct SymParallelRun sRun;
+    struct SymParallelWorker *asWorkers;
+    size_t uLocked;
+    size_t uShare;
+    size_t uExtra;
+    size_t i;
+
+    assert(pfRange != NULL);
+
+    if (uItemCount == 0)
+        return;
+
+    sRun.uItemCount = uItemCount;
+    sRun.uChunkCount = (uItemCount - 1) / uChunkItems + 1;
+    sRun.pfRange = pfRange;
+    sRun.pvExtra = pvExtra;
+
+    /* a thread without a chunk of its own would only steal */
+    sRun.uWorkerCount = uThreadCount < sRun.uChunkCount ?
+        uThreadCount : sRun.uChunkCount;
+    if (sRun.uWorkerCount <= 1) {
+        (*pfRange)(0, uItemCount, pvExtra);
+        return;
+    }
+
+    sRun.asDeques = (struct SymParallelDeque *)
+        calloc(sRun.uWorkerCount, sizeof(struct SymParallelDeque));
+    asWorkers = (struct SymParallelWorker *)
+        calloc(sRun.uWorkerCount, sizeof(struct SymParallelWorker));
+    for (uLocked = 0; sRun.asDeques != NULL && asWorkers != NULL &&
+        uLocked < sRun.uWorkerCount; uLocked++)
+        if (pthread_mutex_init(&sRun.asDeques[uLocked].sLock, NULL) != 0)
+            break;
+    if (uLocked < sRun.uWorkerCount) {
+        for (i = 0; i < uLocked; i++)
+            (void)pthread_mutex_destroy(&sRun.asDeques[i].sLock);
+        free(sRun.asDeques);
+        free(asWorkers);
+        (*pfRange)(0, uItemCount, pvExtra);
+        return;
+    }
+
+    /* deal the chunks out in contiguous runs, so that each thread
+    starts on memory of its own */
+    uShare = sRun.uChunkCount / sRun.uWorkerCount;
+    uExtra = sRun.uChunkCount % sRun.uWorkerCount;
+    for (i = 0; i < sRun.uWorkerCount; i++) {
+        sRun.asDeques[i].uNext = uShare * i + (i < uExtra ? i : uExtra);
+        sRun.asDeques[i].uEnd =
+            sRun.asDeques[i].uNext + uShare + (i < uExtra);
+        asWorkers[i].psRun = &sRun;
+        asWorkers[i].uIndex = i;
+    }
+
+    /* a thread that cannot start leaves its chunks to be stolen */
+    for (i = 1; i < sRun.uWorkerCount; i++)
+        asWorkers[i].iStarted = pthread_create(&asWorkers[i].sThread,
+            NULL, SymParallel_work, &asWorkers[i]) == 0;
+    (void)SymParallel_work(&asWorkers[0]);
+    for (i = 1; i < sRun.uWorkerCount; i++)
+        if (asWorkers[i].iStarted)
+            (void)pthread_join(asWorkers[i].sThread, NULL);
+
+    for (i = 0; i < sRun.uWorkerCount; i++)
+        (void)pthread_mutex_destroy(&sRun.asDeques[i].sLock);
+    free(sRun.asDeques);
+    free(asWorkers);
+}
+
+
+size_t SymParallel_threadCount(void)
+{
+    long lCount;
+
+    lCount = sysconf(_SC_NPROCESSORS_ONLN);
+    return lCount < 1 ? 1 : (size_t)lCount;
+}
@@ -0,0 +1,30 @@
+/*
+symparallel.h
+Author: David Wang
+*/
+
+#ifndef SYMPARALLEL_INCLUDED
+#define SYMPARALLEL_INCLUDED
+#include <stddef.h>
+
+/*
+Call *pfRange on ranges [uBegin, uEnd) of the items 0 through
+uItemCount - 1, passing pvExtra, so that each item is in exactly one
+range, on up to uThreadCount threads at once, the calling thread among
+them. The items are split into chunks, dealt out evenly; a thread that
+runs out takes half of the chunks that another has not yet started.
+Return once every range has been handled. If threads cannot be
+started, or insufficient memory is available, fewer threads, or the
+calling thread alone, handle every range.
+*/
+void SymParallel_run(size_t uItemCount,
+    void (*pfRange)(size_t uBegin, size_t uEnd, void *pvExtra),
+    void *pvExtra, size_t uThreadCount);
+
+/*
+Return the number of processors online, or 1 if it cannot be
+determined.
+*/
+size_t SymParallel_threadCount(void);
+
+#endif
@@ -6,15 +6,35 @@ author: David Wang
 #ifndef SYMTABLE_INCLUDED
 #define SYMTABLE_INCLUDED
 #include <stddef.h>
+#include <stdint.h>
 
 /* SymTable_T is an unordered collection of key-value bindings with 
 no NULL or duplicate keys */
 typedef struct SymTable* SymTable_T;
 
+/* SymTable_Hash_T is the opaque hash code of a key. It depends only
+on the key, so one hash code may be used with any number of
+SymTable_T objects. */
+typedef uint64_t SymTable_Hash_T;
+
 /* Return a new SymTable_T object that contains no 
 bindings, or NULL if insufficient memory is available. */
 SymTable_T SymTable_new(void);
 
+/* Return a new SymTable_T object that contains no bindings and has
+room for uCapacity bindings, or NULL if insufficient memory is
+available. */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity);
+
+/*
+Make room in oSymTable for uCapacity bindings in all, so that adding
+bindings until it contains that many does not make it grow again, and
+return 1 (TRUE). If insufficient memory is available, leave oSymTable
+unchanged and return 0 (FALSE). Removing bindings may give the room
+back.
+*/
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity);
+
 /* Free all memory occupied by oSymTable. */
 void SymTable_free(SymTable_T oSymTable);
 
@@ -32,6 +52,29 @@ leave oSymTable unchanged and return 0 (FALSE).
 int SymTable_put(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue);
 
+/*
+Put the binding of apcKeys[i] to apvValues[i] into oSymTable as
+SymTable_put would, for each i from 0 to uCount-1 in turn, and store
+the result of each in aiResults[i] unless aiResults is NULL. Return
+the number of bindings added. Where it helps, oSymTable first makes
+room for all uCount bindings and works on several keys at a time.
+*/
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+    const void **apvValues, size_t uCount, int *aiResults);
+
+/*
+If oSymTable contains a binding with key pcKey, set *piInserted to
+0 (FALSE). Otherwise add a new binding to oSymTable consisting of
+key pcKey and value pvDefault, and set *piInserted to 1 (TRUE).
+Either way, return the address of the binding's value, through which
+the value may be read or replaced. The address is valid only until
+the next call that adds a binding to or removes a binding from
+oSymTable. If insufficient memory is available, leave oSymTable
+unchanged, set *piInserted to 0 (FALSE), and return NULL.
+*/
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvDefault, int *piInserted);
+
 /* 
 If oSymTable contains a binding with key pcKey,
 replace the binding's value with pvValue and return the old value. 
@@ -52,6 +95,15 @@ whose key is pcKey, or NULL if no such binding exists.
 */
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey);
 
+/*
+Store in apvOut[i] the value that SymTable_get would return for
+apcKeys[i], for each i from 0 to uCount-1. Where it helps, oSymTable
+keeps several of the lookups in progress at once, so that their waits
+for memory overlap.
+*/
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+    size_t uCount, void **apvOut);
+
 /*
 If oSymTable contains a binding with key pcKey, 
 remove that binding from oSymTable and return the binding's value. 
@@ -59,9 +111,61 @@ Otherwise, do not change oSymTable and return NULL.
 */
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey);
 
+/* Return the hash code of pcKey, for use with the SymTable_*Hashed
+functions. */
+SymTable_Hash_T SymTable_hashKey(const char *pcKey);
+
+/*
+SymTable_putHashed, SymTable_getHashed and SymTable_removeHashed
+behave as SymTable_put, SymTable_get and SymTable_remove, but take
+uHash, normally the value SymTable_hashKey returns for pcKey,
+instead of hashing pcKey again. A binding added with any other hash
+code is found by SymTable_getHashed and SymTable_removeHashed with
+that same hash code; whether any other function finds it depends on
+the implementation.
+*/
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash, const void *pvValue);
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash);
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash);
+
+/*
+SymTable_putN, SymTable_containsN, SymTable_getN and SymTable_removeN
+behave as SymTable_put, SymTable_contains, SymTable_get and
+SymTable_remove, but take a key of uKeyLength bytes at pvKey, which
+need not be '\0'-terminated and may contain '\0' bytes. A key of
+uKeyLength bytes and a string of uKeyLength characters with the same
+contents name the same binding.
+*/
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength, const void *pvValue);
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength);
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength);
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength);
+
+/*
+Give back as much as possible of the memory that oSymTable holds
+beyond what its bindings need. The bindings are unchanged, but an
+address returned by SymTable_findOrInsert is no longer valid. If
+insufficient memory is available to rearrange oSymTable, leave it as
+it is.
+*/
+void SymTable_shrinkToFit(SymTable_T oSymTable);
+
 /*
 Apply function *pfApply to each binding in oSymTable, 
-passing pvExtra as an extra parameter.
+passing pvExtra as an extra parameter. Each key is passed
+'\0'-terminated, so a key containing '\0' bytes appears truncated.
 */
 void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
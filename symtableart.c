@@ -0,0 +1,1648 @@
+/*
+symtableart.c
+Author: David Wang
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "symtable.h"
+#include "symtableordered.h"
+#include "symhash.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+
+/* kinds of inner node, by the most children they can hold */
+enum {NODE4, NODE16, NODE48, NODE256};
+
+/* the number of bytes of a compressed path that a node stores; the
+rest of a longer path is read from any leaf below the node */
+enum {MAX_PREFIX_LENGTH = 8};
+
+/* a node is replaced by the next smaller kind once it has no more
+children than this */
+static const unsigned uNode16ShrinkCount = 3;
+static const unsigned uNode48ShrinkCount = 12;
+static const unsigned uNode256ShrinkCount = 37;
+
+/* Each binding is stored in a SymTableLeaf. A leaf and the defensive
+   copy of its key are a single allocation. */
+struct SymTableLeaf
+{
+    /* pointer to the value. */
+    const void *pvValue;
+
+    /* length of the key in bytes, not counting the '\0' that ends
+    the copy */
+    size_t uKeyLength;
+
+    /* defensive copy of the key, stored inline and '\0'-terminated */
+    char acKey[];
+};
+
+
+/* The leaves hang from a tree of inner nodes, each of which branches
+   on one byte of the key. A node whose children all share the next
+   few bytes stores them once, as a compressed path, instead of
+   having a chain of one-child nodes. A child pointer with its low bit
+   set points to a leaf, and otherwise to an inner node, whose kind
+   grows and shrinks with its number of children. Every inner node
+   starts with a SymTableNode. */
+struct SymTableNode
+{
+    /* NODE4, NODE16, NODE48 or NODE256 */
+    unsigned char ucType;
+
+    /* number of children, not counting psLeaf */
+    unsigned short uChildCount;
+
+    /* length of the compressed path, of which the first
+    MAX_PREFIX_LENGTH bytes are stored in aucPrefix */
+    size_t uPrefixLength;
+    unsigned char aucPrefix[MAX_PREFIX_LENGTH];
+
+    /* the leaf whose key ends where the compressed path ends, or
+    NULL; its key is a prefix of every key below the node */
+    struct SymTableLeaf *psLeaf;
+};
+
+/* up to 4 children, with their bytes in ascending order */
+struct SymTableNode4
+{
+    struct SymTableNode sHeader;
+    unsigned char aucBytes[4];
+    void *apvChildren[4];
+};
+
+/* up to 16 children, with their bytes in ascending order */
+struct SymTableNode16
+{
+    struct SymTableNode sHeader;
+    unsigned char aucBytes[16];
+    void *apvChildren[16];
+};
+
+/* up to 48 children; aucChildIndex[c] is 1 plus the index in
+apvChildren of the child for byte c, or 0 if there is none */
+struct SymTableNode48
+{
+    struct SymTableNode sHeader;
+    unsigned char aucChildIndex[256];
+    void *apvChildren[48];
+};
+
+/* a child for every byte, or NULL */
+struct SymTableNode256
+{
+    struct SymTableNode sHeader;
+    void *apvChildren[256];
+};
+
+
+/* A SymTable points to the root of the tree. */
+struct SymTable
+{
+    /* The root: a leaf, an inner node, or NULL if the SymTable is
+    empty */
+    void *pvRoot;
+
+    /* The number of bindings in the SymTable */
+    size_t length;
+};
+
+
+/* Return 1 (TRUE) if the child pointer pvChild points to a leaf, and
+   0 (FALSE) if it points to an inner node. */
+static int SymTable_isLeaf(const void *pvChild)
+{
+    return ((uintptr_t)pvChild & 1) != 0;
+}
+
+
+/* Return the leaf that the child pointer pvChild points to. */
+static struct SymTableLeaf *SymTable_toLeaf(const void *pvChild)
+{
+    assert(SymTable_isLeaf(pvChild));
+
+    return (struct SymTableLeaf *)((uintptr_t)pvChild - 1);
+}
+
+
+/* Return a child pointer to psLeaf. */
+static void *SymTable_fromLeaf(struct SymTableLeaf *psLeaf)
+{
+    assert(psLeaf != NULL);
+
+    return (void *)((uintptr_t)psLeaf | 1);
+}
+
+
+/* Return a negative number, 0, or a positive number according to
+   whether the key of psLeaf orders before, with, or after the key of
+   uKeyLength bytes at pcKey. */
+static int SymTable_compare(const struct SymTableLeaf *psLeaf,
+    const char *pcKey, size_t uKeyLength)
+{
+    int iCompare;
+
+    assert(psLeaf != NULL);
+    assert(pcKey != NULL);
+
+    iCompare = memcmp(psLeaf->acKey, pcKey,
+        psLeaf->uKeyLength < uKeyLength ? psLeaf->uKeyLength : uKeyLength);
+    if (iCompare != 0)
+        return iCompare;
+    return (psLeaf->uKeyLength > uKeyLength) -
+        (psLeaf->uKeyLength < uKeyLength);
+}
+
+
+/* Return 1 (TRUE) if the key of psLeaf is the uKeyLength bytes at
+   pcKey, and 0 (FALSE) otherwise. */
+static int SymTable_leafMatches(const struct SymTableLeaf *psLeaf,
+    const char *pcKey, size_t uKeyLength)
+{
+    assert(psLeaf != NULL);
+    assert(pcKey != NULL);
+
+    return psLeaf->uKeyLength == uKeyLength &&
+        memcmp(psLeaf->acKey, pcKey, uKeyLength) == 0;
+}
+
+
+/* Return a new leaf binding a copy of the uKeyLength bytes at pcKey
+   to pvValue, or NULL if insufficient memory is available. */
+static struct SymTableLeaf *SymTable_newLeaf(const char *pcKey,
+    size_t uKeyLength, const void *pvValue)
+{
+    struct SymTableLeaf *psLeaf;
+
+    assert(pcKey != NULL);
+
+    psLeaf = (struct SymTableLeaf *)
+        malloc(sizeof(struct SymTableLeaf) + uKeyLength + 1);
+    if (psLeaf == NULL)
+        return NULL;
+
+    /* create defensive copy of key, which need not end in '\0' */
+    memcpy(psLeaf->acKey, pcKey, uKeyLength);
+    psLeaf->acKey[uKeyLength] = '\0';
+    psLeaf->uKeyLength = uKeyLength;
+    psLeaf->pvValue = pvValue;
+    return psLeaf;
+}
+
+
+/* Return a new inner node of kind ucType with no children, no
+   compressed path and no leaf, or NULL if insufficient memory is
+   available. */
+static struct SymTableNode *SymTable_newNode(unsigned char ucType)
+{
+    static const size_t auNodeSizes[] = {
+        sizeof(struct SymTableNode4), sizeof(struct SymTableNode16),
+        sizeof(struct SymTableNode48), sizeof(struct SymTableNode256)};
+    struct SymTableNode *psNode;
+
+    /* calloc leaves every child pointer NULL and every index 0 */
+    psNode = (struct SymTableNode *)calloc(1, auNodeSizes[ucType]);
+    if (psNode == NULL)
+        return NULL;
+    psNode->ucType = ucType;
+    return psNode;
+}
+
+
+/* Copy everything but the kind and the children from the header of
+   psFrom to the header of psTo. */
+static void SymTable_copyHeader(struct SymTableNode *psTo,
+    const struct SymTableNode *psFrom)
+{
+    assert(psTo != NULL);
+    assert(psFrom != NULL);
+
+    psTo->uChildCount = psFrom->uChildCount;
+    psTo->uPrefixLength = psFrom->uPrefixLength;
+    memcpy(psTo->aucPrefix, psFrom->aucPrefix, MAX_PREFIX_LENGTH);
+    psTo->psLeaf = psFrom->psLeaf;
+}
+
+
+/* Return the address of the child pointer of psNode for byte ucByte,
+   or NULL if psNode has no such child. */
+static void **SymTable_findChild(struct SymTableNode *psNode,
+    unsigned char ucByte)
+{
+    struct SymTableNode4 *ps4;
+    struct SymTableNode16 *ps16;
+    struct SymTableNode48 *ps48;
+    struct SymTableNode256 *ps256;
+    unsigned i;
+#if defined(__SSE2__)
+    unsigned uMask;
+#endif
+
+    assert(psNode != NULL);
+
+    switch (psNode->ucType) {
+    case NODE4:
+        ps4 = (struct SymTableNode4 *)psNode;
+        for (i = 0; i < psNode->uChildCount; i++)
+            if (ps4->aucBytes[i] == ucByte)
+                return &ps4->apvChildren[i];
+        return NULL;
+    case NODE16:
+        ps16 = (struct SymTableNode16 *)psNode;
+#if defined(__SSE2__)
+        /* compare all 16 bytes at once */
+        uMask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+            _mm_set1_epi8((char)ucByte),
+            _mm_loadu_si128((const __m128i *)(void *)ps16->aucBytes)));
+        uMask &= (1u << psNode->uChildCount) - 1;
+        if (uMask == 0)
+            return NULL;
+        for (i = 0; (uMask & 1u) == 0; uMask >>= 1)
+            i++;
+        return &ps16->apvChildren[i];
+#else
+        for (i = 0; i < psNode->uChildCount; i++)
+            if (ps16->aucBytes[i] == ucByte)
+                return &ps16->apvChildren[i];
+        return NULL;
+#endif
+    case NODE48:
+        ps48 = (struct SymTableNode48 *)psNode;
+        if (ps48->aucChildIndex[ucByte] == 0)
+            return NULL;
+        return &ps48->apvChildren[ps48->aucChildIndex[ucByte] - 1];
+    default:
+        ps256 = (struct SymTableNode256 *)psNode;
+        if (ps256->apvChildren[ucByte] == NULL)
+            return NULL;
+        return &ps256->apvChildren[ucByte];
+    }
+}
+
+
+/* Find the child of psNode with the least byte greater than iByte,
+   which may be -1. If there is one, store its byte in *pucByte and its
+   child pointer in *ppvChild and return 1 (TRUE); otherwise return
+   0 (FALSE). */
+static int SymTable_childAfter(const struct SymTableNode *psNode,
+    int iByte, unsigned char *pucByte, void **ppvChild)
+{
+    const struct SymTableNode4 *ps4;
+    const struct SymTableNode16 *ps16;
+    const struct SymTableNode48 *ps48;
+    const struct SymTableNode256 *ps256;
+    unsigned i;
+    int c;
+
+    assert(psNode != NULL);
+    assert(pucByte != NULL);
+    assert(ppvChild != NULL);
+
+    switch (psNode->ucType) {
+    case NODE4:
+        ps4 = (const struct SymTableNode4 *)psNode;
+        for (i = 0; i < psNode->uChildCount; i++)
+            if ((int)ps4->aucBytes[i] > iByte) {
+                *pucByte = ps4->aucBytes[i];
+                *ppvChild = ps4->apvChildren[i];
+                return 1;
+            }
+        return 0;
+    case NODE16:
+        ps16 = (const struct SymTableNode16 *)psNode;
+        for (i = 0; i < psNode->uChildCount; i++)
+            if ((int)ps16->aucBytes[i] > iByte) {
+                *pucByte = ps16->aucBytes[i];
+                *ppvChild = ps16->apvChildren[i];
+                return 1;
+            }
+        return 0;
+    case NODE48:
+        ps48 = (const struct SymTableNode48 *)psNode;
+        for (c = iByte + 1; c < 256; c++)
+            if (ps48->aucChildIndex[c] != 0) {
+                *pucByte = (unsigned char)c;
+                *ppvChild = ps48->apvChildren[ps48->aucChildIndex[c] - 1];
+                return 1;
+            }
+        return 0;
+    default:
+        ps256 = (const struct SymTableNode256 *)psNode;
+        for (c = iByte + 1; c < 256; c++)
+            if (ps256->apvChildren[c] != NULL) {
+                *pucByte = (unsigned char)c;
+                *ppvChild = ps256->apvChildren[c];
+                return 1;
+            }
+        return 0;
+    }
+}
+
+
+/* Find the child of psNode with the greatest byte less than iByte,
+   which may be 256. If there is one, store its byte in *pucByte and
+   its child pointer in *ppvChild and return 1 (TRUE); otherwise return
+   0 (FALSE). */
+static int SymTable_childBefore(const struct SymTableNode *psNode,
+    int iByte, unsigned char *pucByte, void **ppvChild)
+{
+    const struct SymTableNode4 *ps4;
+    const struct SymTableNode16 *ps16;
+    const struct SymTableNode48 *ps48;
+    const struct SymTableNode256 *ps256;
+    int i;
+    int c;
+
+    assert(psNode != NULL);
+    assert(pucByte != NULL);
+    assert(ppvChild != NULL);
+
+    switch (psNode->ucType) {
+    case NODE4:
+        ps4 = (const struct SymTableNode4 *)psNode;
+        for (i = (int)psNode->uChildCount - 1; i >= 0; i--)
+            if ((int)ps4->aucBytes[i] < iByte) {
+                *pucByte = ps4->aucBytes[i];
+                *ppvChild = ps4->apvChildren[i];
+                return 1;
+            }
+        return 0;
+    case NODE16:
+        ps16 = (const struct SymTableNode16 *)psNode;
+        for (i = (int)psNode->uChildCount - 1; i >= 0; i--)
+            if ((int)ps16->aucBytes[i] < iByte) {
+                *pucByte = ps16->aucBytes[i];
+                *ppvChild = ps16->apvChildren[i];
+                return 1;
+            }
+        return 0;
+    case NODE48:
+        ps48 = (const struct SymTableNode48 *)psNode;
+        for (c = iByte - 1; c >= 0; c--)
+            if (ps48->aucChildIndex[c] != 0) {
+                *pucByte = (unsigned char)c;
+                *ppvChild = ps48->apvChildren[ps48->aucChildIndex[c] - 1];
+                return 1;
+            }
+        return 0;
+    default:
+        ps256 = (const struct SymTableNode256 *)psNode;
+        for (c = iByte - 1; c >= 0; c--)
+            if (ps256->apvChildren[c] != NULL) {
+                *pucByte = (unsigned char)c;
+                *ppvChild = ps256->apvChildren[c];
+                return 1;
+            }
+        return 0;
+    }
+}
+
+
+/* Return the leaf with the least key in the subtree pvChild, which
+   must not be empty. */
+static struct SymTableLeaf *SymTable_minimumLeaf(const void *pvChild)
+{
+    const struct SymTableNode *psNode;
+    unsigned char ucByte;
+    void *pvNext;
+
+    assert(pvChild != NULL);
+
+    while (! SymTable_isLeaf(pvChild)) {
+        psNode = (const struct SymTableNode *)pvChild;
+        /* a node's own leaf orders before everything below it */
+        if (psNode->psLeaf != NULL)
+            return psNode->psLeaf;
+        if (! SymTable_childAfter(psNode, -1, &ucByte, &pvNext))
+            assert(0);
+        pvChild = pvNext;
+    }
+    return SymTable_toLeaf(pvChild);
+}
+
+
+/* Return the leaf with the greatest key in the subtree pvChild,
+   which must not be empty. */
+static struct SymTableLeaf *SymTable_maximumLeaf(const void *pvChild)
+{
+    const struct SymTableNode *psNode;
+    unsigned char ucByte;
+    void *pvNext;
+
+    assert(pvChild != NULL);
+
+    while (! SymTable_isLeaf(pvChild)) {
+        psNode = (const struct SymTableNode *)pvChild;
+        if (! SymTable_childBefore(psNode, 256, &ucByte, &pvNext))
+            return psNode->psLeaf;
+        pvChild = pvNext;
+    }
+    return SymTable_toLeaf(pvChild);
+}
+
+
+/* Return 1 (TRUE) if the stored bytes of the compressed path of
+   psNode, which starts at depth uDepth, agree with the key of
+   uKeyLength bytes at pcKey, and 0 (FALSE) otherwise. Bytes beyond
+   the stored ones are not checked; a search checks them when it
+   compares the key with a leaf. */
+static int SymTable_checkPrefix(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uKeyLength, size_t uDepth)
+{
+    size_t uCount;
+
+    assert(psNode != NULL);
+    assert(pcKey != NULL);
+
+    uCount = psNode->uPrefixLength;
+    if (uCount > MAX_PREFIX_LENGTH)
+        uCount = MAX_PREFIX_LENGTH;
+    if (uCount > uKeyLength - uDepth)
+        return 0;
+    return memcmp(psNode->aucPrefix, pcKey + uDepth, uCount) == 0;
+}
+
+
+/* Return how many bytes of the compressed path of psNode, which
+   starts at depth uDepth, agree with the key of uKeyLength bytes at
+   pcKey, which must be at least uDepth bytes long. Bytes beyond the
+   stored ones are read from a leaf below psNode. */
+static size_t SymTable_prefixMatch(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uKeyLength, size_t uDepth)
+{
+    const struct SymTableLeaf *psLeaf;
+    size_t uMax;
+    size_t i;
+
+    assert(psNode != NULL);
+    assert(pcKey != NULL);
+    assert(uDepth <= uKeyLength);
+
+    uMax = psNode->uPrefixLength;
+    if (uMax > uKeyLength - uDepth)
+        uMax = uKeyLength - uDepth;
+
+    for (i = 0; i < uMax && i < MAX_PREFIX_LENGTH; i++)
+        if (psNode->aucPrefix[i] != (unsigned char)pcKey[uDepth + i])
+            return i;
+    if (i == uMax)
+        return i;
+
+    /* every leaf below psNode has the whole path in its key */
+    psLeaf = SymTable_minimumLeaf(psNode);
+    for (; i < uMax; i++)
+        if (psLeaf->acKey[uDepth + i] != pcKey[uDepth + i])
+            return i;
+    return i;
+}
+
+
+/* Add pvChild to psNode, which must not have a child for byte ucByte,
+   as its child for ucByte. If psNode is full, first replace it, at
+   *ppvRef, with a copy of the next larger kind. Return 1 (TRUE) if
+   successful, or 0 (FALSE) if insufficient memory is available, in
+   which case psNode is unchanged. */
+static int SymTable_addChild(void **ppvRef, struct SymTableNode *psNode,
+    unsigned char ucByte, void *pvChild)
+{
+    struct SymTableNode4 *ps4;
+    struct SymTableNode16 *ps16;
+    struct SymTableNode48 *ps48;
+    struct SymTableNode256 *ps256;
+    struct SymTableNode *psGrown;
+    unsigned i;
+    unsigned uPos;
+    int c;
+
+    assert(ppvRef != NULL);
+    assert(psNode != NULL);
+    assert(pvChild != NULL);
+
+    switch (psNode->ucType) {
+    case NODE4:
+        ps4 = (struct SymTableNode4 *)psNode;
+        if (psNode->uChildCount < 4) {
+            /* keep the bytes in ascending order */
+            for (uPos = 0; uPos < psNode->uChildCount &&
+                ps4->aucBytes[uPos] < ucByte; uPos++)
+                ;
+            memmove(&ps4->aucBytes[uPos + 1], &ps4->aucBytes[uPos],
+                psNode->uChildCount - uPos);
+            memmove(&ps4->apvChildren[uPos + 1], &ps4->apvChildren[uPos],
+                (psNode->uChildCount - uPos) * sizeof(void *));
+            ps4->aucBytes[uPos] = ucByte;
+            ps4->apvChildren[uPos] = pvChild;
+            psNode->uChildCount++;
+            return 1;
+        }
+        psGrown = SymTable_newNode(NODE16);
+        if (psGrown == NULL)
+            return 0;
+        ps16 = (struct SymTableNode16 *)psGrown;
+        memcpy(ps16->aucBytes, ps4->aucBytes, 4);
+        memcpy(ps16->apvChildren, ps4->apvChildren, 4 * sizeof(void *));
+        break;
+
+    case NODE16:
+        ps16 = (struct SymTableNode16 *)psNode;
+        if (psNode->uChildCount < 16) {
+            for (uPos = 0; uPos < psNode->uChildCount &&
+                ps16->aucBytes[uPos] < ucByte; uPos++)
+                ;
+            memmove(&ps16->aucBytes[uPos + 1], &ps16->aucBytes[uPos],
+                psNode->uChildCount - uPos);
+            memmove(&ps16->apvChildren[uPos + 1],
+                &ps16->apvChildren[uPos],
+                (psNode->uChildCount - uPos) * sizeof(void *));
+            ps16->aucBytes[uPos] = ucByte;
+            ps16->apvChildren[uPos] = pvChild;
+            psNode->uChildCount++;
+            return 1;
+        }
+        psGrown = SymTable_newNode(NODE48);
+        if (psGrown == NULL)
+            return 0;
+        ps48 = (struct SymTableNode48 *)psGrown;
+        for (i = 0; i < 16; i++) {
+            ps48->aucChildIndex[ps16->aucBytes[i]] = (unsigned char)(i + 1);
+            ps48->apvChildren[i] = ps16->apvChildren[i];
+        }
+        break;
+
+    case NODE48:
+        ps48 = (struct SymTableNode48 *)psNode;
+        if (psNode->uChildCount < 48) {
+            /* a removal may have left a hole anywhere */
+            for (uPos = 0; ps48->apvChildren[uPos] != NULL; uPos++)
+                ;
+            ps48->apvChildren[uPos] = pvChild;
+            ps48->aucChildIndex[ucByte] = (unsigned char)(uPos + 1);
+            psNode->uChildCount++;
+            return 1;
+        }
+        psGrown = SymTable_newNode(NODE256);
+        if (psGrown == NULL)
+            return 0;
+        ps256 = (struct SymTableNode256 *)psGrown;
+        for (c = 0; c < 256; c++)
+            if (ps48->aucChildIndex[c] != 0)
+                ps256->apvChildren[c] =
+                    ps48->apvChildren[ps48->aucChildIndex[c] - 1];
+        break;
+
+    default:
+        ps256 = (struct SymTableNode256 *)psNode;
+        ps256->apvChildren[ucByte] = pvChild;
+        psNode->uChildCount++;
+        return 1;
+    }
+
+    /* the larger copy replaces psNode and has room for the child */
+    SymTable_copyHeader(psGrown, psNode);
+    *ppvRef = psGrown;
+    free(psNode);
+    return SymTable_addChild(ppvRef, psGrown, ucByte, pvChild);
+}
+
+
+/* Remove the child of psNode for byte ucByte, which must exist. */
+static void SymTable_removeChild(struct SymTableNode *psNode,
+    unsigned char ucByte)
+{
+    struct SymTableNode4 *ps4;
+    struct SymTableNode16 *ps16;
+    struct SymTableNode48 *ps48;
+    struct SymTableNode256 *ps256;
+    unsigned uPos;
+
+    assert(psNode != NULL);
+
+    switch (psNode->ucType) {
+    case NODE4:
+        ps4 = (struct SymTableNode4 *)psNode;
+        for (uPos = 0; ps4->aucBytes[uPos] != ucByte; uPos++)
+            ;
+        memmove(&ps4->aucBytes[uPos], &ps4->aucBytes[uPos + 1],
+            psNode->uChildCount - uPos - 1);
+        memmove(&ps4->apvChildren[uPos], &ps4->apvChildren[uPos + 1],
+            (psNode->uChildCount - uPos - 1) * sizeof(void *));
+        break;
+    case NODE16:
+        ps16 = (struct SymTableNode16 *)psNode;
+        for (uPos = 0; ps16->aucBytes[uPos] != ucByte; uPos++)
+            ;
+        memmove(&ps16->aucBytes[uPos], &ps16->aucBytes[uPos + 1],
+            psNode->uChildCount - uPos - 1);
+        memmove(&ps16->apvChildren[uPos], &ps16->apvChildren[uPos + 1],
+            (psNode->uChildCount - uPos - 1) * sizeof(void *));
+        break;
+    case NODE48:
+        ps48 = (struct SymTableNode48 *)psNode;
+        ps48->apvChildren[ps48->aucChildIndex[ucByte] - 1] = NULL;
+        ps48->aucChildIndex[ucByte] = 0;
+        break;
+    default:
+        ps256 = (struct SymTableNode256 *)psNode;
+        ps256->apvChildren[ucByte] = NULL;
+        break;
+    }
+    psNode->uChildCount--;
+}
+
+
+/* Return a copy of psNode of the next smaller kind, or NULL if
+   insufficient memory is available. psNode must have few enough
+   children to fit. */
+static struct SymTableNode *SymTable_shrunkCopy(
+    const struct SymTableNode *psNode)
+{
+    static const unsigned char aucSmallerType[] = {
+        NODE4, NODE4, NODE16, NODE48};
+    struct SymTableNode *psShrunk;
+    struct SymTableNode4 *ps4;
+    struct SymTableNode16 *ps16;
+    struct SymTableNode48 *ps48;
+    unsigned char ucByte;
+    void *pvChild;
+    int iByte;
+    unsigned i = 0;
+
+    assert(psNode != NULL);
+    assert(psNode->ucType != NODE4);
+
+    psShrunk = SymTable_newNode(aucSmallerType[psNode->ucType]);
+    if (psShrunk == NULL)
+        return NULL;
+    SymTable_copyHeader(psShrunk, psNode);
+
+    /* visiting the children in byte order keeps the bytes of a
+    NODE4 or NODE16 sorted */
+    for (iByte = -1;
+        SymTable_childAfter(psNode, iByte, &ucByte, &pvChild);
+        iByte = ucByte, i++)
+    {
+        switch (psShrunk->ucType) {
+        case NODE4:
+            ps4 = (struct SymTableNode4 *)psShrunk;
+            ps4->aucBytes[i] = ucByte;
+            ps4->apvChildren[i] = pvChild;
+            break;
+        case NODE16:
+            ps16 = (struct SymTableNode16 *)psShrunk;
+            ps16->aucBytes[i] = ucByte;
+            ps16->apvChildren[i] = pvChild;
+            break;
+        default:
+            ps48 = (struct SymTableNode48 *)psShrunk;
+            ps48->aucChildIndex[ucByte] = (unsigned char)(i + 1);
+            ps48->apvChildren[i] = pvChild;
+            break;
+        }
+    }
+    return psShrunk;
+}
+
+
+/* Restore the shape of the inner node at *ppvRef after a child or its
+   leaf has been removed: replace a node left with only a leaf by the
+   leaf, merge a node left with one child and no leaf into the child,
+   and replace a node with few children by a smaller kind if memory
+   allows. */
+static void SymTable_shrinkNode(void **ppvRef)
+{
+    struct SymTableNode *psNode;
+    struct SymTableNode *psChild;
+    struct SymTableNode *psShrunk;
+    unsigned char aucPrefix[MAX_PREFIX_LENGTH];
+    unsigned char ucByte;
+    void *pvChild;
+    size_t uCount;
+    size_t uLength;
+
+    assert(ppvRef != NULL);
+
+    psNode = (struct SymTableNode *)*ppvRef;
+
+    if (psNode->uChildCount == 0) {
+        *ppvRef = psNode->psLeaf == NULL ? NULL :
+            SymTable_fromLeaf(psNode->psLeaf);
+        free(psNode);
+        return;
+    }
+
+    if (psNode->uChildCount == 1 && psNode->psLeaf == NULL) {
+        (void)SymTable_childAfter(psNode, -1, &ucByte, &pvChild);
+        if (! SymTable_isLeaf(pvChild)) {
+            /* the child's path becomes the node's path, then the
+            byte that led to the child, then the child's own path;
+            only the first MAX_PREFIX_LENGTH bytes are stored */
+            psChild = (struct SymTableNode *)pvChild;
+            uLength = psNode->uPrefixLength;
+            uCount = uLength < MAX_PREFIX_LENGTH ?
+                uLength : MAX_PREFIX_LENGTH;
+            memcpy(aucPrefix, psNode->aucPrefix, uCount);
+            if (uCount < MAX_PREFIX_LENGTH)
+                aucPrefix[uCount++] = ucByte;
+            if (uCount < MAX_PREFIX_LENGTH)
+                memcpy(&aucPrefix[uCount], psChild->aucPrefix,
+                    MAX_PREFIX_LENGTH - uCount);
+            memcpy(psChild->aucPrefix, aucPrefix, MAX_PREFIX_LENGTH);
+            psChild->uPrefixLength += uLength + 1;
+        }
+        *ppvRef = pvChild;
+        free(psNode);
+        return;
+    }
+
+    if ((psNode->ucType == NODE16 &&
+            psNode->uChildCount <= uNode16ShrinkCount) ||
+        (psNode->ucType == NODE48 &&
+            psNode->uChildCount <= uNode48ShrinkCount) ||
+        (psNode->ucType == NODE256 &&
+            psNode->uChildCount <= uNode256ShrinkCount)) {
+        /* a node that cannot be shrunk still works, so a failed
+        allocation is ignored */
+        psShrunk = SymTable_shrunkCopy(psNode);
+        if (psShrunk != NULL) {
+            *ppvRef = psShrunk;
+            free(psNode);
+        }
+    }
+}
+
+
+/* Free the subtree pvChild, which may be empty. */
+static void SymTable_freeSubtree(void *pvChild)
+{
+    struct SymTableNode *psNode;
+    unsigned char ucByte;
+    void *pvNext;
+    int iByte;
+
+    if (pvChild == NULL)
+        return;
+    if (SymTable_isLeaf(pvChild)) {
+        free(SymTable_toLeaf(pvChild));
+        return;
+    }
+
+    psNode = (struct SymTableNode *)pvChild;
+    free(psNode->psLeaf);
+    for (iByte = -1; SymTable_childAfter(psNode, iByte, &ucByte, &pvNext);
+        iByte = ucByte)
+        SymTable_freeSubtree(pvNext);
+    free(psNode);
+}
+
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    oSymTable->pvRoot = NULL;
+    oSymTable->length = 0;
+    return oSymTable;
+}
+
+
+/* the tree allocates its leaves and nodes as keys are added, so it
+has nothing to size in advance */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    (void)uCapacity;
+    return SymTable_new();
+}
+
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    SymTable_freeSubtree(oSymTable->pvRoot);
+    free(oSymTable);
+}
+
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    return oSymTable->length;
+}
+
+
+/*
+return a pointer to the SymTableLeaf in oSymTable whose key is the
+uKeyLength bytes at pcKey. If no matching key exists in the symbol
+table, return NULL.
+*/
+static struct SymTableLeaf *SymTable_getLeaf(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength)
+{
+    void *pvChild;
+    void **ppvChild;
+    struct SymTableNode *psNode;
+    size_t uDepth = 0;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    for (pvChild = oSymTable->pvRoot; pvChild != NULL; pvChild = *ppvChild)
+    {
+        if (SymTable_isLeaf(pvChild)) {
+            if (SymTable_leafMatches(SymTable_toLeaf(pvChild), pcKey,
+                uKeyLength))
+                return SymTable_toLeaf(pvChild);
+            return NULL;
+        }
+
+        /* skip the compressed path, checking only its stored bytes;
+        the full key is compared once, with the leaf found */
+        psNode = (struct SymTableNode *)pvChild;
+        if (psNode->uPrefixLength > 0) {
+            if (! SymTable_checkPrefix(psNode, pcKey, uKeyLength, uDepth))
+                return NULL;
+            uDepth += psNode->uPrefixLength;
+        }
+        if (uDepth >= uKeyLength) {
+            if (uDepth == uKeyLength && psNode->psLeaf != NULL &&
+                SymTable_leafMatches(psNode->psLeaf, pcKey, uKeyLength))
+                return psNode->psLeaf;
+            return NULL;
+        }
+
+        ppvChild = SymTable_findChild(psNode,
+            (unsigned char)pcKey[uDepth]);
+        if (ppvChild == NULL)
+            return NULL;
+        uDepth++;
+    }
+    return NULL;
+}
+
+
+/*
+Return the leaf of the subtree at *ppvRef, whose root is at depth
+uDepth, whose key is the uKeyLength bytes at pcKey, and set
+*piInserted to 0 (FALSE). If no such leaf exists, add one with value
+pvDefault, set *piInserted to 1 (TRUE), and return it. If insufficient
+memory is available, leave the subtree unchanged, set *piInserted to
+0 (FALSE), and return NULL.
+*/
+static struct SymTableLeaf *SymTable_insert(void **ppvRef,
+    const char *pcKey, size_t uKeyLength, size_t uDepth,
+    const void *pvDefault, int *piInserted)
+{
+    struct SymTableLeaf *psOldLeaf;
+    struct SymTableLeaf *psLeaf;
+    struct SymTableNode *psNode;
+    struct SymTableNode *psSplit;
+    void **ppvChild;
+    void *pvSplit;
+    size_t uMatched;
+    unsigned char ucByte;
+
+    assert(ppvRef != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+    assert(uDepth <= uKeyLength);
+
+    *piInserted = 0;
+
+    if (*ppvRef == NULL) {
+        psLeaf = SymTable_newLeaf(pcKey, uKeyLength, pvDefault);
+        if (psLeaf == NULL)
+            return NULL;
+        *ppvRef = SymTable_fromLeaf(psLeaf);
+        *piInserted = 1;
+        return psLeaf;
+    }
+
+    if (SymTable_isLeaf(*ppvRef)) {
+        psOldLeaf = SymTable_toLeaf(*ppvRef);
+        if (SymTable_leafMatches(psOldLeaf, pcKey, uKeyLength))
+            return psOldLeaf;
+
+        /* a new node holds both leaves below the bytes they share */
+        for (uMatched = 0; uDepth + uMatched < uKeyLength &&
+            uDepth + uMatched < psOldLeaf->uKeyLength &&
+            psOldLeaf->acKey[uDepth + uMatched] ==
+                pcKey[uDepth + uMatched]; uMatched++)
+            ;
+        psSplit = SymTable_newNode(NODE4);
+        if (psSplit == NULL)
+            return NULL;
+        psLeaf = SymTable_newLeaf(pcKey, uKeyLength, pvDefault);
+        if (psLeaf == NULL) {
+            free(psSplit);
+            return NULL;
+        }
+        psSplit->uPrefixLength = uMatched;
+        memcpy(psSplit->aucPrefix, pcKey + uDepth,
+            uMatched < MAX_PREFIX_LENGTH ? uMatched : MAX_PREFIX_LENGTH);
+        uDepth += uMatched;
+
+        /* a NODE4 has room for both, so neither addChild can fail */
+        pvSplit = psSplit;
+        if (psOldLeaf->uKeyLength == uDepth)
+            psSplit->psLeaf = psOldLeaf;
+        else
+            (void)SymTable_addChild(&pvSplit, psSplit,
+                (unsigned char)psOldLeaf->acKey[uDepth], *ppvRef);
+        if (uKeyLength == uDepth)
+            psSplit->psLeaf = psLeaf;
+        else
+            (void)SymTable_addChild(&pvSplit, psSplit,
+                (unsigned char)pcKey[uDepth], SymTable_fromLeaf(psLeaf));
+
+        *ppvRef = psSplit;
+        *piInserted = 1;
+        return psLeaf;
+    }
+
+    psNode = (struct SymTableNode *)*ppvRef;
+
+    if (psNode->uPrefixLength > 0) {
+        uMatched = SymTable_prefixMatch(psNode, pcKey, uKeyLength, uDepth);
+        if (uMatched < psNode->uPrefixLength) {
+            /* the key leaves the compressed path partway, so a new
+            node takes over the shared part of the path */
+            psSplit = SymTable_newNode(NODE4);
+            if (psSplit == NULL)
+                return NULL;
+            psLeaf = SymTable_newLeaf(pcKey, uKeyLength, pvDefault);
+            if (psLeaf == NULL) {
+                free(psSplit);
+                return NULL;
+            }
+            psSplit->uPrefixLength = uMatched;
+            memcpy(psSplit->aucPrefix, psNode->aucPrefix,
+                uMatched < MAX_PREFIX_LENGTH ? uMatched : MAX_PREFIX_LENGTH);
+
+            /* psNode keeps the part of its path after the byte at
+            which the key leaves it */
+            if (psNode->uPrefixLength <= MAX_PREFIX_LENGTH) {
+                ucByte = psNode->aucPrefix[uMatched];
+                psNode->uPrefixLength -= uMatched + 1;
+                memmove(psNode->aucPrefix,
+                    &psNode->aucPrefix[uMatched + 1],
+                    psNode->uPrefixLength);
+            }
+            else {
+                psOldLeaf = SymTable_minimumLeaf(psNode);
+                ucByte = (unsigned char)psOldLeaf->acKey[uDepth + uMatched];
+                psNode->uPrefixLength -= uMatched + 1;
+                memcpy(psNode->aucPrefix,
+                    &psOldLeaf->acKey[uDepth + uMatched + 1],
+                    psNode->uPrefixLength < MAX_PREFIX_LENGTH ?
+                        psNode->uPrefixLength : MAX_PREFIX_LENGTH);
+            }
+
+            pvSplit = psSplit;
+            (void)SymTable_addChild(&pvSplit, psSplit, ucByte, psNode);
+            if (uKeyLength == uDepth + uMatched)
+                psSplit->psLeaf = psLeaf;
+            else
+                (void)SymTable_addChild(&pvSplit, psSplit,
+                    (unsigned char)pcKey[uDepth + uMatched],
+                    SymTable_fromLeaf(psLeaf));
+
+            *ppvRef = psSplit;
+            *piInserted = 1;
+            return psLeaf;
+        }
+        uDepth += psNode->uPrefixLength;
+    }
+
+    /* the whole path has been compared, so a leaf ending here has
+    the key */
+    if (uDepth == uKeyLength) {
+        if (psNode->psLeaf != NULL)
+            return psNode->psLeaf;
+        psLeaf = SymTable_newLeaf(pcKey, uKeyLength, pvDefault);
+        if (psLeaf == NULL)
+            return NULL;
+        psNode->psLeaf = psLeaf;
+        *piInserted = 1;
+        return psLeaf;
+    }
+
+    ppvChild = SymTable_findChild(psNode, (unsigned char)pcKey[uDepth]);
+    if (ppvChild != NULL)
+        return SymTable_insert(ppvChild, pcKey, uKeyLength, uDepth + 1,
+            pvDefault, piInserted);
+
+    psLeaf = SymTable_newLeaf(pcKey, uKeyLength, pvDefault);
+    if (psLeaf == NULL)
+        return NULL;
+    if (! SymTable_addChild(ppvRef, psNode, (unsigned char)pcKey[uDepth],
+        SymTable_fromLeaf(psLeaf))) {
+        free(psLeaf);
+        return NULL;
+    }
+    *piInserted = 1;
+    return psLeaf;
+}
+
+
+/*
+Add a binding for the uKeyLength bytes at pcKey to oSymTable as
+SymTable_findOrInsert does, and return its leaf, or NULL if
+insufficient memory is available.
+*/
+static struct SymTableLeaf *SymTable_findOrInsertLeaf(
+    SymTable_T oSymTable, const char *pcKey, size_t uKeyLength,
+    const void *pvDefault, int *piInserted)
+{
+    struct SymTableLeaf *psLeaf;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    psLeaf = SymTable_insert(&oSymTable->pvRoot, pcKey, uKeyLength, 0,
+        pvDefault, piInserted);
+    /* increment length of SymTable */
+    if (*piInserted)
+        oSymTable->length += 1;
+    return psLeaf;
+}
+
+
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvDefault, int *piInserted)
+{
+    struct SymTableLeaf *psLeaf;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    psLeaf = SymTable_findOrInsertLeaf(oSymTable, pcKey, strlen(pcKey),
+        pvDefault, piInserted);
+    if (psLeaf == NULL)
+        return NULL;
+    return (void **) &psLeaf->pvValue;
+}
+
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+/* each insertion's path depends on the nodes the last one may have
+grown, so the batch is put one binding at a time */
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+    const void **apvValues, size_t uCount, int *aiResults)
+{
+    size_t i;
+    size_t uAdded = 0;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvValues != NULL);
+
+    for (i = 0; i < uCount; i++) {
+        iInserted = SymTable_put(oSymTable, apcKeys[i], apvValues[i]);
+        if (aiResults != NULL)
+            aiResults[i] = iInserted;
+        uAdded += (size_t)iInserted;
+    }
+    return uAdded;
+}
+
+
+SymTable_Hash_T SymTable_hashKey(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return SymHash_hash(pcKey, strlen(pcKey));
+}
+
+
+/* A radix tree branches on the key's bytes rather than hashing them,
+   so the SymTable_*Hashed functions ignore the hash code. */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash, const void *pvValue)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)uHash;
+    return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    struct SymTableLeaf *psLeaf;
+    const void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_getLeaf(oSymTable, pcKey, strlen(pcKey));
+    if (psLeaf == NULL)
+        return NULL;
+    pvOldValue = psLeaf->pvValue;
+    psLeaf->pvValue = pvValue;
+    return (void *) pvOldValue;
+}
+
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_getLeaf(oSymTable, pcKey, strlen(pcKey)) != NULL;
+}
+
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableLeaf *psLeaf;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_getLeaf(oSymTable, pcKey, strlen(pcKey));
+    if (psLeaf == NULL)
+        return NULL;
+    return (void *) psLeaf->pvValue;
+}
+
+
+/* each step of a search follows a child of the node the last step
+reached, so the batch is searched one key at a time */
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+    size_t uCount, void **apvOut)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvOut != NULL);
+
+    for (i = 0; i < uCount; i++)
+        apvOut[i] = SymTable_get(oSymTable, apcKeys[i]);
+}
+
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)uHash;
+    return SymTable_get(oSymTable, pcKey);
+}
+
+
+/*
+If the subtree at *ppvRef, whose root is at depth uDepth, has a leaf
+whose key is the uKeyLength bytes at pcKey, unlink that leaf and
+return it. Otherwise leave the subtree unchanged and return NULL.
+*/
+static struct SymTableLeaf *SymTable_removeLeaf(void **ppvRef,
+    const char *pcKey, size_t uKeyLength, size_t uDepth)
+{
+    struct SymTableNode *psNode;
+    struct SymTableLeaf *psLeaf;
+    void **ppvChild;
+    unsigned char ucByte;
+
+    assert(ppvRef != NULL);
+    assert(pcKey != NULL);
+
+    if (*ppvRef == NULL)
+        return NULL;
+
+    if (SymTable_isLeaf(*ppvRef)) {
+        psLeaf = SymTable_toLeaf(*ppvRef);
+        if (! SymTable_leafMatches(psLeaf, pcKey, uKeyLength))
+            return NULL;
+        *ppvRef = NULL;
+        return psLeaf;
+    }
+
+    psNode = (struct SymTableNode *)*ppvRef;
+    if (psNode->uPrefixLength > 0) {
+        if (! SymTable_checkPrefix(psNode, pcKey, uKeyLength, uDepth))
+            return NULL;
+        uDepth += psNode->uPrefixLength;
+    }
+    if (uDepth >= uKeyLength) {
+        psLeaf = psNode->psLeaf;
+        if (uDepth > uKeyLength || psLeaf == NULL ||
+            ! SymTable_leafMatches(psLeaf, pcKey, uKeyLength))
+            return NULL;
+        psNode->psLeaf = NULL;
+        SymTable_shrinkNode(ppvRef);
+        return psLeaf;
+    }
+
+    ucByte = (unsigned char)pcKey[uDepth];
+    ppvChild = SymTable_findChild(psNode, ucByte);
+    if (ppvChild == NULL)
+        return NULL;
+    psLeaf = SymTable_removeLeaf(ppvChild, pcKey, uKeyLength, uDepth + 1);
+
+    /* a child that was a leaf is now gone */
+    if (psLeaf != NULL && *ppvChild == NULL) {
+        SymTable_removeChild(psNode, ucByte);
+        SymTable_shrinkNode(ppvRef);
+    }
+    return psLeaf;
+}
+
+
+/*
+If oSymTable contains a binding whose key is the uKeyLength bytes at
+pcKey, remove that binding from oSymTable and return the binding's
+value. Otherwise, do not change oSymTable and return NULL.
+*/
+static void *SymTable_removeKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength)
+{
+    struct SymTableLeaf *psLeaf;
+    const void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_removeLeaf(&oSymTable->pvRoot, pcKey, uKeyLength, 0);
+    if (psLeaf == NULL)
+        return NULL;
+
+    pvValue = psLeaf->pvValue;
+    free(psLeaf);
+    /* decrement length of SymTable */
+    oSymTable->length -= 1;
+    return (void *) pvValue;
+}
+
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_removeKey(oSymTable, pcKey, strlen(pcKey));
+}
+
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)uHash;
+    return SymTable_remove(oSymTable, pcKey);
+}
+
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    (void)SymTable_findOrInsertLeaf(oSymTable, (const char *)pvKey,
+        uKeyLength, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_getLeaf(oSymTable, (const char *)pvKey, uKeyLength)
+        != NULL;
+}
+
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    struct SymTableLeaf *psLeaf;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    psLeaf = SymTable_getLeaf(oSymTable, (const char *)pvKey, uKeyLength);
+    if (psLeaf == NULL)
+        return NULL;
+    return (void *) psLeaf->pvValue;
+}
+
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_removeKey(oSymTable, (const char *)pvKey, uKeyLength);
+}
+
+
+/* Apply pfApply to each binding in the subtree pvChild, which may be
+   empty, in ascending key order, passing pvExtra as the extra
+   parameter. */
+static void SymTable_mapSubtree(const void *pvChild,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    const struct SymTableNode *psNode;
+    const struct SymTableLeaf *psLeaf;
+    unsigned char ucByte;
+    void *pvNext;
+    int iByte;
+
+    assert(pfApply != NULL);
+
+    if (pvChild == NULL)
+        return;
+    if (SymTable_isLeaf(pvChild)) {
+        psLeaf = SymTable_toLeaf(pvChild);
+        (*pfApply)(psLeaf->acKey, (void*)psLeaf->pvValue, (void*)pvExtra);
+        return;
+    }
+
+    psNode = (const struct SymTableNode *)pvChild;
+    if (psNode->psLeaf != NULL)
+        (*pfApply)(psNode->psLeaf->acKey, (void*)psNode->psLeaf->pvValue,
+            (void*)pvExtra);
+    for (iByte = -1; SymTable_childAfter(psNode, iByte, &ucByte, &pvNext);
+        iByte = ucByte)
+        SymTable_mapSubtree(pvNext, pfApply, pvExtra);
+}
+
+
+/* as for SymTable_newWithCapacity, there is nothing to size */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    assert(oSymTable != NULL);
+
+    (void)uCapacity;
+    return 1;
+}
+
+
+/* leaves are freed as soon as they are removed, and a removal that
+leaves a node underfull replaces it with a smaller one, so there is
+nothing to give back */
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+}
+
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    SymTable_mapSubtree(oSymTable->pvRoot, pfApply, pvExtra);
+}
+
+
+/* Apply pfApply to each binding in the subtree pvChild, which may be
+   empty, whose key is at least the uLoLength bytes at pcLo and at
+   most the uHiLength bytes at pcHi, in ascending key order, passing
+   pvExtra as the extra parameter. A NULL pcLo or pcHi leaves that end
+   of the range open. */
+static void SymTable_mapRangeIn(const void *pvChild,
+    const char *pcLo, size_t uLoLength,
+    const char *pcHi, size_t uHiLength,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    const struct SymTableNode *psNode;
+    const struct SymTableLeaf *psMin;
+    const struct SymTableLeaf *psMax;
+    unsigned char ucByte;
+    void *pvNext;
+    int iByte;
+
+    assert(pfApply != NULL);
+
+    if (pvChild == NULL)
+        return;
+
+    /* skip a subtree that lies outside the range, and map one that
+    lies inside it without further comparisons */
+    psMin = SymTable_minimumLeaf(pvChild);
+    psMax = SymTable_maximumLeaf(pvChild);
+    if ((pcLo != NULL && SymTable_compare(psMax, pcLo, uLoLength) < 0) ||
+        (pcHi != NULL && SymTable_compare(psMin, pcHi, uHiLength) > 0))
+        return;
+    if ((pcLo == NULL || SymTable_compare(psMin, pcLo, uLoLength) >= 0) &&
+        (pcHi == NULL || SymTable_compare(psMax, pcHi, uHiLength) <= 0)) {
+        SymTable_mapSubtree(pvChild, pfApply, pvExtra);
+        return;
+    }
+
+    /* a leaf is its own minimum and maximum, so only an inner node
+    can straddle an end of the range; its own leaf is its minimum */
+    psNode = (const struct SymTableNode *)pvChild;
+    if (psNode->psLeaf != NULL &&
+        (pcLo == NULL ||
+            SymTable_compare(psNode->psLeaf, pcLo, uLoLength) >= 0))
+        (*pfApply)(psNode->psLeaf->acKey, (void*)psNode->psLeaf->pvValue,
+            (void*)pvExtra);
+    for (iByte = -1; SymTable_childAfter(psNode, iByte, &ucByte, &pvNext);
+        iByte = ucByte)
+        SymTable_mapRangeIn(pvNext, pcLo, uLoLength, pcHi, uHiLength,
+            pfApply, pvExtra);
+}
+
+
+void SymTable_mapRange(SymTable_T oSymTable,
+    const char *pcLo, const char *pcHi,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    SymTable_mapRangeIn(oSymTable->pvRoot,
+        pcLo, pcLo == NULL ? 0 : strlen(pcLo),
+        pcHi, pcHi == NULL ? 0 : strlen(pcHi), pfApply, pvExtra);
+}
+
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    const void *pvChild;
+    void **ppvChild;
+    const struct SymTableNode *psNode;
+    const struct SymTableLeaf *psLeaf;
+    size_t uPrefixLength;
+    size_t uDepth = 0;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    uPrefixLength = strlen(pcPrefix);
+
+    /* descend to the smallest subtree whose keys all share the first
+    uPrefixLength bytes, branching on the bytes of pcPrefix */
+    pvChild = oSymTable->pvRoot;
+    while (pvChild != NULL && uDepth < uPrefixLength &&
+        ! SymTable_isLeaf(pvChild))
+    {
+        psNode = (const struct SymTableNode *)pvChild;
+        if (uDepth + psNode->uPrefixLength >= uPrefixLength)
+            break;
+        uDepth += psNode->uPrefixLength;
+        ppvChild = SymTable_findChild((struct SymTableNode *)psNode,
+            (unsigned char)pcPrefix[uDepth]);
+        if (ppvChild == NULL)
+            return;
+        pvChild = *ppvChild;
+        uDepth++;
+    }
+    if (pvChild == NULL)
+        return;
+
+    /* the compressed paths were skipped unchecked, but every key in
+    the subtree shares them, so checking one key checks them all */
+    psLeaf = SymTable_minimumLeaf(pvChild);
+    if (psLeaf->uKeyLength < uPrefixLength ||
+        memcmp(psLeaf->acKey, pcPrefix, uPrefixLength) != 0)
+        return;
+    SymTable_mapSubtree(pvChild, pfApply, pvExtra);
+}
+
+
+/* Return the leaf with the greatest key in the subtree pvChild, which
+   may be empty, that is at most the uKeyLength bytes at pcKey, or NULL
+   if there is none. */
+static const struct SymTableLeaf *SymTable_floorIn(const void *pvChild,
+    const char *pcKey, size_t uKeyLength)
+{
+    const struct SymTableNode *psNode;
+    const struct SymTableLeaf *psLeaf;
+    unsigned char ucByte;
+    void *pvNext;
+    int iByte;
+
+    if (pvChild == NULL ||
+        SymTable_compare(SymTable_minimumLeaf(pvChild), pcKey,
+            uKeyLength) > 0)
+        return NULL;
+    psLeaf = SymTable_maximumLeaf(pvChild);
+    if (SymTable_compare(psLeaf, pcKey, uKeyLength) <= 0)
+        return psLeaf;
+
+    /* only an inner node has a minimum and maximum on either side of
+    pcKey; the last child that starts at or below pcKey holds the
+    answer, or else the node's own leaf is it */
+    psNode = (const struct SymTableNode *)pvChild;
+    for (iByte = 256; SymTable_childBefore(psNode, iByte, &ucByte, &pvNext);
+        iByte = ucByte)
+    {
+        psLeaf = SymTable_floorIn(pvNext, pcKey, uKeyLength);
+        if (psLeaf != NULL)
+            return psLeaf;
+    }
+    return psNode->psLeaf;
+}
+
+
+/* Return the leaf with the least key in the subtree pvChild, which may
+   be empty, that is at least the uKeyLength bytes at pcKey, or NULL if
+   there is none. */
+static const struct SymTableLeaf *SymTable_ceilingIn(const void *pvChild,
+    const char *pcKey, size_t uKeyLength)
+{
+    const struct SymTableNode *psNode;
+    const struct SymTableLeaf *psLeaf;
+    unsigned char ucByte;
+    void *pvNext;
+    int iByte;
+
+    if (pvChild == NULL ||
+        SymTable_compare(SymTable_maximumLeaf(pvChild), pcKey,
+            uKeyLength) < 0)
+        return NULL;
+    psLeaf = SymTable_minimumLeaf(pvChild);
+    if (SymTable_compare(psLeaf, pcKey, uKeyLength) >= 0)
+        return psLeaf;
+
+    /* the node's own leaf is its minimum, which is below pcKey, so
+    the answer is in the first child that ends at or above pcKey */
+    psNode = (const struct SymTableNode *)pvChild;
+    for (iByte = -1; SymTable_childAfter(psNode, iByte, &ucByte, &pvNext);
+        iByte = ucByte)
+    {
+        psLeaf = SymTable_ceilingIn(pvNext, pcKey, uKeyLength);
+        if (psLeaf != NULL)
+            return psLeaf;
+    }
+    return NULL;
+}
+
+
+const char *SymTable_floor(SymTable_T oSymTable, const char *pcKey)
+{
+    const struct SymTableLeaf *psLeaf;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_floorIn(oSymTable->pvRoot, pcKey, strlen(pcKey));
+    if (psLeaf == NULL)
+        return NULL;
+    return psLeaf->acKey;
+}
+
+
+const char *SymTable_ceiling(SymTable_T oSymTable, const char *pcKey)
+{
+    const struct SymTableLeaf *psLeaf;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psLeaf = SymTable_ceilingIn(oSymTable->pvRoot, pcKey, strlen(pcKey));
+    if (psLeaf == NULL)
+        return NULL;
+    return psLeaf->acKey;
+}
@@ -0,0 +1,1434 @@
+/*
+symtableconcurrent.c
+Author: David Wang
+*/
+
+/* pthreads and sched_yield are POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sched.h>
+#include "symtable.h"
+#include "symtableconcurrent.h"
+#include "symtableparallel.h"
+#include "symhash.h"
+#include "symparallel.h"
+
+/* Lookups read the table with no lock at all, so the words that they
+share with writers are loaded and stored through the __atomic
+builtins of GCC and Clang, which C99 has no equivalent of. */
+#ifndef __GNUC__
+#error "symtableconcurrent.c requires the GCC __atomic builtins"
+#endif
+
+
+/* initial number of buckets in the symbol table. The bucket count
+is always a power of 2 and a multiple of STRIPE_COUNT. */
+static const size_t uInitBucketCount = 512;
+
+/* Writers to the buckets are serialized by STRIPE_COUNT locks: bucket
+i by lock i % STRIPE_COUNT. Since every bucket count is a multiple of
+STRIPE_COUNT, the lock that guards a key's bucket depends only on the
+key's hash code, and stays the same however often the table resizes.
+A thread that needs more than one lock takes them in increasing
+order. */
+enum {STRIPE_COUNT = 64};
+
+/* the size of the cache lines that each stripe's lock and counter,
+and each reader's epoch, are kept apart from the others' by */
+enum {CACHE_LINE_SIZE = 64};
+
+/* the fewest buckets whose rehash is shared out among threads: below
+it, starting the threads would cost more than they save */
+static const size_t uParallelRehashBuckets = 262144;
+
+/* the number of removed nodes a table collects before it waits for a
+grace period and frees them */
+enum {RETIRE_BATCH = 128};
+
+/* passed in place of a key's length when the caller knows only the
+key's hash code; such keys are compared with strcmp once the hash
+codes agree */
+static const size_t uUnknownKeyLength = (size_t)-1;
+
+/* Each item is stored in a SymTableNode. SymTableNodes are linked to
+   form a list, one per bucket. A node and the defensive copy of its
+   key are a single allocation. */
+struct SymTableNode
+{
+    /* pointer to the value. */
+    const void *pvValue;
+
+    /* full hash code of the key, before reduction to a bucket index */
+    size_t uHash;
+
+    /* length of the key in bytes, not counting the '\0' that ends
+    the copy */
+    size_t uKeyLength;
+
+    /* The addresses of the next SymTableNode, in the arrays whose
+    iLink is 0 and 1. A resize links the nodes into the new array
+    through the link that lookups in the current array do not follow,
+    so that those lookups never see a half-moved chain. */
+    struct SymTableNode *apsNextNode[2];
+
+    /* The address of the next removed node awaiting a grace period */
+    struct SymTableNode *psNextRetired;
+
+    /* defensive copy of the key, stored inline and '\0'-terminated */
+    char acKey[];
+};
+
+
+/* A SymTableArray is an array of buckets with its size, so that a
+   lookup loads both at once. */
+struct SymTableArray
+{
+    /* The number of buckets in the array */
+    size_t uBucketCount;
+
+    /* Which of apsNextNode links the chains of this array */
+    int iLink;
+
+    /* The buckets */
+    struct SymTableNode *apsBuckets[];
+};
+
+
+/* A SymTableStripe is one of the locks of a SymTable, with the number
+   of bindings in the buckets it guards. */
+struct SymTableStripe
+{
+    /* Held to change the stripe's buckets */
+    pthread_mutex_t sLock;
+
+    /* The number of bindings in the stripe's buckets */
+    size_t uLength;
+
+    /* keeps the next stripe out of the cache lines of this one, so
+    that threads working in different stripes do not contend */
+    char acPadding[CACHE_LINE_SIZE];
+};
+
+
+/* A SymTable owns the array of buckets and the stripes that guard
+   them. */
+struct SymTable
+{
+    /* The current array, replaced only under the locks of all the
+    stripes and published by a release store */
+    struct SymTableArray *psArray;
+
+    /* The secret seed under which the hash codes of keys are rehashed
+    before they are stored, so that keys colliding in one SymTable need
+    not collide in another */
+    uint64_t uSeed;
+
+    /* Held throughout a resize, including the grace period after it,
+    so that one resize never relinks the chains that lookups in the
+    array of the previous one may still follow */
+    pthread_mutex_t sResizeLock;
+
+    /* Guards psRetired and uRetiredCount */
+    pthread_mutex_t sRetireLock;
+
+    /* The removed nodes awaiting a grace period */
+    struct SymTableNode *psRetired;
+
+    /* The number of nodes in psRetired */
+    size_t uRetiredCount;
+
+    /* The locks that guard the buckets */
+    struct SymTableStripe asStripes[STRIPE_COUNT];
+};
+
+
+/* A SymTableMapping is one call of SymTable_mapParallel, shared by the
+   threads that carry it out. */
+struct SymTableMapping
+{
+    /* The array being traversed */
+    struct SymTableArray *psArray;
+
+    /* The function to apply to each binding, and its extra
+    parameter */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+
+/* A SymTableRehash is one rehash of a SymTable, shared by the threads
+   that carry it out. */
+struct SymTableRehash
+{
+    /* The array whose nodes are moved, and the array they move to */
+    struct SymTableArray *psOldArray;
+    struct SymTableArray *psNewArray;
+
+    /* The smaller of the two bucket counts */
+    size_t uStride;
+};
+
+
+/* A SymTableReader announces the lookups of one thread. Each thread
+   that looks keys up gets its own, which it reuses for every table,
+   and which another thread takes over once it exits. */
+struct SymTableReader
+{
+    /* 0 while the thread is not looking a key up; otherwise the
+    global epoch when it started, which it stores before reading any
+    table. Written only by the thread itself. */
+    size_t uEpoch;
+
+    /* 1 (TRUE) while a thread owns the reader */
+    int iInUse;
+
+    /* The address of the next reader ever created */
+    struct SymTableReader *psNextReader;
+
+    /* keeps the readers of different threads on different cache
+    lines */
+    char acPadding[CACHE_LINE_SIZE];
+};
+
+
+/* The epoch of the process, which a grace period advances. Stored
+   only under sReadersLock. */
+static size_t uGlobalEpoch = 1;
+
+/* Every reader ever created, in use or not */
+static struct SymTableReader *psReaders = NULL;
+
+/* Guards psReaders and the iInUse fields, and serializes grace
+   periods */
+static pthread_mutex_t sReadersLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* The key under which each thread finds its reader */
+static pthread_key_t sReaderKey;
+
+/* 1 (TRUE) if sReaderKey was created */
+static int iReaderKeyCreated = 0;
+
+/* Makes sure that sReaderKey is created once */
+static pthread_once_t sReaderOnce = PTHREAD_ONCE_INIT;
+
+
+/* Load, with acquire ordering, the link at ppsLink. */
+static struct SymTableNode *SymTable_loadLink(
+    struct SymTableNode **ppsLink)
+{
+    assert(ppsLink != NULL);
+
+    return __atomic_load_n(ppsLink, __ATOMIC_ACQUIRE);
+}
+
+
+/* Store psNode in the link at ppsLink with release ordering, so that
+   a lookup that loads psNode sees it fully built. */
+static void SymTable_storeLink(struct SymTableNode **ppsLink,
+    struct SymTableNode *psNode)
+{
+    assert(ppsLink != NULL);
+
+    __atomic_store_n(ppsLink, psNode, __ATOMIC_RELEASE);
+}
+
+
+/* Return the current array of oSymTable, loaded with acquire
+   ordering. */
+static struct SymTableArray *SymTable_loadArray(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    return __atomic_load_n(&oSymTable->psArray, __ATOMIC_ACQUIRE);
+}
+
+
+/* Return the full hash code in oSymTable of a key whose
+   table-independent hash code is uHash. */
+static size_t SymTable_tableHash(SymTable_T oSymTable,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+
+    return (size_t)SymHash_tableHash(uHash, oSymTable->uSeed);
+}
+
+
+/* Return the full hash code in oSymTable for the uKeyLength bytes at
+   pcKey. */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uKeyLength)
+{
+    assert(pcKey != NULL);
+
+    return SymTable_tableHash(oSymTable, SymHash_hash(pcKey, uKeyLength));
+}
+
+
+/* Return the stripe of oSymTable that guards the bucket of a key whose
+   full hash code is uHash. */
+static struct SymTableStripe *SymTable_stripe(SymTable_T oSymTable,
+    size_t uHash)
+{
+    assert(oSymTable != NULL);
+
+    return &oSymTable->asStripes[uHash & (STRIPE_COUNT - 1)];
+}
+
+
+/* Lock psLock. */
+static void SymTable_lock(pthread_mutex_t *psLock)
+{
+    int iStatus;
+
+    assert(psLock != NULL);
+
+    iStatus = pthread_mutex_lock(psLock);
+    assert(iStatus == 0);
+    (void)iStatus;
+}
+
+
+/* Release psLock, which the calling thread holds. */
+static void SymTable_unlock(pthread_mutex_t *psLock)
+{
+    int iStatus;
+
+    assert(psLock != NULL);
+
+    iStatus = pthread_mutex_unlock(psLock);
+    assert(iStatus == 0);
+    (void)iStatus;
+}
+
+
+/* Lock every stripe of oSymTable, in increasing order. */
+static void SymTable_lockAll(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    for (i=0; i<STRIPE_COUNT; i++)
+        SymTable_lock(&oSymTable->asStripes[i].sLock);
+}
+
+
+/* Release every stripe of oSymTable, which the calling thread holds. */
+static void SymTable_unlockAll(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    for (i=STRIPE_COUNT; i>0; i--)
+        SymTable_unlock(&oSymTable->asStripes[i-1].sLock);
+}
+
+
+/* Return the number of bindings in oSymTable, whose stripes the
+   calling thread holds. */
+static size_t SymTable_lockedLength(SymTable_T oSymTable)
+{
+    size_t i;
+    size_t uLength = 0;
+
+    assert(oSymTable != NULL);
+
+    for (i=0; i<STRIPE_COUNT; i++)
+        uLength += oSymTable->asStripes[i].uLength;
+    return uLength;
+}
+
+
+/* Mark the reader pvReader, whose thread is exiting, free for another
+   thread. */
+static void SymTable_releaseReader(void *pvReader)
+{
+    struct SymTableReader *psReader = (struct SymTableReader *)pvReader;
+
+    assert(psReader != NULL);
+
+    SymTable_lock(&sReadersLock);
+    psReader->iInUse = 0;
+    SymTable_unlock(&sReadersLock);
+}
+
+
+/* Create sReaderKey. */
+static void SymTable_createReaderKey(void)
+{
+    iReaderKeyCreated =
+        pthread_key_create(&sReaderKey, SymTable_releaseReader) == 0;
+}
+
+
+/* Return the reader of the calling thread, taking over a free one or
+   creating one if the thread has none. Return NULL if insufficient
+   memory is available. */
+static struct SymTableReader *SymTable_reader(void)
+{
+    struct SymTableReader *psReader;
+
+    if (!iReaderKeyCreated)
+        return NULL;
+
+    psReader = (struct SymTableReader *)pthread_getspecific(sReaderKey);
+    if (psReader != NULL)
+        return psReader;
+
+    SymTable_lock(&sReadersLock);
+    for (psReader = psReaders; psReader != NULL;
+        psReader = psReader->psNextReader)
+        if (!psReader->iInUse)
+            break;
+    if (psReader == NULL) {
+        psReader = (struct SymTableReader *)
+            malloc(sizeof(struct SymTableReader));
+        if (psReader != NULL) {
+            psReader->uEpoch = 0;
+            psReader->psNextReader = psReaders;
+            psReaders = psReader;
+        }
+    }
+    if (psReader != NULL) {
+        if (pthread_setspecific(sReaderKey, psReader) == 0)
+            psReader->iInUse = 1;
+        else
+            psReader = NULL;
+    }
+    SymTable_unlock(&sReadersLock);
+    return psReader;
+}
+
+
+/* Announce that the thread of psReader is starting a lookup. Until it
+   ends the lookup, no node or array that it may reach is freed. */
+static void SymTable_beginRead(struct SymTableReader *psReader)
+{
+    assert(psReader != NULL);
+
+    __atomic_store_n(&psReader->uEpoch,
+        __atomic_load_n(&uGlobalEpoch, __ATOMIC_RELAXED),
+        __ATOMIC_RELAXED);
+    /* the announcement must be visible before the table is read; this
+    is a fence, not a read-modify-write of a shared line */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+
+/* Announce that the thread of psReader has ended its lookup. */
+static void SymTable_endRead(struct SymTableReader *psReader)
+{
+    assert(psReader != NULL);
+
+    __atomic_store_n(&psReader->uEpoch, 0, __ATOMIC_RELEASE);
+}
+
+
+/* Wait for a grace period: until every lookup that was under way when
+   the call began has ended. Whatever was unlinked from every table
+   before the call may be freed after it. */
+static void SymTable_synchronize(void)
+{
+    struct SymTableReader *psReader;
+    size_t uEpoch;
+    size_t uTarget;
+
+    SymTable_lock(&sReadersLock);
+
+    uTarget = uGlobalEpoch + 1;
+    __atomic_store_n(&uGlobalEpoch, uTarget, __ATOMIC_RELAXED);
+    /* pairs with the fence of SymTable_beginRead: a lookup that this
+    thread does not see begin sees everything unlinked before */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    for (psReader = psReaders; psReader != NULL;
+        psReader = psReader->psNextReader) {
+        for (;;) {
+            uEpoch = __atomic_load_n(&psReader->uEpoch, __ATOMIC_ACQUIRE);
+            if (uEpoch == 0 || uEpoch >= uTarget)
+                break;
+            (void)sched_yield();
+        }
+    }
+
+    SymTable_unlock(&sReadersLock);
+}
+
+
+/* Add psNode, just unlinked from oSymTable, to the nodes awaiting a
+   grace period. Once RETIRE_BATCH have collected, wait for one and
+   free them. */
+static void SymTable_retireNode(SymTable_T oSymTable,
+    struct SymTableNode *psNode)
+{
+    struct SymTableNode *psBatch = NULL;
+    struct SymTableNode *psNextNode;
+
+    assert(oSymTable != NULL);
+    assert(psNode != NULL);
+
+    SymTable_lock(&oSymTable->sRetireLock);
+    psNode->psNextRetired = oSymTable->psRetired;
+    oSymTable->psRetired = psNode;
+    if (++oSymTable->uRetiredCount >= RETIRE_BATCH) {
+        psBatch = oSymTable->psRetired;
+        oSymTable->psRetired = NULL;
+        oSymTable->uRetiredCount = 0;
+    }
+    SymTable_unlock(&oSymTable->sRetireLock);
+
+    if (psBatch == NULL)
+        return;
+    SymTable_synchronize();
+    for (; psBatch != NULL; psBatch = psNextNode) {
+        psNextNode = psBatch->psNextRetired;
+        free(psBatch);
+    }
+}
+
+
+/* Return a new, empty array of uBucketCount buckets whose chains use
+   link iLink, or NULL if insufficient memory is available or so many
+   buckets could not be indexed by a size_t. */
+static struct SymTableArray *SymTable_newArray(size_t uBucketCount,
+    int iLink)
+{
+    struct SymTableArray *psArray;
+
+    if (uBucketCount > ((size_t)-1 - sizeof(struct SymTableArray)) /
+        sizeof(struct SymTableNode *))
+        return NULL;
+
+    psArray = (struct SymTableArray *)calloc(1,
+        sizeof(struct SymTableArray) +
+        uBucketCount * sizeof(struct SymTableNode *));
+    if (psArray == NULL)
+        return NULL;
+    psArray->uBucketCount = uBucketCount;
+    psArray->iLink = iLink;
+    return psArray;
+}
+
+
+/* Store in *puBucketCount the fewest buckets, a power of 2 and at
+   least uInitBucketCount, that uCapacity bindings do not outnumber,
+   and return 1 (TRUE). Return 0 (FALSE) if so many buckets could not
+   be indexed by a size_t. */
+static int SymTable_bucketCountFor(size_t uCapacity,
+    size_t *puBucketCount)
+{
+    size_t uBucketCount;
+
+    assert(puBucketCount != NULL);
+
+    for (uBucketCount = uInitBucketCount; uBucketCount < uCapacity;
+        uBucketCount *= 2)
+        if (uBucketCount >
+            (size_t)-1 / 2 / sizeof(struct SymTableNode *))
+            return 0;
+    *puBucketCount = uBucketCount;
+    return 1;
+}
+
+
+/* Return 1 (TRUE) if psNode holds the key pcKey, whose full hash code
+   is uHash and whose length is uKeyLength (or uUnknownKeyLength), and
+   0 (FALSE) otherwise. The key bytes are compared only if the hash
+   codes agree. */
+static int SymTable_nodeMatches(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    assert(psNode != NULL);
+    assert(pcKey != NULL);
+
+    if (psNode->uHash != uHash)
+        return 0;
+    /* a stored key containing '\0' only looks equal to the string */
+    if (uKeyLength == uUnknownKeyLength)
+        return strcmp(psNode->acKey, pcKey) == 0 &&
+            strlen(psNode->acKey) == psNode->uKeyLength;
+    return psNode->uKeyLength == uKeyLength &&
+        memcmp(psNode->acKey, pcKey, uKeyLength) == 0;
+}
+
+
+/*
+Return the address of the link of psArray, a bucket or a node's
+apsNextNode, that points to the node whose key is pcKey, given the full
+hash code uHash and length uKeyLength (or uUnknownKeyLength) of pcKey,
+or to NULL at the end of the key's bucket if there is none. The
+calling thread must hold the key's stripe, so that the link still
+points there when it returns.
+*/
+static struct SymTableNode **SymTable_findLink(
+    struct SymTableArray *psArray, const char *pcKey, size_t uHash,
+    size_t uKeyLength)
+{
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNode;
+
+    assert(psArray != NULL);
+    assert(pcKey != NULL);
+
+    ppsLink = &psArray->apsBuckets[uHash & (psArray->uBucketCount - 1)];
+    while ((psNode = SymTable_loadLink(ppsLink)) != NULL &&
+        !SymTable_nodeMatches(psNode, pcKey, uHash, uKeyLength))
+        ppsLink = &psNode->apsNextNode[psArray->iLink];
+    return ppsLink;
+}
+
+
+/*
+Return the node of psArray whose key is pcKey, given the full hash
+code uHash and length uKeyLength (or uUnknownKeyLength) of pcKey, or
+NULL if there is none. A lookup needs no lock to search this way,
+since each link it follows holds a node that is fully built and not
+yet freed; but it must load each link once, as a writer may change
+it at any time.
+*/
+static struct SymTableNode *SymTable_findNode(
+    struct SymTableArray *psArray, const char *pcKey, size_t uHash,
+    size_t uKeyLength)
+{
+    struct SymTableNode *psNode;
+
+    assert(psArray != NULL);
+    assert(pcKey != NULL);
+
+    psNode = SymTable_loadLink(
+        &psArray->apsBuckets[uHash & (psArray->uBucketCount - 1)]);
+    while (psNode != NULL &&
+        !SymTable_nodeMatches(psNode, pcKey, uHash, uKeyLength))
+        psNode = SymTable_loadLink(&psNode->apsNextNode[psArray->iLink]);
+    return psNode;
+}
+
+
+/* Link every node in the buckets r, r + uStride, r + 2 * uStride, ...
+   of the old array of the SymTableRehash pvRehash into its new array,
+   for each r from uBegin through uEnd - 1. Since uStride is the smaller
+   of the two bucket counts, both powers of 2, the nodes of those
+   buckets go only to new buckets whose indices are also r modulo
+   uStride, so that threads given disjoint ranges of r never write the
+   same bucket or node. */
+static void SymTable_rehashRange(size_t uBegin, size_t uEnd,
+    void *pvRehash)
+{
+    const struct SymTableRehash *psRehash =
+        (const struct SymTableRehash *)pvRehash;
+    const struct SymTableArray *psOldArray;
+    struct SymTableArray *psNewArray;
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode **ppsBucket;
+    size_t r;
+    size_t i;
+
+    assert(psRehash != NULL);
+
+    psOldArray = psRehash->psOldArray;
+    psNewArray = psRehash->psNewArray;
+    for (r = uBegin; r < uEnd; r++) {
+        for (i = r; i < psOldArray->uBucketCount; i += psRehash->uStride) {
+            for (psCurrentNode = psOldArray->apsBuckets[i];
+                psCurrentNode != NULL;
+                psCurrentNode =
+                    psCurrentNode->apsNextNode[psOldArray->iLink]) {
+                ppsBucket = &psNewArray->apsBuckets[psCurrentNode->uHash &
+                    (psNewArray->uBucketCount - 1)];
+                psCurrentNode->apsNextNode[psNewArray->iLink] = *ppsBucket;
+                *ppsBucket = psCurrentNode;
+            }
+        }
+    }
+}
+
+
+/* Link every binding of oSymTable, all of whose stripes the calling
+   thread holds, into psNewArray, an empty array whose chains use the
+   link that the current array's do not, publish psNewArray, and return
+   the array it replaces. Lookups still in the old array keep following
+   its chains, which this leaves as they were. An array of at least
+   uParallelRehashBuckets buckets is rehashed on as many threads as
+   there are processors, so that the other threads wait less. */
+static struct SymTableArray *SymTable_rehash(SymTable_T oSymTable,
+    struct SymTableArray *psNewArray)
+{
+    struct SymTableRehash sRehash;
+    size_t uThreadCount = 1;
+
+    assert(oSymTable != NULL);
+    assert(psNewArray != NULL);
+    assert(psNewArray->uBucketCount % STRIPE_COUNT == 0);
+
+    sRehash.psOldArray = oSymTable->psArray;
+    sRehash.psNewArray = psNewArray;
+    assert(psNewArray->iLink != sRehash.psOldArray->iLink);
+    sRehash.uStride = psNewArray->uBucketCount <
+        sRehash.psOldArray->uBucketCount ?
+        psNewArray->uBucketCount : sRehash.psOldArray->uBucketCount;
+
+    if (sRehash.psOldArray->uBucketCount >= uParallelRehashBuckets)
+        uThreadCount = SymParallel_threadCount();
+    SymParallel_run(sRehash.uStride, SymTable_rehashRange, &sRehash,
+        uThreadCount);
+
+    __atomic_store_n(&oSymTable->psArray, psNewArray, __ATOMIC_RELEASE);
+    return sRehash.psOldArray;
+}
+
+
+/*
+Replace the array of oSymTable, which the calling thread holds the
+resize lock of, with a new one of uNewBucketCount buckets if
+pfShould, called with all the stripes held, the current bucket count
+and the number of bindings, returns 1 (TRUE). The new array is
+allocated before any stripe is taken, and the old one freed after a
+grace period, once the stripes are released. Return 0 (FALSE) if
+insufficient memory is available, and 1 (TRUE) otherwise.
+*/
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewBucketCount,
+    int (*pfShould)(size_t uBucketCount, size_t uLength,
+        size_t uNewBucketCount))
+{
+    struct SymTableArray *psNewArray;
+    int iResize;
+
+    assert(oSymTable != NULL);
+    assert(pfShould != NULL);
+
+    psNewArray = SymTable_newArray(uNewBucketCount,
+        !oSymTable->psArray->iLink);
+    if (psNewArray == NULL)
+        return 0;
+
+    SymTable_lockAll(oSymTable);
+    iResize = (*pfShould)(oSymTable->psArray->uBucketCount,
+        SymTable_lockedLength(oSymTable), uNewBucketCount);
+    if (iResize)
+        psNewArray = SymTable_rehash(oSymTable, psNewArray);
+    SymTable_unlockAll(oSymTable);
+
+    /* either the old array, which lookups may still be reading, or
+    the unused new one */
+    if (iResize)
+        SymTable_synchronize();
+    free(psNewArray);
+    return 1;
+}
+
+
+/* Return 1 (TRUE) if a table of uBucketCount buckets should double to
+   uNewBucketCount: if no other thread has resized it since the
+   decision to. uLength is unused. */
+static int SymTable_shouldExpand(size_t uBucketCount, size_t uLength,
+    size_t uNewBucketCount)
+{
+    (void)uLength;
+    return uBucketCount * 2 == uNewBucketCount;
+}
+
+
+/* Return 1 (TRUE) if a table of uBucketCount buckets and uLength
+   bindings should halve to uNewBucketCount: if it has not resized
+   since the decision to, and fewer than a quarter of its buckets would
+   be used. As in the other hash tables, a halved table is at most half
+   full, so it does not grow again at once. */
+static int SymTable_shouldContract(size_t uBucketCount, size_t uLength,
+    size_t uNewBucketCount)
+{
+    return uBucketCount == uNewBucketCount * 2 &&
+        uLength < uBucketCount / 4;
+}
+
+
+/* Return 1 (TRUE) if a table of uBucketCount buckets should grow to
+   the uNewBucketCount buckets reserved for it. uLength is unused. */
+static int SymTable_shouldReserve(size_t uBucketCount, size_t uLength,
+    size_t uNewBucketCount)
+{
+    (void)uLength;
+    return uBucketCount < uNewBucketCount;
+}
+
+
+/* Return 1 (TRUE) if a table of uBucketCount buckets and uLength
+   bindings should shrink to uNewBucketCount, the fewest buckets that
+   fit its length. */
+static int SymTable_shouldShrink(size_t uBucketCount, size_t uLength,
+    size_t uNewBucketCount)
+{
+    size_t uFitBucketCount;
+
+    return SymTable_bucketCountFor(uLength, &uFitBucketCount) &&
+        uFitBucketCount == uNewBucketCount &&
+        uNewBucketCount < uBucketCount;
+}
+
+
+/* Resize oSymTable, under its resize lock, to uNewBucketCount buckets
+   if pfShould agrees, as SymTable_resize does. */
+static int SymTable_resizeLocked(SymTable_T oSymTable,
+    size_t uNewBucketCount,
+    int (*pfShould)(size_t uBucketCount, size_t uLength,
+        size_t uNewBucketCount))
+{
+    int iSuccessful;
+
+    assert(oSymTable != NULL);
+
+    SymTable_lock(&oSymTable->sResizeLock);
+    iSuccessful = SymTable_resize(oSymTable, uNewBucketCount, pfShould);
+    SymTable_unlock(&oSymTable->sResizeLock);
+    return iSuccessful;
+}
+
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uBucketCount;
+    size_t i;
+
+    if (!SymTable_bucketCountFor(uCapacity, &uBucketCount))
+        return NULL;
+
+    (void)pthread_once(&sReaderOnce, SymTable_createReaderKey);
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    oSymTable->psArray = SymTable_newArray(uBucketCount, 0);
+    if (oSymTable->psArray == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+
+    for (i=0; i<STRIPE_COUNT; i++) {
+        if (pthread_mutex_init(&oSymTable->asStripes[i].sLock, NULL)
+            != 0)
+            break;
+        oSymTable->asStripes[i].uLength = 0;
+    }
+    if (i < STRIPE_COUNT ||
+        pthread_mutex_init(&oSymTable->sResizeLock, NULL) != 0) {
+        while (i > 0)
+            (void)pthread_mutex_destroy(&oSymTable->asStripes[--i].sLock);
+        free(oSymTable->psArray);
+        free(oSymTable);
+        return NULL;
+    }
+    if (pthread_mutex_init(&oSymTable->sRetireLock, NULL) != 0) {
+        (void)pthread_mutex_destroy(&oSymTable->sResizeLock);
+        for (i=0; i<STRIPE_COUNT; i++)
+            (void)pthread_mutex_destroy(&oSymTable->asStripes[i].sLock);
+        free(oSymTable->psArray);
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->psRetired = NULL;
+    oSymTable->uRetiredCount = 0;
+    oSymTable->uSeed = SymHash_newSeed();
+    return oSymTable;
+}
+
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+    struct SymTableArray *psArray;
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+
+    assert(oSymTable != NULL);
+
+    psArray = oSymTable->psArray;
+    for (i=0; i<psArray->uBucketCount; i++) {
+        for (psCurrentNode = psArray->apsBuckets[i];
+            psCurrentNode != NULL;
+            psCurrentNode = psNextNode)
+        {
+            psNextNode = psCurrentNode->apsNextNode[psArray->iLink];
+            free(psCurrentNode);
+        }
+    }
+
+    /* no lookup of this table may still be under way */
+    for (psCurrentNode = oSymTable->psRetired; psCurrentNode != NULL;
+        psCurrentNode = psNextNode) {
+        psNextNode = psCurrentNode->psNextRetired;
+        free(psCurrentNode);
+    }
+
+    for (i=0; i<STRIPE_COUNT; i++)
+        (void)pthread_mutex_destroy(&oSymTable->asStripes[i].sLock);
+    (void)pthread_mutex_destroy(&oSymTable->sResizeLock);
+    (void)pthread_mutex_destroy(&oSymTable->sRetireLock);
+    free(psArray);
+    free(oSymTable);
+}
+
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    size_t i;
+    size_t uLength = 0;
+    struct SymTableStripe *psStripe;
+
+    assert(oSymTable != NULL);
+
+    for (i=0; i<STRIPE_COUNT; i++) {
+        psStripe = &oSymTable->asStripes[i];
+        SymTable_lock(&psStripe->sLock);
+        uLength += psStripe->uLength;
+        SymTable_unlock(&psStripe->sLock);
+    }
+    return uLength;
+}
+
+
+/*
+If oSymTable contains a binding whose key is pcKey, given the full
+hash code uHash and length uKeyLength (or uUnknownKeyLength) of pcKey,
+set *piInserted to 0 (FALSE) and return the address of its value. If
+not, add one with value pvDefault, set *piInserted to 1 (TRUE), and
+return the address of its value. If insufficient memory is available,
+leave oSymTable unchanged, set *piInserted to 0 (FALSE), and return
+NULL.
+*/
+static void **SymTable_findOrInsertHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength,
+    const void *pvDefault, int *piInserted)
+{
+    struct SymTableStripe *psStripe;
+    struct SymTableArray *psArray;
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNode;
+    size_t uBucketCount;
+    int iExpand;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    *piInserted = 0;
+
+    /* the key is copied if it is absent, so its length is needed */
+    if (uKeyLength == uUnknownKeyLength)
+        uKeyLength = strlen(pcKey);
+
+    psStripe = SymTable_stripe(oSymTable, uHash);
+    SymTable_lock(&psStripe->sLock);
+
+    psArray = oSymTable->psArray;
+    ppsLink = SymTable_findLink(psArray, pcKey, uHash, uKeyLength);
+    psNode = *ppsLink;
+    if (psNode != NULL) {
+        SymTable_unlock(&psStripe->sLock);
+        return (void **) &psNode->pvValue;
+    }
+
+    /* allocate the node together with room for its key */
+    psNode = (struct SymTableNode *)
+        malloc(sizeof(struct SymTableNode) + uKeyLength + 1);
+    if (psNode == NULL) {
+        SymTable_unlock(&psStripe->sLock);
+        return NULL;
+    }
+
+    /* create defensive copy of key, which need not end in '\0' */
+    memcpy(psNode->acKey, pcKey, uKeyLength);
+    psNode->acKey[uKeyLength] = '\0';
+    psNode->uHash = uHash;
+    psNode->uKeyLength = uKeyLength;
+    psNode->pvValue = pvDefault;
+    psNode->apsNextNode[0] = NULL;
+    psNode->apsNextNode[1] = NULL;
+
+    /* a new node goes first in its bucket, published once built */
+    ppsLink = &psArray->apsBuckets[uHash & (psArray->uBucketCount - 1)];
+    psNode->apsNextNode[psArray->iLink] = *ppsLink;
+    SymTable_storeLink(ppsLink, psNode);
+    psStripe->uLength += 1;
+
+    /* the stripe's share of the buckets stands in for the table: each
+    stripe holds about the same number of bindings */
+    uBucketCount = psArray->uBucketCount;
+    iExpand = psStripe->uLength > uBucketCount / STRIPE_COUNT;
+    SymTable_unlock(&psStripe->sLock);
+
+    /* start expanding SymTable if necessary */
+    if (iExpand && uBucketCount * 2 / 2 == uBucketCount)
+        (void)SymTable_resizeLocked(oSymTable, uBucketCount * 2,
+            SymTable_shouldExpand);
+
+    *piInserted = 1;
+    return (void **) &psNode->pvValue;
+}
+
+
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvDefault, int *piInserted)
+{
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    uKeyLength = strlen(pcKey);
+    return SymTable_findOrInsertHashed(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength,
+        pvDefault, piInserted);
+}
+
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+/* the table takes one binding at a time under its stripe's lock, so
+the batch is put one binding at a time */
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+    const void **apvValues, size_t uCount, int *aiResults)
+{
+    size_t i;
+    size_t uAdded = 0;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvValues != NULL);
+
+    for (i = 0; i < uCount; i++) {
+        iInserted = SymTable_put(oSymTable, apcKeys[i], apvValues[i]);
+        if (aiResults != NULL)
+            aiResults[i] = iInserted;
+        uAdded += (size_t)iInserted;
+    }
+    return uAdded;
+}
+
+
+SymTable_Hash_T SymTable_hashKey(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return SymHash_hash(pcKey, strlen(pcKey));
+}
+
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsertHashed(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength, pvValue,
+        &iInserted);
+    return iInserted;
+}
+
+
+/*
+If oSymTable contains a binding whose key is pcKey, given the full
+hash code uHash and length uKeyLength (or uUnknownKeyLength) of pcKey,
+store its value in *ppvValue and return 1 (TRUE). Otherwise return
+0 (FALSE). The lookup takes no lock and writes nothing but the calling
+thread's own reader; only a thread that cannot get a reader falls back
+on the key's stripe lock.
+*/
+static int SymTable_lookup(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, size_t uKeyLength, void **ppvValue)
+{
+    struct SymTableReader *psReader;
+    struct SymTableStripe *psStripe = NULL;
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(ppvValue != NULL);
+
+    psReader = SymTable_reader();
+    if (psReader != NULL)
+        SymTable_beginRead(psReader);
+    else {
+        psStripe = SymTable_stripe(oSymTable, uHash);
+        SymTable_lock(&psStripe->sLock);
+    }
+
+    psNode = SymTable_findNode(SymTable_loadArray(oSymTable), pcKey,
+        uHash, uKeyLength);
+    if (psNode != NULL)
+        *ppvValue = __atomic_load_n((void **) &psNode->pvValue,
+            __ATOMIC_ACQUIRE);
+
+    if (psReader != NULL)
+        SymTable_endRead(psReader);
+    else
+        SymTable_unlock(&psStripe->sLock);
+    return psNode != NULL;
+}
+
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    struct SymTableStripe *psStripe;
+    struct SymTableNode *psNode;
+    size_t uKeyLength;
+    size_t uHash;
+    const void *pvOldValue = NULL;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uKeyLength = strlen(pcKey);
+    uHash = SymTable_hash(oSymTable, pcKey, uKeyLength);
+
+    psStripe = SymTable_stripe(oSymTable, uHash);
+    SymTable_lock(&psStripe->sLock);
+    psNode = *SymTable_findLink(oSymTable->psArray, pcKey, uHash,
+        uKeyLength);
+    if (psNode != NULL) {
+        pvOldValue = psNode->pvValue;
+        __atomic_store_n((void **) &psNode->pvValue, (void *) pvValue,
+            __ATOMIC_RELEASE);
+    }
+    SymTable_unlock(&psStripe->sLock);
+    return (void *) pvOldValue;
+}
+
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uKeyLength;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uKeyLength = strlen(pcKey);
+    return SymTable_lookup(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength,
+        &pvValue);
+}
+
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uKeyLength;
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uKeyLength = strlen(pcKey);
+    if (!SymTable_lookup(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength,
+        &pvValue))
+        return NULL;
+    return pvValue;
+}
+
+
+/* each lookup announces itself on its own, so the batch is searched
+one key at a time */
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+    size_t uCount, void **apvOut)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvOut != NULL);
+
+    for (i = 0; i < uCount; i++)
+        apvOut[i] = SymTable_get(oSymTable, apcKeys[i]);
+}
+
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_lookup(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength,
+        &pvValue))
+        return NULL;
+    return pvValue;
+}
+
+
+/*
+If oSymTable contains a binding with key pcKey, whose full hash code
+is uHash and whose length is uKeyLength (or uUnknownKeyLength), remove
+that binding from oSymTable and return the binding's value.
+Otherwise, do not change oSymTable and return NULL. The node is freed
+only after a grace period, since lookups may still be on it.
+*/
+static void *SymTable_removeNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    struct SymTableStripe *psStripe;
+    struct SymTableArray *psArray;
+    struct SymTableNode **ppsLink;
+    struct SymTableNode *psNode;
+    size_t uBucketCount;
+    int iContract;
+    const void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psStripe = SymTable_stripe(oSymTable, uHash);
+    SymTable_lock(&psStripe->sLock);
+
+    psArray = oSymTable->psArray;
+    ppsLink = SymTable_findLink(psArray, pcKey, uHash, uKeyLength);
+    psNode = *ppsLink;
+    if (psNode == NULL) {
+        SymTable_unlock(&psStripe->sLock);
+        return NULL;
+    }
+
+    /* a lookup on the node still finds its successor */
+    SymTable_storeLink(ppsLink, psNode->apsNextNode[psArray->iLink]);
+    psStripe->uLength -= 1;
+    pvValue = psNode->pvValue;
+
+    /* a stripe well below the threshold suggests, and
+    SymTable_shouldContract then checks, that the table is */
+    uBucketCount = psArray->uBucketCount;
+    iContract = uBucketCount > uInitBucketCount &&
+        psStripe->uLength < uBucketCount / STRIPE_COUNT / 8;
+    SymTable_unlock(&psStripe->sLock);
+
+    SymTable_retireNode(oSymTable, psNode);
+
+    /* start shrinking SymTable if necessary */
+    if (iContract)
+        (void)SymTable_resizeLocked(oSymTable, uBucketCount / 2,
+            SymTable_shouldContract);
+    return (void *) pvValue;
+}
+
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uKeyLength = strlen(pcKey);
+    return SymTable_removeNode(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength);
+}
+
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_removeNode(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength);
+}
+
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    (void)SymTable_findOrInsertHashed(oSymTable, (const char *)pvKey,
+        SymTable_hash(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_lookup(oSymTable, (const char *)pvKey,
+        SymTable_hash(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength, &pvValue);
+}
+
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    if (!SymTable_lookup(oSymTable, (const char *)pvKey,
+        SymTable_hash(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength, &pvValue))
+        return NULL;
+    return pvValue;
+}
+
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_removeNode(oSymTable, (const char *)pvKey,
+        SymTable_hash(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength);
+}
+
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uBucketCount;
+
+    assert(oSymTable != NULL);
+
+    if (!SymTable_bucketCountFor(uCapacity, &uBucketCount))
+        return 0;
+    if (uBucketCount <= SymTable_loadArray(oSymTable)->uBucketCount)
+        return 1;
+    return SymTable_resizeLocked(oSymTable, uBucketCount,
+        SymTable_shouldReserve);
+}
+
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uBucketCount;
+
+    assert(oSymTable != NULL);
+
+    /* if the length changes before the stripes are taken,
+    SymTable_shouldShrink declines */
+    if (SymTable_bucketCountFor(SymTable_getLength(oSymTable),
+        &uBucketCount) &&
+        uBucketCount < SymTable_loadArray(oSymTable)->uBucketCount)
+        (void)SymTable_resizeLocked(oSymTable, uBucketCount,
+            SymTable_shouldShrink);
+}
+
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    size_t i;
+    size_t uBucketIndex;
+    struct SymTableStripe *psStripe;
+    struct SymTableArray *psArray;
+    struct SymTableNode *psCurrentNode;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* a binding never leaves its stripe, so visiting one stripe at a
+    time visits each binding once, even if the table resizes in
+    between, and keeps the other stripes free meanwhile. Holding the
+    lock rather than announcing a lookup lets pfApply take as long as
+    it likes without holding up the reclamation of every table. */
+    for (i=0; i<STRIPE_COUNT; i++) {
+        psStripe = &oSymTable->asStripes[i];
+        SymTable_lock(&psStripe->sLock);
+        psArray = oSymTable->psArray;
+        for (uBucketIndex = i; uBucketIndex < psArray->uBucketCount;
+            uBucketIndex += STRIPE_COUNT)
+            for (psCurrentNode = psArray->apsBuckets[uBucketIndex];
+                psCurrentNode != NULL;
+                psCurrentNode =
+                    psCurrentNode->apsNextNode[psArray->iLink])
+                (*pfApply)(psCurrentNode->acKey,
+                    (void*)psCurrentNode->pvValue, (void*)pvExtra);
+        SymTable_unlock(&psStripe->sLock);
+    }
+}
+
+
+/* Apply the function of the SymTableMapping pvMapping to each binding
+   in the buckets uBegin through uEnd - 1 of its array. */
+static void SymTable_mapBuckets(size_t uBegin, size_t uEnd,
+    void *pvMapping)
+{
+    const struct SymTableMapping *psMapping =
+        (const struct SymTableMapping *)pvMapping;
+    struct SymTableArray *psArray;
+    struct SymTableNode *psCurrentNode;
+    size_t i;
+
+    assert(psMapping != NULL);
+
+    psArray = psMapping->psArray;
+    for (i = uBegin; i < uEnd; i++)
+        for (psCurrentNode = psArray->apsBuckets[i];
+            psCurrentNode != NULL;
+            psCurrentNode = psCurrentNode->apsNextNode[psArray->iLink])
+            (*psMapping->pfApply)(psCurrentNode->acKey,
+                (void*)psCurrentNode->pvValue, (void*)psMapping->pvExtra);
+}
+
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, size_t uThreadCount)
+{
+    struct SymTableMapping sMapping;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* the worker threads hold no lock of their own, so the calling
+    thread holds every stripe for them; lookups need none */
+    SymTable_lockAll(oSymTable);
+    sMapping.psArray = oSymTable->psArray;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymParallel_run(sMapping.psArray->uBucketCount, SymTable_mapBuckets,
+        &sMapping, uThreadCount);
+    SymTable_unlockAll(oSymTable);
+}
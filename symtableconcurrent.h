@@ -0,0 +1,33 @@
+/*
+symtableconcurrent.h
+Author: David Wang
+*/
+
+#ifndef SYMTABLECONCURRENT_INCLUDED
+#define SYMTABLECONCURRENT_INCLUDED
+#include "symtable.h"
+
+/*
+Thread safety, as provided by the concurrent implementation of
+symtable.h. Any number of threads may call the functions of
+symtable.h on one SymTable_T at once, and each call takes effect
+as if at a single instant. SymTable_get, SymTable_contains and their
+variants take no lock and never wait for another thread; the calls
+that add, replace or remove bindings wait only for calls on keys that
+share their lock, and, now and then, for lookups under way to end
+before freeing what they removed. The exceptions are these:
+-- SymTable_free must not overlap any other call on the same
+   SymTable_T.
+-- SymTable_map, SymTable_putBatch and SymTable_getBatch act on one
+   binding at a time; SymTable_map sees every binding that is in the
+   SymTable_T throughout the call, and may or may not see the others.
+   pfApply must not call any function on the same SymTable_T.
+-- SymTable_getLength is exact only while no other thread is adding
+   or removing bindings.
+-- An address returned by SymTable_findOrInsert remains valid until a
+   thread removes the binding, but reads and writes through it are not
+   synchronized with other threads; use SymTable_get and
+   SymTable_replace for a value that other threads may use.
+*/
+
+#endif
@@ -9,28 +9,228 @@ Author: David Wang
 #include <stddef.h>
 #include <stdio.h>
 #include "symtable.h"
-
-
-/* possible values for the number of buckets in the symbol table */
-static const size_t auBucketCounts[] = 
-    {509, 1021, 2039, 4093, 8191, 16381, 32749, 65521};
-/* number of possible values for the bucket count 
-(length of auBucketCounts array) */
-static const size_t numBucketCounts = 
-    sizeof(auBucketCounts)/sizeof(auBucketCounts[0]);
+#include "symtableiter.h"
+#include "symtableparallel.h"
+#include "symhash.h"
+#include "symparallel.h"
+
+/* SymTable_prefetch(pv) starts bringing the memory at pv into the
+cache without waiting for it, where the compiler offers a way to. */
+#if defined(__GNUC__)
+#define SymTable_prefetch(pv) __builtin_prefetch(pv)
+#else
+#define SymTable_prefetch(pv) ((void)(pv))
+#endif
+
+/* initial number of buckets in the symbol table. The bucket count
+is always a power of 2 so that a hash code is reduced to a bucket
+index by masking rather than by division. */
+static const size_t uInitBucketCount = 512;
+
+/* While oSymTable is being resized, each operation migrates at most
+uRehashBucketsPerStep non-empty buckets from the old array, and skips
+at most uRehashEmptyVisits empty ones, so that no single operation
+pays for rehashing the whole table. */
+static const size_t uRehashBucketsPerStep = 4;
+static const size_t uRehashEmptyVisits = 32;
+
+/* A resize that must finish at once, from an old array of at least
+uParallelRehashBuckets buckets, moves its chains on as many threads as
+there are processors: below that, starting the threads would cost
+more than they save. */
+static const size_t uParallelRehashBuckets = 262144;
+
+/* Nodes are carved out of per-table slab chunks in multiples of
+uSlabGranule bytes. The first chunk holds uSlabMinChunkSize bytes and
+each later one twice as many as the last, up to uSlabMaxChunkSize. */
+static const size_t uSlabGranule = 16;
+static const size_t uSlabMinChunkSize = 1024;
+static const size_t uSlabMaxChunkSize = 65536;
+
+/* Removed nodes are kept for reuse on one free list per size, in
+granules. Nodes larger than SLAB_CLASS_COUNT granules are allocated
+and freed individually. */
+enum {SLAB_CLASS_COUNT = 64};
+
+/* A chain that would grow to uTreeifyThreshold nodes is converted into
+a tree bin: an AVL tree ordered by (hash code, key), in which lookups
+take logarithmic rather than linear time. A tree bin whose height
+falls to iUntreeifyHeight, which leaves it fewer than
+uTreeifyThreshold nodes, is converted back into a chain. */
+static const size_t uTreeifyThreshold = 8;
+static const int iUntreeifyHeight = 3;
+
+/* SymTable_putBatch hashes each key and prefetches its bucket
+BATCH_WINDOW keys before inserting it, and prefetches the first node
+of the bucket halfway in between, so that the cache misses of that
+many keys are outstanding at once. */
+enum {BATCH_WINDOW = 16};
+
+/* SymTable_getBatch keeps up to LOOKUP_WINDOW lookups in progress,
+advancing each by one step, which prefetches the memory for the next,
+in turn. */
+enum {LOOKUP_WINDOW = 16};
+
+/* passed in place of a key's length when the caller knows only the
+key's hash code; such keys are compared with strcmp once the hash
+codes agree */
+static const size_t uUnknownKeyLength = (size_t)-1;
 
 /* Each item is stored in a SymTableNode. SymTableNodes are linked to
-   form a list.  */
+   form a list, one per bucket, and all of a SymTable's nodes are also
+   linked in the order in which they were added, so that a traversal
+   visits only the bindings and never the buckets. A node and the
+   defensive copy of its key are a single allocation.  */
 struct SymTableNode
 {
     /* pointer to the value. */
     const void *pvValue;
 
-    /* pointer to defensive copy of the key string */
-    const char *pcKey;
+    /* full hash code of the key, before reduction to a bucket index */
+    size_t uHash;
+
+    /* length of the key in bytes, not counting the '\0' that ends
+    the copy */
+    size_t uKeyLength;
 
     /* The address of the next SymTableNode. */
     struct SymTableNode *psNextNode;
+
+    /* The addresses of the SymTableNodes added just after and just
+    before this one that are still in the SymTable */
+    struct SymTableNode *psNextInOrder;
+    struct SymTableNode *psPrevInOrder;
+
+    /* defensive copy of the key, stored inline and '\0'-terminated */
+    char acKey[];
+};
+
+
+/* Each SymTableNode in a tree bin is indexed by a SymTableTreeNode.
+   The bucket holds the address of the root SymTableTreeNode with its
+   low-order bit set, which tells a tree bin from a chain. */
+struct SymTableTreeNode
+{
+    /* The indexed SymTableNode. Its psNextNode field is unused. */
+    struct SymTableNode *psNode;
+
+    /* The subtree of nodes that order before psNode */
+    struct SymTableTreeNode *psLeft;
+
+    /* The subtree of nodes that order after psNode */
+    struct SymTableTreeNode *psRight;
+
+    /* The number of levels in the subtree rooted here */
+    int iHeight;
+};
+
+
+/* A SymTableFreeBlock is a removed node or tree node awaiting reuse.
+   SymTableFreeBlocks of the same size are linked to form a list. */
+struct SymTableFreeBlock
+{
+    /* The address of the next SymTableFreeBlock. */
+    struct SymTableFreeBlock *psNextBlock;
+};
+
+
+/* A SymTableChunk is a block of memory from which a SymTable carves
+   its nodes. SymTableChunks are linked to form a list. */
+struct SymTableChunk
+{
+    /* The address of the next SymTableChunk. */
+    struct SymTableChunk *psNextChunk;
+
+    /* The address of the previous SymTableChunk, used only by chunks
+    that hold a single oversized node. */
+    struct SymTableChunk *psPrevChunk;
+
+    /* The number of bytes carved out of the chunk so far */
+    size_t uCarved;
+};
+
+
+/* A SymTableChunkUse counts the bytes of one slab chunk that lie in
+   removed blocks, so that a chunk none of whose blocks is in use can
+   be found and released. */
+struct SymTableChunkUse
+{
+    /* The counted SymTableChunk */
+    struct SymTableChunk *psChunk;
+
+    /* The number of bytes of psChunk on a free list */
+    size_t uFree;
+};
+
+
+/* A SymTableLookup is the search for one key of a SymTable_getBatch
+   batch. Each step examines one bucket or node, which an earlier step
+   prefetched, and prefetches the next. */
+struct SymTableLookup
+{
+    /* The position of the key in the batch */
+    size_t uIndex;
+
+    /* The full hash code and length of the key */
+    size_t uHash;
+    size_t uKeyLength;
+
+    /* The bucket to examine next, or NULL if the next step examines
+    psNode */
+    struct SymTableNode **ppsBucket;
+
+    /* The chain node to examine next */
+    struct SymTableNode *psNode;
+
+    /* 1 (TRUE) if the search is in the old array of a resize, and the
+    key's bucket in the new array is still to be searched */
+    int iInOldArray;
+};
+
+
+/* A SymTableIter is a position in the insertion order of a SymTable.
+   SymTableIters of the same SymTable are linked to form a list, so
+   that removing a node can move any that are about to visit it. */
+struct SymTableIter
+{
+    /* The SymTable being traversed */
+    SymTable_T oSymTable;
+
+    /* The next SymTableNode to visit, or NULL at the end */
+    struct SymTableNode *psNextNode;
+
+    /* The address of the next SymTableIter of the same SymTable. */
+    struct SymTableIter *psNextIter;
+};
+
+
+/* A SymTableMapping is one call of SymTable_mapParallel, shared by the
+   threads that carry it out. */
+struct SymTableMapping
+{
+    /* The SymTable being traversed */
+    SymTable_T oSymTable;
+
+    /* The function to apply to each binding, and its extra
+    parameter */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+
+/* A SymTableRehash is one parallel pass over the old array of a
+   resize, shared by the threads that carry it out. */
+struct SymTableRehash
+{
+    /* The SymTable being resized */
+    SymTable_T oSymTable;
+
+    /* The smaller of the old and new bucket counts */
+    size_t uStride;
+
+    /* Set to 1 (TRUE) if some chain of the new array reached
+    uTreeifyThreshold nodes */
+    int iLongChain;
 };
 
 
@@ -43,271 +243,1797 @@ struct SymTable
     /* The number of bindings in the SymTable */
     size_t length;
     
-    /* The index of the current bucket count in the 
-        global array of bucket counts*/
-    size_t uBucketCountIndex;
+    /* The number of buckets in the array, always a power of 2 */
+    size_t uBucketCount;
+
+    /* While the SymTable is being resized, the array whose buckets are
+    still being migrated into ppsArray. NULL otherwise. */
+    struct SymTableNode **ppsOldArray;
+
+    /* The number of buckets in ppsOldArray */
+    size_t uOldBucketCount;
+
+    /* Every bucket of ppsOldArray below this index has already been
+    migrated and is empty */
+    size_t uRehashIndex;
+
+    /* The slab chunks owned by the SymTable, most recent first */
+    struct SymTableChunk *psChunks;
+
+    /* The first unused byte of the most recent slab chunk */
+    char *pcSlabFree;
+
+    /* The number of unused bytes left in the most recent slab chunk */
+    size_t uSlabRemaining;
+
+    /* The size of the next slab chunk to allocate */
+    size_t uNextChunkSize;
+
+    /* Removed nodes and tree nodes awaiting reuse; apsFreeBlocks[i]
+    lists the blocks that occupy i+1 granules */
+    struct SymTableFreeBlock *apsFreeBlocks[SLAB_CLASS_COUNT];
+
+    /* The chunks that each hold one node too large for a free list */
+    struct SymTableChunk *psLargeChunks;
+
+    /* The secret seed under which the hash codes of keys are rehashed
+    before they are stored, so that keys colliding in one SymTable need
+    not collide in another */
+    uint64_t uSeed;
+
+    /* The least and most recently added SymTableNodes */
+    struct SymTableNode *psFirstInOrder;
+    struct SymTableNode *psLastInOrder;
+
+    /* The address of the first SymTableIter in use */
+    struct SymTableIter *psFirstIter;
 };
 
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1,
-   inclusive. */
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
+/* Return the full hash code in oSymTable of a key whose
+   table-independent hash code is uHash. */
+static size_t SymTable_tableHash(SymTable_T oSymTable,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+
+    return (size_t)SymHash_tableHash(uHash, oSymTable->uSeed);
+}
+
+
+/* Return the full hash code in oSymTable for pcKey, and store the
+   length of pcKey in *puKeyLength. */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t *puKeyLength)
+{
+    assert(pcKey != NULL);
+    assert(puKeyLength != NULL);
+
+    *puKeyLength = strlen(pcKey);
+    return SymTable_tableHash(oSymTable,
+        SymHash_hash(pcKey, *puKeyLength));
+}
+
+
+/* Return the full hash code in oSymTable for the uKeyLength bytes at
+   pcKey, which equals that of a string with the same characters. */
+static size_t SymTable_hashN(SymTable_T oSymTable, const char *pcKey,
+    size_t uKeyLength)
+{
+    assert(pcKey != NULL);
+
+    return SymTable_tableHash(oSymTable, SymHash_hash(pcKey, uKeyLength));
+}
+
+
+/* Return the index of the bucket for full hash code uHash in an array
+   of uBucketCount buckets, which must be a power of 2. */
+static size_t SymTable_bucketIndex(size_t uHash, size_t uBucketCount)
+{
+    return uHash & (uBucketCount - 1);
+}
+
+
+/* Return 1 (TRUE) if psNode holds the key pcKey, whose full hash code
+   is uHash and whose length is uKeyLength (or uUnknownKeyLength), and
+   0 (FALSE) otherwise. The key bytes are compared only if the hash
+   codes and lengths agree. */
+static int SymTable_nodeMatches(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    assert(psNode != NULL);
+    assert(pcKey != NULL);
+
+    if (psNode->uHash != uHash)
+        return 0;
+    /* a stored key containing '\0' only looks equal to the string */
+    if (uKeyLength == uUnknownKeyLength)
+        return strcmp(psNode->acKey, pcKey) == 0 &&
+            strlen(psNode->acKey) == psNode->uKeyLength;
+    return psNode->uKeyLength == uKeyLength &&
+        memcmp(psNode->acKey, pcKey, uKeyLength) == 0;
+}
+
+
+/* Return the number of granules occupied by a node whose key is
+   uKeyLength characters long. */
+static size_t SymTable_nodeGranules(size_t uKeyLength)
+{
+    return (sizeof(struct SymTableNode) + uKeyLength+1 +
+        uSlabGranule-1) / uSlabGranule;
+}
+
+
+/* Return the number of bytes at the start of a chunk taken by its
+   SymTableChunk, rounded up to a whole number of granules so that
+   every block keeps the alignment of the chunk itself. */
+static size_t SymTable_chunkHeaderSize(void)
+{
+    return (sizeof(struct SymTableChunk) + uSlabGranule-1) /
+        uSlabGranule * uSlabGranule;
+}
+
+
+/* Return a block of uGranules granules from oSymTable, reusing a
+   removed block of the same size if one exists. Return NULL if
+   insufficient memory is available. */
+static void *SymTable_allocBlock(SymTable_T oSymTable, size_t uGranules)
+{
+    size_t uSize;
+    size_t uChunkSize;
+    void *pvBlock;
+    struct SymTableFreeBlock *psBlock;
+    struct SymTableChunk *psChunk;
+
+    assert(oSymTable != NULL);
+
+    uSize = uGranules * uSlabGranule;
+
+    /* an oversized block gets a chunk of its own */
+    if (uGranules > SLAB_CLASS_COUNT) {
+        psChunk = (struct SymTableChunk *)
+            malloc(SymTable_chunkHeaderSize() + uSize);
+        if (psChunk == NULL)
+            return NULL;
+        psChunk->psPrevChunk = NULL;
+        psChunk->psNextChunk = oSymTable->psLargeChunks;
+        psChunk->uCarved = uSize;
+        if (oSymTable->psLargeChunks != NULL)
+            oSymTable->psLargeChunks->psPrevChunk = psChunk;
+        oSymTable->psLargeChunks = psChunk;
+        return (char *)psChunk + SymTable_chunkHeaderSize();
+    }
+
+    /* reuse a removed block of the same size */
+    psBlock = oSymTable->apsFreeBlocks[uGranules-1];
+    if (psBlock != NULL) {
+        oSymTable->apsFreeBlocks[uGranules-1] = psBlock->psNextBlock;
+        return psBlock;
+    }
+
+    /* start a new chunk if the current one is exhausted; its unused
+    tail is abandoned until the whole SymTable is freed */
+    if (oSymTable->uSlabRemaining < uSize) {
+        uChunkSize = oSymTable->uNextChunkSize;
+        psChunk = (struct SymTableChunk *)
+            malloc(SymTable_chunkHeaderSize() + uChunkSize);
+        if (psChunk == NULL)
+            return NULL;
+        psChunk->psPrevChunk = NULL;
+        psChunk->psNextChunk = oSymTable->psChunks;
+        psChunk->uCarved = 0;
+        oSymTable->psChunks = psChunk;
+        oSymTable->pcSlabFree =
+            (char *)psChunk + SymTable_chunkHeaderSize();
+        oSymTable->uSlabRemaining = uChunkSize;
+        if (uChunkSize < uSlabMaxChunkSize)
+            oSymTable->uNextChunkSize = uChunkSize * 2;
+    }
+
+    pvBlock = oSymTable->pcSlabFree;
+    oSymTable->pcSlabFree += uSize;
+    oSymTable->uSlabRemaining -= uSize;
+    oSymTable->psChunks->uCarved += uSize;
+    return pvBlock;
+}
+
+
+/* Give pvBlock, a block of uGranules granules that was allocated by
+   SymTable_allocBlock for oSymTable and is no longer in use, back to
+   oSymTable. */
+static void SymTable_freeBlock(SymTable_T oSymTable, void *pvBlock,
+    size_t uGranules)
+{
+    struct SymTableFreeBlock *psBlock;
+    struct SymTableChunk *psChunk;
+
+    assert(oSymTable != NULL);
+    assert(pvBlock != NULL);
+
+    /* an oversized block's chunk is released at once */
+    if (uGranules > SLAB_CLASS_COUNT) {
+        psChunk = (struct SymTableChunk *)
+            ((char *)pvBlock - SymTable_chunkHeaderSize());
+        if (psChunk->psPrevChunk == NULL)
+            oSymTable->psLargeChunks = psChunk->psNextChunk;
+        else
+            psChunk->psPrevChunk->psNextChunk = psChunk->psNextChunk;
+        if (psChunk->psNextChunk != NULL)
+            psChunk->psNextChunk->psPrevChunk = psChunk->psPrevChunk;
+        free(psChunk);
+        return;
+    }
+
+    psBlock = (struct SymTableFreeBlock *)pvBlock;
+    psBlock->psNextBlock = oSymTable->apsFreeBlocks[uGranules-1];
+    oSymTable->apsFreeBlocks[uGranules-1] = psBlock;
+}
+
+
+/* Return a node of oSymTable with room for a key of uKeyLength
+   characters, or NULL if insufficient memory is available. */
+static struct SymTableNode *SymTable_allocNode(SymTable_T oSymTable,
+    size_t uKeyLength)
+{
+    return (struct SymTableNode *)SymTable_allocBlock(oSymTable,
+        SymTable_nodeGranules(uKeyLength));
+}
+
+
+/* Give psNode, which was allocated by SymTable_allocNode for
+   oSymTable and is no longer linked into it, back to oSymTable. */
+static void SymTable_freeNode(SymTable_T oSymTable,
+    struct SymTableNode *psNode)
+{
+    assert(psNode != NULL);
+
+    SymTable_freeBlock(oSymTable, psNode,
+        SymTable_nodeGranules(psNode->uKeyLength));
+}
+
+
+/* Return the number of granules occupied by a tree node. */
+static size_t SymTable_treeNodeGranules(void)
+{
+    return (sizeof(struct SymTableTreeNode) + uSlabGranule-1) /
+        uSlabGranule;
+}
+
+
+/* Return a tree node of oSymTable that indexes psNode and has no
+   subtrees, or NULL if insufficient memory is available. */
+static struct SymTableTreeNode *SymTable_allocTreeNode(
+    SymTable_T oSymTable, struct SymTableNode *psNode)
+{
+    struct SymTableTreeNode *psTreeNode;
+
+    psTreeNode = (struct SymTableTreeNode *)SymTable_allocBlock(
+        oSymTable, SymTable_treeNodeGranules());
+    if (psTreeNode == NULL)
+        return NULL;
+    psTreeNode->psNode = psNode;
+    psTreeNode->psLeft = NULL;
+    psTreeNode->psRight = NULL;
+    psTreeNode->iHeight = 1;
+    return psTreeNode;
+}
+
+
+/* Give psTreeNode, which was allocated by SymTable_allocTreeNode for
+   oSymTable and is no longer linked into it, back to oSymTable. */
+static void SymTable_freeTreeNode(SymTable_T oSymTable,
+    struct SymTableTreeNode *psTreeNode)
+{
+    SymTable_freeBlock(oSymTable, psTreeNode,
+        SymTable_treeNodeGranules());
+}
+
+
+/* free every chunk in the list starting with psFirstChunk */
+static void SymTable_freeChunks(struct SymTableChunk *psFirstChunk)
+{
+    struct SymTableChunk *psCurrentChunk;
+    struct SymTableChunk *psNextChunk;
+
+    for (psCurrentChunk = psFirstChunk;
+        psCurrentChunk != NULL;
+        psCurrentChunk = psNextChunk)
+    {
+        psNextChunk = psCurrentChunk->psNextChunk;
+        free(psCurrentChunk);
+    }
+}
+
+
+
+/* Compare the SymTableChunkUses at pvFirst and pvSecond by the
+   addresses of their chunks, for qsort. */
+static int SymTable_compareChunkUse(const void *pvFirst,
+    const void *pvSecond)
+{
+    const char *pcFirst;
+    const char *pcSecond;
+
+    pcFirst = (const char *)
+        ((const struct SymTableChunkUse *)pvFirst)->psChunk;
+    pcSecond = (const char *)
+        ((const struct SymTableChunkUse *)pvSecond)->psChunk;
+    if (pcFirst < pcSecond)
+        return -1;
+    if (pcFirst > pcSecond)
+        return 1;
+    return 0;
+}
+
+
+/* Return the element of the array psUses of uUseCount
+   SymTableChunkUses, sorted by the addresses of their chunks, whose
+   chunk holds the block pvBlock. */
+static struct SymTableChunkUse *SymTable_findChunkUse(
+    struct SymTableChunkUse *psUses, size_t uUseCount,
+    const void *pvBlock)
+{
+    size_t uLow = 0;
+    size_t uHigh = uUseCount;
+    size_t uMiddle;
+
+    assert(psUses != NULL);
+    assert(uUseCount > 0);
+
+    /* the holding chunk is the last one that starts at or before
+    pvBlock */
+    while (uHigh - uLow > 1) {
+        uMiddle = uLow + (uHigh - uLow) / 2;
+        if ((const char *)psUses[uMiddle].psChunk <=
+            (const char *)pvBlock)
+            uLow = uMiddle;
+        else
+            uHigh = uMiddle;
+    }
+    return &psUses[uLow];
+}
+
+
+/* Free every slab chunk of oSymTable none of whose blocks is in use,
+   dropping its blocks from the free lists. If insufficient memory is
+   available to count the removed blocks, leave oSymTable unchanged. */
+static void SymTable_releaseChunks(SymTable_T oSymTable)
+{
+    size_t i;
+    size_t uChunkCount = 0;
+    struct SymTableChunkUse *psUses;
+    struct SymTableChunkUse *psUse;
+    struct SymTableChunk *psChunk;
+    struct SymTableChunk **ppsChunkLink;
+    struct SymTableChunk *psCarvingChunk;
+    struct SymTableFreeBlock *psBlock;
+    struct SymTableFreeBlock **ppsBlockLink;
+
+    assert(oSymTable != NULL);
+
+    for (psChunk = oSymTable->psChunks; psChunk != NULL;
+        psChunk = psChunk->psNextChunk)
+        uChunkCount++;
+    if (uChunkCount == 0)
+        return;
+
+    psUses = (struct SymTableChunkUse *)
+        malloc(uChunkCount * sizeof(struct SymTableChunkUse));
+    if (psUses == NULL)
+        return;
+    for (psChunk = oSymTable->psChunks, i = 0; psChunk != NULL;
+        psChunk = psChunk->psNextChunk, i++)
+    {
+        psUses[i].psChunk = psChunk;
+        psUses[i].uFree = 0;
+    }
+    qsort(psUses, uChunkCount, sizeof(struct SymTableChunkUse),
+        SymTable_compareChunkUse);
+
+    for (i=0; i<SLAB_CLASS_COUNT; i++)
+        for (psBlock = oSymTable->apsFreeBlocks[i]; psBlock != NULL;
+            psBlock = psBlock->psNextBlock)
+            SymTable_findChunkUse(psUses, uChunkCount, psBlock)->uFree +=
+                (i+1) * uSlabGranule;
+
+    /* a chunk is unused if every byte carved out of it is free */
+    for (i=0; i<SLAB_CLASS_COUNT; i++) {
+        ppsBlockLink = &oSymTable->apsFreeBlocks[i];
+        while (*ppsBlockLink != NULL) {
+            psUse = SymTable_findChunkUse(psUses, uChunkCount,
+                *ppsBlockLink);
+            if (psUse->uFree == psUse->psChunk->uCarved)
+                *ppsBlockLink = (*ppsBlockLink)->psNextBlock;
+            else
+                ppsBlockLink = &(*ppsBlockLink)->psNextBlock;
+        }
+    }
+
+    psCarvingChunk = oSymTable->psChunks;
+    ppsChunkLink = &oSymTable->psChunks;
+    while (*ppsChunkLink != NULL) {
+        psChunk = *ppsChunkLink;
+        psUse = SymTable_findChunkUse(psUses, uChunkCount, psChunk);
+        if (psUse->uFree != psChunk->uCarved) {
+            ppsChunkLink = &psChunk->psNextChunk;
+            continue;
+        }
+        /* the next block is then carved out of a new chunk */
+        if (psChunk == psCarvingChunk) {
+            oSymTable->pcSlabFree = NULL;
+            oSymTable->uSlabRemaining = 0;
+        }
+        *ppsChunkLink = psChunk->psNextChunk;
+        free(psChunk);
+    }
+
+    free(psUses);
+}
+
+/* Store in *puBucketCount the fewest buckets, a power of 2 and at
+   least uInitBucketCount, that uCapacity bindings do not outnumber,
+   and return 1 (TRUE). Return 0 (FALSE) if so many buckets could not
+   be indexed by a size_t. */
+static int SymTable_bucketCountFor(size_t uCapacity,
+    size_t *puBucketCount)
+{
+    size_t uBucketCount;
+
+    assert(puBucketCount != NULL);
+
+    for (uBucketCount = uInitBucketCount; uBucketCount < uCapacity;
+        uBucketCount *= 2)
+        if (uBucketCount >
+            (size_t)-1 / 2 / sizeof(struct SymTableNode *))
+            return 0;
+    *puBucketCount = uBucketCount;
+    return 1;
+}
+
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uBucketCount;
+    size_t i;
+
+    if (!SymTable_bucketCountFor(uCapacity, &uBucketCount))
+        return NULL;
+
+    /* initialize to uBucketCount buckets with each the size of a
+    pointer */
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+    
+    oSymTable->ppsArray = (struct SymTableNode **)
+        calloc(uBucketCount, sizeof(struct SymTableNode *));
+    if (oSymTable->ppsArray == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    
+    /* intialize all buckets to NULL */
+    for (i=0; i<uBucketCount; i++) {
+        oSymTable->ppsArray[i] = NULL;
+    }
+    oSymTable->uBucketCount = uBucketCount;
+    oSymTable->ppsOldArray = NULL;
+    oSymTable->uOldBucketCount = 0;
+    oSymTable->uRehashIndex = 0;
+    oSymTable->psChunks = NULL;
+    oSymTable->pcSlabFree = NULL;
+    oSymTable->uSlabRemaining = 0;
+    oSymTable->uNextChunkSize = uSlabMinChunkSize;
+    for (i=0; i<SLAB_CLASS_COUNT; i++) {
+        oSymTable->apsFreeBlocks[i] = NULL;
+    }
+    oSymTable->psLargeChunks = NULL;
+    oSymTable->uSeed = SymHash_newSeed();
+    oSymTable->psFirstInOrder = NULL;
+    oSymTable->psLastInOrder = NULL;
+    oSymTable->psFirstIter = NULL;
+    oSymTable->length = 0;
+    return oSymTable;
+}
+
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+    assert(oSymTable->psFirstIter == NULL);
+
+    /* every node lives in one of the chunks, so the buckets need not
+    be visited */
+    SymTable_freeChunks(oSymTable->psChunks);
+    SymTable_freeChunks(oSymTable->psLargeChunks);
+
+    free(oSymTable->ppsOldArray);
+    free(oSymTable->ppsArray);
+    free(oSymTable);
+}
+
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    return oSymTable->length;
+}
+
+
+/* Return 1 (TRUE) if the bucket psBucket holds a tree bin, and
+   0 (FALSE) if it holds a chain. */
+static int SymTable_isTree(const struct SymTableNode *psBucket)
+{
+    return ((uintptr_t)psBucket & 1) != 0;
+}
+
+
+/* Return the root of the tree bin held by the bucket psBucket. */
+static struct SymTableTreeNode *SymTable_treeRoot(
+    struct SymTableNode *psBucket)
+{
+    assert(SymTable_isTree(psBucket));
+
+    return (struct SymTableTreeNode *)((uintptr_t)psBucket - 1);
+}
+
+
+/* Return the bucket contents that hold the tree bin rooted at
+   psRoot. */
+static struct SymTableNode *SymTable_treeBucket(
+    struct SymTableTreeNode *psRoot)
+{
+    assert(psRoot != NULL);
+
+    return (struct SymTableNode *)((uintptr_t)psRoot | 1);
+}
+
+
+/* Return a negative number, 0, or a positive number according to
+   whether the key pcKey, whose full hash code is uHash and whose
+   length is uKeyLength, orders before, with, or after the key of
+   psNode. Keys order by hash code, then by their bytes, then by
+   length. */
+static int SymTable_compareKey(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    int iCompare;
+
+    assert(psNode != NULL);
+    assert(pcKey != NULL);
+
+    if (uHash != psNode->uHash)
+        return uHash < psNode->uHash ? -1 : 1;
+    iCompare = memcmp(pcKey, psNode->acKey,
+        uKeyLength < psNode->uKeyLength ? uKeyLength : psNode->uKeyLength);
+    if (iCompare != 0)
+        return iCompare;
+    return (uKeyLength > psNode->uKeyLength) -
+        (uKeyLength < psNode->uKeyLength);
+}
+
+
+/* Return the height of the subtree psTreeNode, which may be NULL. */
+static int SymTable_treeHeight(const struct SymTableTreeNode *psTreeNode)
+{
+    return psTreeNode == NULL ? 0 : psTreeNode->iHeight;
+}
+
+
+/* Recompute the height of psTreeNode from its subtrees. */
+static void SymTable_treeUpdate(struct SymTableTreeNode *psTreeNode)
+{
+    int iLeftHeight;
+    int iRightHeight;
+
+    assert(psTreeNode != NULL);
+
+    iLeftHeight = SymTable_treeHeight(psTreeNode->psLeft);
+    iRightHeight = SymTable_treeHeight(psTreeNode->psRight);
+    psTreeNode->iHeight = 1 + (iLeftHeight > iRightHeight ?
+        iLeftHeight : iRightHeight);
+}
+
+
+/* Rotate the subtree rooted at psTreeNode to the left and return its
+   new root. */
+static struct SymTableTreeNode *SymTable_treeRotateLeft(
+    struct SymTableTreeNode *psTreeNode)
+{
+    struct SymTableTreeNode *psRight;
+
+    assert(psTreeNode != NULL);
+    assert(psTreeNode->psRight != NULL);
+
+    psRight = psTreeNode->psRight;
+    psTreeNode->psRight = psRight->psLeft;
+    psRight->psLeft = psTreeNode;
+    SymTable_treeUpdate(psTreeNode);
+    SymTable_treeUpdate(psRight);
+    return psRight;
+}
+
+
+/* Rotate the subtree rooted at psTreeNode to the right and return its
+   new root. */
+static struct SymTableTreeNode *SymTable_treeRotateRight(
+    struct SymTableTreeNode *psTreeNode)
+{
+    struct SymTableTreeNode *psLeft;
+
+    assert(psTreeNode != NULL);
+    assert(psTreeNode->psLeft != NULL);
+
+    psLeft = psTreeNode->psLeft;
+    psTreeNode->psLeft = psLeft->psRight;
+    psLeft->psRight = psTreeNode;
+    SymTable_treeUpdate(psTreeNode);
+    SymTable_treeUpdate(psLeft);
+    return psLeft;
+}
+
+
+/* Rebalance the subtree rooted at psTreeNode, whose own subtrees are
+   balanced and differ in height by at most 2, and return its new
+   root. */
+static struct SymTableTreeNode *SymTable_treeBalance(
+    struct SymTableTreeNode *psTreeNode)
+{
+    int iBalance;
+
+    assert(psTreeNode != NULL);
+
+    iBalance = SymTable_treeHeight(psTreeNode->psLeft) -
+        SymTable_treeHeight(psTreeNode->psRight);
+
+    if (iBalance > 1) {
+        if (SymTable_treeHeight(psTreeNode->psLeft->psLeft) <
+            SymTable_treeHeight(psTreeNode->psLeft->psRight))
+            psTreeNode->psLeft =
+                SymTable_treeRotateLeft(psTreeNode->psLeft);
+        return SymTable_treeRotateRight(psTreeNode);
+    }
+    if (iBalance < -1) {
+        if (SymTable_treeHeight(psTreeNode->psRight->psRight) <
+            SymTable_treeHeight(psTreeNode->psRight->psLeft))
+            psTreeNode->psRight =
+                SymTable_treeRotateRight(psTreeNode->psRight);
+        return SymTable_treeRotateLeft(psTreeNode);
+    }
+
+    SymTable_treeUpdate(psTreeNode);
+    return psTreeNode;
+}
+
+
+/* Insert psNew, whose key is not yet in the tree, into the tree
+   rooted at psRoot, which may be NULL, and return the new root. */
+static struct SymTableTreeNode *SymTable_treeInsert(
+    struct SymTableTreeNode *psRoot, struct SymTableTreeNode *psNew)
+{
+    const struct SymTableNode *psNode;
+
+    assert(psNew != NULL);
+
+    if (psRoot == NULL)
+        return psNew;
+
+    psNode = psNew->psNode;
+    if (SymTable_compareKey(psRoot->psNode, psNode->acKey, psNode->uHash,
+        psNode->uKeyLength) < 0)
+        psRoot->psLeft = SymTable_treeInsert(psRoot->psLeft, psNew);
+    else
+        psRoot->psRight = SymTable_treeInsert(psRoot->psRight, psNew);
+    return SymTable_treeBalance(psRoot);
+}
+
+
+/* Detach the leftmost tree node of the tree rooted at psRoot, which
+   must not be NULL, store its address in *ppsMin, and return the new
+   root. */
+static struct SymTableTreeNode *SymTable_treeRemoveMin(
+    struct SymTableTreeNode *psRoot, struct SymTableTreeNode **ppsMin)
+{
+    assert(psRoot != NULL);
+    assert(ppsMin != NULL);
+
+    if (psRoot->psLeft == NULL) {
+        *ppsMin = psRoot;
+        return psRoot->psRight;
+    }
+    psRoot->psLeft = SymTable_treeRemoveMin(psRoot->psLeft, ppsMin);
+    return SymTable_treeBalance(psRoot);
+}
+
+
+/* Detach the tree node that indexes psNode from the tree rooted at
+   psRoot, which must contain it, store the tree node's address in
+   *ppsRemoved, and return the new root. */
+static struct SymTableTreeNode *SymTable_treeRemove(
+    struct SymTableTreeNode *psRoot, const struct SymTableNode *psNode,
+    struct SymTableTreeNode **ppsRemoved)
+{
+    struct SymTableTreeNode *psMin;
+    int iCompare;
+
+    assert(psRoot != NULL);
+    assert(psNode != NULL);
+    assert(ppsRemoved != NULL);
+
+    if (psRoot->psNode == psNode) {
+        *ppsRemoved = psRoot;
+        if (psRoot->psLeft == NULL)
+            return psRoot->psRight;
+        if (psRoot->psRight == NULL)
+            return psRoot->psLeft;
+        /* the successor takes the removed tree node's place */
+        psRoot->psRight = SymTable_treeRemoveMin(psRoot->psRight, &psMin);
+        psMin->psLeft = psRoot->psLeft;
+        psMin->psRight = psRoot->psRight;
+        return SymTable_treeBalance(psMin);
+    }
+
+    iCompare = SymTable_compareKey(psRoot->psNode, psNode->acKey,
+        psNode->uHash, psNode->uKeyLength);
+    if (iCompare < 0)
+        psRoot->psLeft = SymTable_treeRemove(psRoot->psLeft, psNode,
+            ppsRemoved);
+    else
+        psRoot->psRight = SymTable_treeRemove(psRoot->psRight, psNode,
+            ppsRemoved);
+    return SymTable_treeBalance(psRoot);
+}
+
+
+/* Give the tree nodes of the tree rooted at psRoot, which may be
+   NULL, back to oSymTable, leaving the nodes they index untouched. */
+static void SymTable_freeTree(SymTable_T oSymTable,
+    struct SymTableTreeNode *psRoot)
+{
+    struct SymTableTreeNode *psRight;
+
+    while (psRoot != NULL) {
+        SymTable_freeTree(oSymTable, psRoot->psLeft);
+        psRight = psRoot->psRight;
+        SymTable_freeTreeNode(oSymTable, psRoot);
+        psRoot = psRight;
+    }
+}
+
+
+/* Push the nodes indexed by the tree rooted at psRoot, which may be
+   NULL, onto the front of the chain *ppsChain, and give the tree nodes
+   back to oSymTable. */
+static void SymTable_treeToChain(SymTable_T oSymTable,
+    struct SymTableTreeNode *psRoot, struct SymTableNode **ppsChain)
+{
+    struct SymTableTreeNode *psRight;
+
+    assert(ppsChain != NULL);
+
+    while (psRoot != NULL) {
+        SymTable_treeToChain(oSymTable, psRoot->psLeft, ppsChain);
+        psRoot->psNode->psNextNode = *ppsChain;
+        *ppsChain = psRoot->psNode;
+        psRight = psRoot->psRight;
+        SymTable_freeTreeNode(oSymTable, psRoot);
+        psRoot = psRight;
+    }
+}
+
+
+/* Convert the tree bin in *ppsBucket back into a chain. */
+static void SymTable_untreeify(SymTable_T oSymTable,
+    struct SymTableNode **ppsBucket)
+{
+    struct SymTableNode *psChain = NULL;
+
+    assert(ppsBucket != NULL);
+
+    SymTable_treeToChain(oSymTable, SymTable_treeRoot(*ppsBucket),
+        &psChain);
+    *ppsBucket = psChain;
+}
+
+
+/* Convert the chain in *ppsBucket into a tree bin. If insufficient
+   memory is available, leave the chain as it is. */
+static void SymTable_treeify(SymTable_T oSymTable,
+    struct SymTableNode **ppsBucket)
+{
+    struct SymTableNode *psNode;
+    struct SymTableNode *psNextNode;
+    struct SymTableTreeNode *psTreeNode;
+    struct SymTableTreeNode *psRoot = NULL;
+
+    assert(oSymTable != NULL);
+    assert(ppsBucket != NULL);
+    assert(! SymTable_isTree(*ppsBucket));
+
+    /* the nodes stay in the chain until every tree node has been
+    allocated, so that a failure can be undone */
+    for (psNode = *ppsBucket; psNode != NULL; psNode = psNode->psNextNode)
+    {
+        psTreeNode = SymTable_allocTreeNode(oSymTable, psNode);
+        if (psTreeNode == NULL) {
+            SymTable_freeTree(oSymTable, psRoot);
+            return;
+        }
+        psRoot = SymTable_treeInsert(psRoot, psTreeNode);
+    }
+
+    for (psNode = *ppsBucket; psNode != NULL; psNode = psNextNode) {
+        psNextNode = psNode->psNextNode;
+        psNode->psNextNode = NULL;
+    }
+    *ppsBucket = SymTable_treeBucket(psRoot);
+}
+
+
+/* Return 1 (TRUE) if the chain that starts at psNode, which may be
+   NULL, has at least uTreeifyThreshold nodes, and 0 (FALSE)
+   otherwise. */
+static int SymTable_isLongChain(const struct SymTableNode *psNode)
+{
+    size_t uChainLength;
+
+    for (uChainLength = 0;
+        psNode != NULL && uChainLength < uTreeifyThreshold;
+        psNode = psNode->psNextNode)
+        uChainLength++;
+    return uChainLength == uTreeifyThreshold;
+}
+
+
+/* Add psNode, whose key is in no bucket of oSymTable, to the bucket
+   *ppsBucket, converting the bucket between a chain and a tree bin
+   as needed. */
+static void SymTable_addToBucket(SymTable_T oSymTable,
+    struct SymTableNode **ppsBucket, struct SymTableNode *psNode)
+{
+    struct SymTableTreeNode *psTreeNode;
+
+    assert(oSymTable != NULL);
+    assert(ppsBucket != NULL);
+    assert(psNode != NULL);
+
+    if (SymTable_isTree(*ppsBucket)) {
+        psTreeNode = SymTable_allocTreeNode(oSymTable, psNode);
+        if (psTreeNode != NULL) {
+            psNode->psNextNode = NULL;
+            *ppsBucket = SymTable_treeBucket(SymTable_treeInsert(
+                SymTable_treeRoot(*ppsBucket), psTreeNode));
+            return;
+        }
+        /* without memory for a tree node, fall back on a chain, which
+        is converted back into a tree by a later insertion */
+        SymTable_untreeify(oSymTable, ppsBucket);
+    }
+
+    psNode->psNextNode = *ppsBucket;
+    *ppsBucket = psNode;
+
+    if (SymTable_isLongChain(psNode))
+        SymTable_treeify(oSymTable, ppsBucket);
+}
+
+
+/* Move every node of the tree rooted at psRoot, which may be NULL,
+into the new array of oSymTable, using the stored hash codes, and
+give the tree nodes back to oSymTable. */
+static void SymTable_moveTree(SymTable_T oSymTable,
+    struct SymTableTreeNode *psRoot)
+{
+    struct SymTableTreeNode *psRight;
+    struct SymTableNode *psNode;
+
+    while (psRoot != NULL) {
+        SymTable_moveTree(oSymTable, psRoot->psLeft);
+        psNode = psRoot->psNode;
+        psRight = psRoot->psRight;
+        /* freed first, so that a tree bin in the new array can reuse
+        the tree node without allocating */
+        SymTable_freeTreeNode(oSymTable, psRoot);
+        SymTable_addToBucket(oSymTable, &oSymTable->ppsArray[
+            SymTable_bucketIndex(psNode->uHash, oSymTable->uBucketCount)],
+            psNode);
+        psRoot = psRight;
+    }
+}
+
+
+/* Move every node of the bucket contents psBucket, a chain or a tree
+bin of the old array of oSymTable, into the new array, using the
+stored hash codes. */
+static void SymTable_moveBucket(SymTable_T oSymTable,
+    struct SymTableNode *psBucket)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+
+    assert(oSymTable != NULL);
+
+    if (SymTable_isTree(psBucket)) {
+        SymTable_moveTree(oSymTable, SymTable_treeRoot(psBucket));
+        return;
+    }
+
+    for(psCurrentNode = psBucket;
+        psCurrentNode != NULL;
+        psCurrentNode = psNextNode) 
+    {
+        psNextNode = psCurrentNode->psNextNode;
+
+        /* redistribute using the stored hash code; the key
+        itself is never touched */
+        SymTable_addToBucket(oSymTable, &oSymTable->ppsArray[
+            SymTable_bucketIndex(psCurrentNode->uHash,
+                oSymTable->uBucketCount)], psCurrentNode);
+    }
+}
+
+
+/* If oSymTable is being resized, migrate a bounded number of buckets
+from the old array into the new one, and release the old array once
+it is empty. Otherwise, leave oSymTable unchanged. */
+static void SymTable_rehashStep(SymTable_T oSymTable)
+{
+    size_t uMigrated = 0;
+    size_t uEmptyVisited = 0;
+    struct SymTableNode *psFirstNode;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->ppsOldArray == NULL)
+        return;
+
+    while (oSymTable->uRehashIndex < oSymTable->uOldBucketCount &&
+        uMigrated < uRehashBucketsPerStep &&
+        uEmptyVisited < uRehashEmptyVisits)
+    {
+        psFirstNode = oSymTable->ppsOldArray[oSymTable->uRehashIndex];
+        if (psFirstNode == NULL)
+            uEmptyVisited++;
+        else {
+            SymTable_moveBucket(oSymTable, psFirstNode);
+            oSymTable->ppsOldArray[oSymTable->uRehashIndex] = NULL;
+            uMigrated++;
+        }
+        oSymTable->uRehashIndex++;
+    }
+
+    if (oSymTable->uRehashIndex == oSymTable->uOldBucketCount) {
+        free(oSymTable->ppsOldArray);
+        oSymTable->ppsOldArray = NULL;
+        oSymTable->uOldBucketCount = 0;
+        oSymTable->uRehashIndex = 0;
+    }
+}
+
+
+/* Start moving the bindings of oSymTable into a new array of
+uNewBucketCount buckets, a power of 2: allocate the new array and make
+the current one the old array, whose buckets SymTable_rehashStep then
+migrates a few at a time, and return 1 (TRUE). If a resize is
+already in progress or insufficient memory is available, leave
+oSymTable unchanged and return 0 (FALSE). */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewBucketCount)
+{
+    struct SymTableNode **ppsNewArray;
+
+    assert(oSymTable != NULL);
+    assert(uNewBucketCount >= uInitBucketCount);
+
+    /* the previous resize must finish before the next one starts */
+    if (oSymTable->ppsOldArray != NULL)
+        return 0;
+
+    /* allocate memory for newly-sized array of pointers; calloc
+    leaves every bucket empty without a pass over the array */
+    ppsNewArray = (struct SymTableNode **) 
+        calloc(uNewBucketCount, sizeof(struct SymTableNode *));
+    if (ppsNewArray == NULL)
+        return 0;
+
+    oSymTable->ppsOldArray = oSymTable->ppsArray;
+    oSymTable->uOldBucketCount = oSymTable->uBucketCount;
+    oSymTable->uRehashIndex = 0;
+    oSymTable->ppsArray = ppsNewArray;
+    oSymTable->uBucketCount = uNewBucketCount;
+    return 1;
+}
+
+
+/* Move the chains in the old buckets r, r + uStride, r + 2 * uStride,
+   ... of the table of the SymTableRehash pvRehash into its new array,
+   for each r from uBegin through uEnd - 1. Since uStride is the smaller
+   of the two bucket counts, both powers of 2, those nodes go only to
+   new buckets whose indices are also r modulo uStride, so that threads
+   given disjoint ranges of r never write the same bucket or node.
+   Tree bins, and nodes bound for a tree bin, stay in the old array:
+   moving them allocates or frees tree nodes, which only one thread at
+   a time may do. Chains that grow long are reported in iLongChain,
+   not treeified, for the same reason. */
+static void SymTable_rehashRange(size_t uBegin, size_t uEnd,
+    void *pvRehash)
+{
+    struct SymTableRehash *psRehash = (struct SymTableRehash *)pvRehash;
+    SymTable_T oSymTable;
+    struct SymTableNode **ppsBucket;
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+    struct SymTableNode *psLeft;
+    size_t r;
+    size_t i;
+
+    assert(psRehash != NULL);
+
+    oSymTable = psRehash->oSymTable;
+    for (r = uBegin; r < uEnd; r++) {
+        for (i = r; i < oSymTable->uOldBucketCount; i += psRehash->uStride)
+        {
+            if (SymTable_isTree(oSymTable->ppsOldArray[i]))
+                continue;
+            psLeft = NULL;
+            for (psCurrentNode = oSymTable->ppsOldArray[i];
+                psCurrentNode != NULL; psCurrentNode = psNextNode) {
+                psNextNode = psCurrentNode->psNextNode;
+                ppsBucket = &oSymTable->ppsArray[SymTable_bucketIndex(
+                    psCurrentNode->uHash, oSymTable->uBucketCount)];
+                if (SymTable_isTree(*ppsBucket)) {
+                    psCurrentNode->psNextNode = psLeft;
+                    psLeft = psCurrentNode;
+                    continue;
+                }
+                psCurrentNode->psNextNode = *ppsBucket;
+                *ppsBucket = psCurrentNode;
+                /* only a chain that already had a node can have grown
+                long, which keeps empty buckets unread */
+                if (psCurrentNode->psNextNode != NULL &&
+                    SymTable_isLongChain(psCurrentNode))
+                    __atomic_store_n(&psRehash->iLongChain, 1,
+                        __ATOMIC_RELAXED);
+            }
+            oSymTable->ppsOldArray[i] = psLeft;
+        }
+    }
+}
+
+
+/* Convert every chain of the array of oSymTable that has reached
+   uTreeifyThreshold nodes into a tree bin. */
+static void SymTable_treeifyLongChains(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    for (i = 0; i < oSymTable->uBucketCount; i++)
+        if (!SymTable_isTree(oSymTable->ppsArray[i]) &&
+            SymTable_isLongChain(oSymTable->ppsArray[i]))
+            SymTable_treeify(oSymTable, &oSymTable->ppsArray[i]);
+}
+
+
+/* Finish the resize of oSymTable in progress, if any, at once. The
+chains of an old array of at least uParallelRehashBuckets buckets are
+moved on several threads first; whatever they leave behind is then
+migrated as usual. */
+static void SymTable_finishResize(SymTable_T oSymTable)
+{
+    struct SymTableRehash sRehash;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->ppsOldArray != NULL &&
+        oSymTable->uOldBucketCount >= uParallelRehashBuckets) {
+        sRehash.oSymTable = oSymTable;
+        sRehash.uStride =
+            oSymTable->uBucketCount < oSymTable->uOldBucketCount ?
+            oSymTable->uBucketCount : oSymTable->uOldBucketCount;
+        sRehash.iLongChain = 0;
+        SymParallel_run(sRehash.uStride, SymTable_rehashRange, &sRehash,
+            SymParallel_threadCount());
+        if (sRehash.iLongChain)
+            SymTable_treeifyLongChains(oSymTable);
+    }
+
+    while (oSymTable->ppsOldArray != NULL)
+        SymTable_rehashStep(oSymTable);
+}
+
+
+/* Start doubling the bucket count of oSymTable, unless the doubled
+array could not be indexed by a size_t. */
+static void SymTable_expand(SymTable_T oSymTable) {
+    size_t oldBucketCount;
+    size_t newBucketCount;
+
+    assert(oSymTable != NULL);
+
+    oldBucketCount = oSymTable->uBucketCount;
+    newBucketCount = oldBucketCount * 2;
+
+    /* check that the doubled array size is representable */
+    if (newBucketCount / 2 != oldBucketCount ||
+        newBucketCount > (size_t)-1 / sizeof(struct SymTableNode *))
+        return;
+
+    (void)SymTable_resize(oSymTable, newBucketCount);
+}
+
+
+/* Start halving the bucket count of oSymTable if fewer than a quarter
+of its buckets would be used and it has more than uInitBucketCount.
+The bucket count doubles only once the bindings outnumber the buckets,
+so a halved array is at most half full and a table whose length hovers
+around one threshold does not resize back and forth. */
+static void SymTable_contract(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    if (oSymTable->uBucketCount > uInitBucketCount &&
+        oSymTable->length < oSymTable->uBucketCount / 4)
+        (void)SymTable_resize(oSymTable, oSymTable->uBucketCount / 2);
+}
+
+
+/*
+return the node in the bucket contents psBucket, a chain or a tree
+bin, whose key is pcKey, given the full hash code uHash and length
+uKeyLength (or uUnknownKeyLength) of pcKey. If no node matches,
+return NULL.
+*/
+static struct SymTableNode *SymTable_searchBucket(
+    struct SymTableNode *psBucket, const char *pcKey, size_t uHash,
+    size_t uKeyLength)
+{
+    const struct SymTableTreeNode *psTreeNode;
+    int iCompare;
+
+    assert(pcKey != NULL);
+
+    if (! SymTable_isTree(psBucket)) {
+        for (; psBucket != NULL; psBucket = psBucket->psNextNode)
+        {
+            if (SymTable_nodeMatches(psBucket, pcKey, uHash, uKeyLength))
+                return psBucket;
+        }
+        return NULL;
+    }
+
+    /* a tree bin orders keys by their bytes, so the length is
+    needed before the first comparison */
+    if (uKeyLength == uUnknownKeyLength)
+        uKeyLength = strlen(pcKey);
+
+    psTreeNode = SymTable_treeRoot(psBucket);
+    while (psTreeNode != NULL) {
+        iCompare = SymTable_compareKey(psTreeNode->psNode, pcKey, uHash,
+            uKeyLength);
+        if (iCompare == 0)
+            return psTreeNode->psNode;
+        psTreeNode = iCompare < 0 ? psTreeNode->psLeft :
+            psTreeNode->psRight;
+    }
+    return NULL;
+}
+
+
+/*
+return the address of the bucket of oSymTable that holds the node
+whose key is pcKey, given the full hash code uHash and length
+uKeyLength (or uUnknownKeyLength) of pcKey, and store the node's
+address in *ppsNode. If no matching key exists in the symbol table,
+store NULL in *ppsNode and return the address of the bucket of the
+new array that the key would go into.
+*/
+static struct SymTableNode **SymTable_findBucket(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength,
+    struct SymTableNode **ppsNode)
+{
+    struct SymTableNode **ppsBucket;
+    size_t bucketIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(ppsNode != NULL);
+
+    /* during a resize, a binding lives in the old array until its
+    bucket has been migrated */
+    if (oSymTable->ppsOldArray != NULL) {
+        bucketIndex = SymTable_bucketIndex(uHash,
+            oSymTable->uOldBucketCount);
+        if (bucketIndex >= oSymTable->uRehashIndex) {
+            ppsBucket = &oSymTable->ppsOldArray[bucketIndex];
+            *ppsNode = SymTable_searchBucket(*ppsBucket, pcKey, uHash,
+                uKeyLength);
+            if (*ppsNode != NULL)
+                return ppsBucket;
+        }
+    }
+
+    bucketIndex = SymTable_bucketIndex(uHash, oSymTable->uBucketCount);
+    ppsBucket = &oSymTable->ppsArray[bucketIndex];
+    *ppsNode = SymTable_searchBucket(*ppsBucket, pcKey, uHash,
+        uKeyLength);
+    return ppsBucket;
+}
+
+
+/*
+return a pointer to the SymTableNode in oSymTable whose key is pcKey. 
+If no matching key exists in the symbol table, return NULL.
+*/
+static struct SymTableNode *SymTable_getNode(SymTable_T oSymTable, 
+    const char *pcKey)
+{
+    struct SymTableNode *psNode;
+    size_t uHash;
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_rehashStep(oSymTable);
+
+    uHash = SymTable_hash(oSymTable, pcKey, &uKeyLength);
+    SymTable_findBucket(oSymTable, pcKey, uHash, uKeyLength, &psNode);
+    return psNode;
+}
+
+
+/*
+return a pointer to the SymTableNode in oSymTable whose key is the
+uKeyLength bytes at pcKey. If no matching key exists in the symbol
+table, return NULL.
+*/
+static struct SymTableNode *SymTable_getNodeN(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength)
+{
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    SymTable_rehashStep(oSymTable);
+
+    SymTable_findBucket(oSymTable, pcKey,
+        SymTable_hashN(oSymTable, pcKey, uKeyLength), uKeyLength, &psNode);
+    return psNode;
+}
+
+
+/*
+return a pointer to the SymTableNode in oSymTable whose key is pcKey,
+given the full hash code uHash and length uKeyLength (or
+uUnknownKeyLength) of pcKey, and set *piInserted to 0 (FALSE). If no
+such node exists, add one with value pvDefault, set *piInserted to
+1 (TRUE), and return it. If insufficient memory is available, leave
+oSymTable unchanged, set *piInserted to 0 (FALSE), and return NULL.
+*/
+static struct SymTableNode *SymTable_findOrInsertNode(
+    SymTable_T oSymTable, const char *pcKey, size_t uHash,
+    size_t uKeyLength, const void *pvDefault, int *piInserted)
+{
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    *piInserted = 0;
+
+    SymTable_rehashStep(oSymTable);
+
+    /* search the key's bucket exactly once */
+    SymTable_findBucket(oSymTable, pcKey, uHash, uKeyLength, &psNode);
+    if (psNode != NULL)
+        return psNode;
+
+    /* the key is about to be copied, so its length is needed now */
+    if (uKeyLength == uUnknownKeyLength)
+        uKeyLength = strlen(pcKey);
+
+    /* start expanding SymTable if necessary */
+    if (oSymTable->length >= oSymTable->uBucketCount)
+        SymTable_expand(oSymTable);
+
+    /* allocate the node together with room for its key */
+    psNode = SymTable_allocNode(oSymTable, uKeyLength);
+    if (psNode == NULL)
+        return NULL;
+
+    /* create defensive copy of key, which need not end in '\0' */
+    memcpy(psNode->acKey, pcKey, uKeyLength);
+    psNode->acKey[uKeyLength] = '\0';
+    psNode->uHash = uHash;
+    psNode->uKeyLength = uKeyLength;
+
+    /* assign value */
+    psNode->pvValue = pvDefault;
+
+    /* new bindings always go into the new array during a resize */
+    SymTable_addToBucket(oSymTable, &oSymTable->ppsArray[
+        SymTable_bucketIndex(uHash, oSymTable->uBucketCount)], psNode);
+
+    /* append the node to the insertion order */
+    psNode->psNextInOrder = NULL;
+    psNode->psPrevInOrder = oSymTable->psLastInOrder;
+    if (oSymTable->psLastInOrder == NULL)
+        oSymTable->psFirstInOrder = psNode;
+    else
+        oSymTable->psLastInOrder->psNextInOrder = psNode;
+    oSymTable->psLastInOrder = psNode;
+    /* increment length of SymTable */
+    oSymTable->length += 1;
+    *piInserted = 1;
+    return psNode;
+}
+
+
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvDefault, int *piInserted)
+{
+    struct SymTableNode *psNode;
+    size_t uHash;
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    /* hash the key exactly once */
+    uHash = SymTable_hash(oSymTable, pcKey, &uKeyLength);
+    psNode = SymTable_findOrInsertNode(oSymTable, pcKey, uHash,
+        uKeyLength, pvDefault, piInserted);
+    if (psNode == NULL)
+        return NULL;
+    return (void **) &psNode->pvValue;
+}
+
+
+int SymTable_put(SymTable_T oSymTable, 
+    const char *pcKey, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+    const void **apvValues, size_t uCount, int *aiResults)
+{
+    size_t auHash[BATCH_WINDOW];
+    size_t auKeyLength[BATCH_WINDOW];
+    size_t i;
+    size_t uIndex;
+    size_t uAdded = 0;
+    int iInserted;
+    struct SymTableNode *psBucket;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvValues != NULL);
+
+    /* size the table for the whole batch at once; without memory for
+    that, it grows as SymTable_put would grow it */
+    if (uCount <= (size_t)-1 - oSymTable->length)
+        (void)SymTable_reserve(oSymTable, oSymTable->length + uCount);
+
+    /* each pass inserts one key, examines the bucket of the key
+    BATCH_WINDOW/2 behind the newest, and hashes the newest, so
+    auHash and auKeyLength hold each key's entries from its hashing
+    until its insertion */
+    for (i = 0; i < uCount + BATCH_WINDOW; i++) {
+        if (i >= BATCH_WINDOW) {
+            uIndex = i - BATCH_WINDOW;
+            (void)SymTable_findOrInsertNode(oSymTable, apcKeys[uIndex],
+                auHash[uIndex % BATCH_WINDOW],
+                auKeyLength[uIndex % BATCH_WINDOW], apvValues[uIndex],
+                &iInserted);
+            if (aiResults != NULL)
+                aiResults[uIndex] = iInserted;
+            uAdded += (size_t)iInserted;
+        }
+
+        /* the bucket prefetched earlier has arrived by now; a tree
+        bin's tag bit leaves the address in its root's first line */
+        if (i >= BATCH_WINDOW/2 && i - BATCH_WINDOW/2 < uCount) {
+            uIndex = i - BATCH_WINDOW/2;
+            psBucket = oSymTable->ppsArray[SymTable_bucketIndex(
+                auHash[uIndex % BATCH_WINDOW], oSymTable->uBucketCount)];
+            if (psBucket != NULL)
+                SymTable_prefetch(psBucket);
+        }
+
+        if (i < uCount) {
+            assert(apcKeys[i] != NULL);
+            auHash[i % BATCH_WINDOW] = SymTable_hash(oSymTable,
+                apcKeys[i], &auKeyLength[i % BATCH_WINDOW]);
+            SymTable_prefetch(&oSymTable->ppsArray[SymTable_bucketIndex(
+                auHash[i % BATCH_WINDOW], oSymTable->uBucketCount)]);
+        }
+    }
+    return uAdded;
+}
+
+
+SymTable_Hash_T SymTable_hashKey(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return SymHash_hash(pcKey, strlen(pcKey));
+}
+
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash, const void *pvValue)
 {
-    const size_t HASH_MULTIPLIER = 65599;
-    size_t u;
-    size_t uHash = 0;
+    int iInserted;
 
+    assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    for (u = 0; pcKey[u] != '\0'; u++)
-        uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
-
-    return uHash % uBucketCount;
+    (void)SymTable_findOrInsertNode(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength, pvValue,
+        &iInserted);
+    return iInserted;
 }
 
 
-SymTable_T SymTable_new(void)
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
 {
-    SymTable_T oSymTable;
-    const size_t uInitBucketCount = auBucketCounts[0];
-    size_t i;
+    struct SymTableNode *node;
+    const void *pvOldValue;
 
-    /* initialize to 509 buckets with each the size of a pointer */
-    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
-    if (oSymTable == NULL)
-        return NULL;
-    
-    oSymTable->ppsArray = (struct SymTableNode **)
-        calloc(uInitBucketCount, sizeof(struct SymTableNode *));
-    if (oSymTable->ppsArray == NULL)
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    node = SymTable_getNode(oSymTable, pcKey);
+    if (node==NULL) {
         return NULL;
-    
-    /* intialize all buckets to NULL */
-    for (i=0; i<uInitBucketCount; i++) {
-        oSymTable->ppsArray[i] = NULL;
     }
-    oSymTable->uBucketCountIndex = 0;
-    oSymTable->length = 0;
-    return oSymTable;
+    pvOldValue = node->pvValue;
+    node->pvValue = pvValue;
+    return (void *) pvOldValue;
 }
 
 
-/* free memory allocated to the linked list of bindings starting with 
-the node pointed to by psFirstNode */
-static void SymTable_freeBucket(struct SymTableNode *psFirstNode)
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
 {
-    struct SymTableNode *psCurrentNode;
-    struct SymTableNode *psNextNode;
+    struct SymTableNode *node;
 
-    assert(psFirstNode != NULL);
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
 
-    for (psCurrentNode = psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psNextNode)
-    {
-        psNextNode = psCurrentNode->psNextNode;
-        free((char *) psCurrentNode->pcKey);
-        free(psCurrentNode);
+    node = SymTable_getNode(oSymTable, pcKey);
+    if (node==NULL) {
+        return 0;
     }
+    return 1;
 }
 
 
-void SymTable_free(SymTable_T oSymTable)
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
 {
-    size_t i;
-    struct SymTableNode *psCurrentBucket;
+    struct SymTableNode *node;
 
     assert(oSymTable != NULL);
+    assert(pcKey != NULL);
 
-    for(i=0; i<auBucketCounts[oSymTable->uBucketCountIndex]; i++) {
-        psCurrentBucket = oSymTable->ppsArray[i];
-        if(psCurrentBucket == NULL)
-            continue;
-        SymTable_freeBucket(psCurrentBucket);
+    node = SymTable_getNode(oSymTable, pcKey);
+    if (node==NULL) {
+        return NULL;
     }
-
-    free(oSymTable->ppsArray);
-    free(oSymTable);
+    return (void *) node->pvValue;
 }
 
 
-size_t SymTable_getLength(SymTable_T oSymTable) {
-    return oSymTable->length;
-}
-
+/* Start psLookup on the search for pcKey, the key at position uIndex
+   of a SymTable_getBatch batch on oSymTable: hash it, and prefetch the
+   first bucket to examine, in the old array if a resize has yet to
+   migrate the key's bucket there. */
+static void SymTable_startLookup(SymTable_T oSymTable,
+    struct SymTableLookup *psLookup, const char *pcKey, size_t uIndex)
+{
+    size_t uBucketIndex;
 
-/* If the bucket count is not already at the maximum value, expand
-oSymTable to the next highest bucket count.
-Otherwise, leave oSymTable unchanged. */
-static void SymTable_expand(SymTable_T oSymTable) {
-    size_t i;
-    size_t oldBucketCount;
-    size_t newBucketCount;
-    struct SymTableNode **ppsNewArray;
+    assert(oSymTable != NULL);
+    assert(psLookup != NULL);
+    assert(pcKey != NULL);
 
-    struct SymTableNode *psCurrentNode;
-    struct SymTableNode *psNextNode;
-    size_t uNewHash;
+    psLookup->uIndex = uIndex;
+    psLookup->uHash = SymTable_hash(oSymTable, pcKey,
+        &psLookup->uKeyLength);
+    psLookup->psNode = NULL;
+    psLookup->iInOldArray = 0;
+
+    if (oSymTable->ppsOldArray != NULL) {
+        uBucketIndex = SymTable_bucketIndex(psLookup->uHash,
+            oSymTable->uOldBucketCount);
+        if (uBucketIndex >= oSymTable->uRehashIndex) {
+            psLookup->ppsBucket = &oSymTable->ppsOldArray[uBucketIndex];
+            psLookup->iInOldArray = 1;
+        }
+    }
+    if (! psLookup->iInOldArray)
+        psLookup->ppsBucket = &oSymTable->ppsArray[SymTable_bucketIndex(
+            psLookup->uHash, oSymTable->uBucketCount)];
+    SymTable_prefetch(psLookup->ppsBucket);
+}
 
-    /* check that bucket count is not at maximum */
-    if (oSymTable->uBucketCountIndex == numBucketCounts-1)
-        return;
-    
-    oldBucketCount = auBucketCounts[oSymTable->uBucketCountIndex];
-    newBucketCount = auBucketCounts[oSymTable->uBucketCountIndex+1];
 
-    /* allocate memory for newly-sized array of pointers */
-    ppsNewArray = (struct SymTableNode **) 
-        calloc(newBucketCount, sizeof(struct SymTableNode *));
-    if (ppsNewArray == NULL)
-        return;
+/* Advance psLookup, the search for pcKey in oSymTable, by one step.
+   If the search is then over, store the value of pcKey's binding, or
+   NULL if there is none, in *ppvValue and return 1 (TRUE). Otherwise
+   prefetch what the next step examines and return 0 (FALSE). */
+static int SymTable_stepLookup(SymTable_T oSymTable,
+    struct SymTableLookup *psLookup, const char *pcKey, void **ppvValue)
+{
+    struct SymTableNode *psBucket;
+    struct SymTableNode *psNode;
 
-    /* initialize newly allocated memory to NULL pointers */
-    for(i=0; i<newBucketCount; i++) {
-        ppsNewArray[i] = NULL;
+    assert(oSymTable != NULL);
+    assert(psLookup != NULL);
+    assert(pcKey != NULL);
+    assert(ppvValue != NULL);
+
+    if (psLookup->ppsBucket != NULL) {
+        psBucket = *psLookup->ppsBucket;
+        psLookup->ppsBucket = NULL;
+        if (SymTable_isTree(psBucket)) {
+            /* tree bins are rare, so one is searched at once */
+            psNode = SymTable_searchBucket(psBucket, pcKey,
+                psLookup->uHash, psLookup->uKeyLength);
+            if (psNode != NULL) {
+                *ppvValue = (void *) psNode->pvValue;
+                return 1;
+            }
+            psLookup->psNode = NULL;
+        }
+        else
+            psLookup->psNode = psBucket;
+    }
+    else {
+        psNode = psLookup->psNode;
+        if (SymTable_nodeMatches(psNode, pcKey, psLookup->uHash,
+            psLookup->uKeyLength)) {
+            *ppvValue = (void *) psNode->pvValue;
+            return 1;
+        }
+        psLookup->psNode = psNode->psNextNode;
     }
 
-    /* put bindings in new array */
-    for(i=0; i<oldBucketCount; i++) {
-        /* printf("CURRENT BUCKET: %u, ", (unsigned int) i); */
-        for(psCurrentNode = oSymTable->ppsArray[i];
-            psCurrentNode != NULL;
-            psCurrentNode = psNextNode) 
-        {
-            psNextNode = psCurrentNode->psNextNode;
+    /* the node's key may begin in the next cache line */
+    if (psLookup->psNode != NULL) {
+        SymTable_prefetch(psLookup->psNode);
+        SymTable_prefetch(psLookup->psNode->acKey);
+        return 0;
+    }
 
-            uNewHash = SymTable_hash(psCurrentNode->pcKey, 
-                newBucketCount);
-            /* printf("%u, ", (unsigned int) uNewHash); */
-            psCurrentNode->psNextNode = ppsNewArray[uNewHash];
-            ppsNewArray[uNewHash] = psCurrentNode;
-        }
-        oSymTable->ppsArray[i] = NULL;
+    if (psLookup->iInOldArray) {
+        psLookup->iInOldArray = 0;
+        psLookup->ppsBucket = &oSymTable->ppsArray[SymTable_bucketIndex(
+            psLookup->uHash, oSymTable->uBucketCount)];
+        SymTable_prefetch(psLookup->ppsBucket);
+        return 0;
     }
 
-    /* free pointer to old array, 
-    assign new array and bucket count index */
-    free(oSymTable->ppsArray);
-    oSymTable->ppsArray = ppsNewArray;
-    oSymTable->uBucketCountIndex += 1;
+    *ppvValue = NULL;
+    return 1;
 }
 
 
-int SymTable_put(SymTable_T oSymTable, 
-    const char *pcKey, const void *pvValue)
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+    size_t uCount, void **apvOut)
 {
-    size_t bucketIndex;
-    struct SymTableNode *psNewNode;
+    struct SymTableLookup asLookups[LOOKUP_WINDOW];
+    struct SymTableLookup *psLookup;
+    size_t uActive = 0;
+    size_t uNext = 0;
+    size_t i = 0;
 
     assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+    assert(apcKeys != NULL);
+    assert(apvOut != NULL);
+
+    while (uActive < LOOKUP_WINDOW && uNext < uCount) {
+        assert(apcKeys[uNext] != NULL);
+        SymTable_startLookup(oSymTable, &asLookups[uActive++],
+            apcKeys[uNext], uNext);
+        uNext++;
+    }
 
-    /* check if SymTable already contains key */
-    if (SymTable_contains(oSymTable, pcKey))
-        return 0;
-    
+    /* step the lookups in turn; a finished lookup's place goes to the
+    next key of the batch or, once there is none, to the last lookup
+    in progress */
+    while (uActive > 0) {
+        psLookup = &asLookups[i];
+        if (SymTable_stepLookup(oSymTable, psLookup,
+            apcKeys[psLookup->uIndex], &apvOut[psLookup->uIndex])) {
+            if (uNext < uCount) {
+                assert(apcKeys[uNext] != NULL);
+                SymTable_startLookup(oSymTable, psLookup,
+                    apcKeys[uNext], uNext);
+                uNext++;
+            }
+            else {
+                *psLookup = asLookups[--uActive];
+                if (i == uActive)
+                    i = 0;
+                continue;
+            }
+        }
+        if (++i == uActive)
+            i = 0;
+    }
+}
 
-    /* expand SymTable if necessary */
-    if (oSymTable->length == 
-        auBucketCounts[oSymTable->uBucketCountIndex])
-        SymTable_expand(oSymTable);
-    
-    
-    bucketIndex = SymTable_hash(pcKey, 
-        auBucketCounts[oSymTable->uBucketCountIndex]);
 
-    psNewNode = (struct SymTableNode*)
-        malloc(sizeof(struct SymTableNode));
-    if (psNewNode == NULL)
-        return 0;
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    struct SymTableNode *node;
 
-    /* create defensive copy of key */
-    psNewNode->pcKey = (const char*)malloc(strlen(pcKey)+1);
-    if (psNewNode->pcKey == NULL)
-        return 0;
-    strcpy((char *) psNewNode->pcKey, pcKey);
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
 
-    /* assign value */
-    psNewNode->pvValue = pvValue;
+    SymTable_rehashStep(oSymTable);
 
-    /* insert binding to beginning of linked list */
-    psNewNode->psNextNode = oSymTable->ppsArray[bucketIndex];
-    oSymTable->ppsArray[bucketIndex] = psNewNode;
-    /* increment length of SymTable */
-    oSymTable->length += 1;
-    return 1;
+    SymTable_findBucket(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength, &node);
+    if (node==NULL) {
+        return NULL;
+    }
+    return (void *) node->pvValue;
 }
 
 
 /*
-return a pointer to the SymTableNode in oSymTable whose key is pcKey. 
-If no matching key exists in the symbol table, return NULL.
+If oSymTable contains a binding with key pcKey, whose full hash code
+is uHash and whose length is uKeyLength (or uUnknownKeyLength), remove
+that binding from oSymTable and return the binding's value.
+Otherwise, do not change oSymTable and return NULL.
 */
-static struct SymTableNode *SymTable_getNode(SymTable_T oSymTable, 
-    const char *pcKey)
+static void *SymTable_removeNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
 {
+    struct SymTableNode **ppsBucket;
+    struct SymTableNode **ppsLink;
     struct SymTableNode *psCurrentNode;
-    size_t bucketIndex;
+    struct SymTableTreeNode *psRoot;
+    struct SymTableTreeNode *psRemoved;
+    struct SymTableIter *psIter;
+    const void *pvValue;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    bucketIndex = SymTable_hash(pcKey, 
-        auBucketCounts[oSymTable->uBucketCountIndex]);
+    SymTable_rehashStep(oSymTable);
 
-    for (psCurrentNode = oSymTable->ppsArray[bucketIndex];
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
-    {
-        if (strcmp(psCurrentNode->pcKey, pcKey)==0)
-            return psCurrentNode;
+    ppsBucket = SymTable_findBucket(oSymTable, pcKey, uHash, uKeyLength,
+        &psCurrentNode);
+    if (psCurrentNode == NULL)
+        return NULL;
+
+    if (SymTable_isTree(*ppsBucket)) {
+        psRoot = SymTable_treeRemove(SymTable_treeRoot(*ppsBucket),
+            psCurrentNode, &psRemoved);
+        SymTable_freeTreeNode(oSymTable, psRemoved);
+        *ppsBucket = SymTable_treeBucket(psRoot);
+        /* a tree bin that has shrunk back to a few nodes is cheaper
+        to search as a chain */
+        if (SymTable_treeHeight(psRoot) <= iUntreeifyHeight)
+            SymTable_untreeify(oSymTable, ppsBucket);
     }
-    return NULL;
+    else {
+        /* unlink the node, whether it is first in its bucket or not */
+        for (ppsLink = ppsBucket; *ppsLink != psCurrentNode;
+            ppsLink = &(*ppsLink)->psNextNode)
+            ;
+        *ppsLink = psCurrentNode->psNextNode;
+    }
+
+    /* an iterator about to visit the node skips it instead */
+    for (psIter = oSymTable->psFirstIter; psIter != NULL;
+        psIter = psIter->psNextIter)
+        if (psIter->psNextNode == psCurrentNode)
+            psIter->psNextNode = psCurrentNode->psNextInOrder;
+
+    /* unlink the node from the insertion order */
+    if (psCurrentNode->psPrevInOrder == NULL)
+        oSymTable->psFirstInOrder = psCurrentNode->psNextInOrder;
+    else
+        psCurrentNode->psPrevInOrder->psNextInOrder =
+            psCurrentNode->psNextInOrder;
+    if (psCurrentNode->psNextInOrder == NULL)
+        oSymTable->psLastInOrder = psCurrentNode->psPrevInOrder;
+    else
+        psCurrentNode->psNextInOrder->psPrevInOrder =
+            psCurrentNode->psPrevInOrder;
+
+    pvValue = psCurrentNode->pvValue;
+    SymTable_freeNode(oSymTable, psCurrentNode);
+    /* decrement length of SymTable */
+    oSymTable->length -= 1;
+
+    /* start shrinking SymTable if necessary */
+    SymTable_contract(oSymTable);
+    return (void *) pvValue;
 }
 
 
-void *SymTable_replace(SymTable_T oSymTable,
-    const char *pcKey, const void *pvValue)
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
 {
-    struct SymTableNode *node;
-    const void *pvOldValue;
+    size_t uHash;
+    size_t uKeyLength;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    node = SymTable_getNode(oSymTable, pcKey);
-    if (node==NULL) {
-        return NULL;
-    }
-    pvOldValue = node->pvValue;
-    node->pvValue = pvValue;
-    return (void *) pvOldValue;
+    uHash = SymTable_hash(oSymTable, pcKey, &uKeyLength);
+    return SymTable_removeNode(oSymTable, pcKey, uHash, uKeyLength);
 }
 
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
 {
-    struct SymTableNode *node;
-
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    node = SymTable_getNode(oSymTable, pcKey);
-    if (node==NULL) {
-        return 0;
-    }
-    return 1;
+    return SymTable_removeNode(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength);
 }
 
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    (void)SymTable_findOrInsertNode(oSymTable, (const char *)pvKey,
+        SymTable_hashN(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_getNodeN(oSymTable, (const char *)pvKey,
+        uKeyLength) != NULL;
+}
+
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
 {
     struct SymTableNode *node;
 
     assert(oSymTable != NULL);
-    assert(pcKey != NULL);
+    assert(pvKey != NULL);
 
-    node = SymTable_getNode(oSymTable, pcKey);
+    node = SymTable_getNodeN(oSymTable, (const char *)pvKey, uKeyLength);
     if (node==NULL) {
         return NULL;
     }
@@ -315,43 +2041,50 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
 }
 
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
 {
-    struct SymTableNode *psPrevNode = NULL;
-    struct SymTableNode *psCurrentNode;
-    size_t bucketIndex;
-    const void *pvValue;
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_removeNode(oSymTable, (const char *)pvKey,
+        SymTable_hashN(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength);
+}
+
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uBucketCount;
 
     assert(oSymTable != NULL);
-    assert(pcKey != NULL);
 
-    bucketIndex = SymTable_hash(pcKey, 
-        auBucketCounts[oSymTable->uBucketCountIndex]);
+    if (!SymTable_bucketCountFor(uCapacity, &uBucketCount))
+        return 0;
+    if (uBucketCount <= oSymTable->uBucketCount)
+        return 1;
 
-    for (psCurrentNode = oSymTable->ppsArray[bucketIndex];
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
-    {
-        if (strcmp(psCurrentNode->pcKey, pcKey)==0) {
-            if (psPrevNode==NULL) {
-                /* condition that we remove the first node */
-                pvValue = psCurrentNode->pvValue;
-                oSymTable->ppsArray[bucketIndex] = 
-                    psCurrentNode->psNextNode;
-            }
-            else {
-                pvValue = psCurrentNode->pvValue;
-                psPrevNode->psNextNode = psCurrentNode->psNextNode;
-            }
-            free((char *) psCurrentNode->pcKey);
-            free(psCurrentNode);
-            /* decrement length of SymTable */
-            oSymTable->length -= 1;
-            return (void *) pvValue;
-        }
-        psPrevNode = psCurrentNode;
-    }
-    return NULL;
+    /* the bindings then migrate a few at a time, as they do when the
+    table doubles */
+    SymTable_finishResize(oSymTable);
+    return SymTable_resize(oSymTable, uBucketCount);
+}
+
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uBucketCount;
+
+    assert(oSymTable != NULL);
+
+    SymTable_finishResize(oSymTable);
+
+    if (SymTable_bucketCountFor(oSymTable->length, &uBucketCount) &&
+        uBucketCount < oSymTable->uBucketCount &&
+        SymTable_resize(oSymTable, uBucketCount))
+        SymTable_finishResize(oSymTable);
+
+    SymTable_releaseChunks(oSymTable);
 }
 
 
@@ -363,7 +2096,7 @@ int SymTable_isEmpty(SymTable_T oSymTable)
 
     assert(oSymTable != NULL);
 
-    for(i=0; i<auBucketCounts[oSymTable->uBucketCountIndex]; i++) {
+    for(i=0; i<oSymTable->uBucketCount; i++) {
         psCurrentBucket = oSymTable->ppsArray[i];
         if(psCurrentBucket != NULL)
             return 0;
@@ -377,19 +2110,138 @@ void SymTable_map(SymTable_T oSymTable,
     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
     const void *pvExtra)
 {
-    size_t i;
     struct SymTableNode *psCurrentNode;
 
     assert(oSymTable != NULL);
     assert(pfApply != NULL);
 
-    /* iterate through buckets */
-    for(i=0; i<auBucketCounts[oSymTable->uBucketCountIndex]; i++) {
-        /* iterate through linked list */
-        for (psCurrentNode = oSymTable->ppsArray[i];
-            psCurrentNode != NULL;
-            psCurrentNode = psCurrentNode->psNextNode)
-        (*pfApply)(psCurrentNode->pcKey, (void*)psCurrentNode->pvValue, 
+    /* follow the insertion order, which skips empty buckets and is
+    the same however the buckets are arranged */
+    for (psCurrentNode = oSymTable->psFirstInOrder;
+        psCurrentNode != NULL;
+        psCurrentNode = psCurrentNode->psNextInOrder)
+        (*pfApply)(psCurrentNode->acKey, (void*)psCurrentNode->pvValue,
             (void*)pvExtra);
+}
+
+
+/* Apply the function of psMapping to each node indexed by the tree
+   rooted at psRoot, which may be NULL. */
+static void SymTable_mapTree(struct SymTableTreeNode *psRoot,
+    const struct SymTableMapping *psMapping)
+{
+    assert(psMapping != NULL);
+
+    for (; psRoot != NULL; psRoot = psRoot->psRight) {
+        SymTable_mapTree(psRoot->psLeft, psMapping);
+        (*psMapping->pfApply)(psRoot->psNode->acKey,
+            (void*)psRoot->psNode->pvValue, (void*)psMapping->pvExtra);
+    }
+}
+
+
+/* Apply the function of the SymTableMapping pvMapping to each binding
+   in the buckets uBegin through uEnd - 1 of its table, counting the
+   buckets of the old array of a resize first and then those of the
+   new one. */
+static void SymTable_mapBuckets(size_t uBegin, size_t uEnd,
+    void *pvMapping)
+{
+    const struct SymTableMapping *psMapping =
+        (const struct SymTableMapping *)pvMapping;
+    SymTable_T oSymTable;
+    struct SymTableNode *psBucket;
+    struct SymTableNode *psCurrentNode;
+    size_t i;
+
+    assert(psMapping != NULL);
+
+    oSymTable = psMapping->oSymTable;
+    for (i = uBegin; i < uEnd; i++) {
+        if (i < oSymTable->uOldBucketCount)
+            psBucket = oSymTable->ppsOldArray[i];
+        else
+            psBucket = oSymTable->ppsArray[i - oSymTable->uOldBucketCount];
+
+        if (SymTable_isTree(psBucket)) {
+            SymTable_mapTree(SymTable_treeRoot(psBucket), psMapping);
+            continue;
+        }
+        for (psCurrentNode = psBucket; psCurrentNode != NULL;
+            psCurrentNode = psCurrentNode->psNextNode)
+            (*psMapping->pfApply)(psCurrentNode->acKey,
+                (void*)psCurrentNode->pvValue, (void*)psMapping->pvExtra);
     }
 }
+
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, size_t uThreadCount)
+{
+    struct SymTableMapping sMapping;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /* the insertion order is a single list, which threads cannot
+    share out, so the traversal goes by bucket instead; the buckets of
+    a resize in progress are read where they are, not migrated */
+    sMapping.oSymTable = oSymTable;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymParallel_run(oSymTable->uOldBucketCount + oSymTable->uBucketCount,
+        SymTable_mapBuckets, &sMapping, uThreadCount);
+}
+
+
+SymTable_Iter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+    struct SymTableIter *psIter;
+
+    assert(oSymTable != NULL);
+
+    psIter = (struct SymTableIter *)malloc(sizeof(struct SymTableIter));
+    if (psIter == NULL)
+        return NULL;
+
+    psIter->oSymTable = oSymTable;
+    psIter->psNextNode = oSymTable->psFirstInOrder;
+    psIter->psNextIter = oSymTable->psFirstIter;
+    oSymTable->psFirstIter = psIter;
+    return psIter;
+}
+
+
+int SymTable_iterNext(SymTable_Iter_T oIter,
+    const char **ppcKey, void **ppvValue)
+{
+    struct SymTableNode *psNode;
+
+    assert(oIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    psNode = oIter->psNextNode;
+    if (psNode == NULL)
+        return 0;
+
+    *ppcKey = psNode->acKey;
+    *ppvValue = (void *) psNode->pvValue;
+    oIter->psNextNode = psNode->psNextInOrder;
+    return 1;
+}
+
+
+void SymTable_iterEnd(SymTable_Iter_T oIter)
+{
+    struct SymTableIter **ppsLink;
+
+    assert(oIter != NULL);
+
+    for (ppsLink = &oIter->oSymTable->psFirstIter; *ppsLink != oIter;
+        ppsLink = &(*ppsLink)->psNextIter)
+        assert(*ppsLink != NULL);
+    *ppsLink = oIter->psNextIter;
+    free(oIter);
+}
@@ -0,0 +1,50 @@
+/*
+symtableiter.h
+Author: David Wang
+*/
+
+#ifndef SYMTABLEITER_INCLUDED
+#define SYMTABLEITER_INCLUDED
+#include "symtable.h"
+
+/*
+External iteration, provided by the list and hash implementations of
+symtable.h. A SymTable_Iter_T visits the bindings of one SymTable_T
+one at a time, in the same order as SymTable_map, and may be stopped
+at any point by ending it. That order depends only on the sequence of
+additions and removals that built the table: the list implementation
+visits the most recently added binding first, and the hash
+implementation the least recently added.
+
+While an iterator is in use, its SymTable_T may be modified:
+-- Replacing values, through SymTable_replace or an address returned
+   by SymTable_findOrInsert, is always allowed.
+-- Removing a binding is allowed. A binding removed before the
+   iterator reaches it is not visited.
+-- Adding a binding is allowed. The added binding may or may not be
+   visited.
+Every binding that is in the SymTable_T from SymTable_iterBegin until
+it is visited is visited exactly once. It is a checked runtime error
+to free a SymTable_T while an iterator of it is in use.
+*/
+
+/* SymTable_Iter_T is a position in the traversal of a SymTable_T */
+typedef struct SymTableIter* SymTable_Iter_T;
+
+/* Return a new iterator positioned before the first binding of
+oSymTable, or NULL if insufficient memory is available. */
+SymTable_Iter_T SymTable_iterBegin(SymTable_T oSymTable);
+
+/*
+If oIter has bindings left to visit, store the key of the next one in
+*ppcKey and its value in *ppvValue, advance oIter past it, and return
+1 (TRUE). The stored key is the table's own copy, valid until the
+binding is removed. Otherwise return 0 (FALSE).
+*/
+int SymTable_iterNext(SymTable_Iter_T oIter,
+    const char **ppcKey, void **ppvValue);
+
+/* Free oIter, which may be ended before or after its last binding. */
+void SymTable_iterEnd(SymTable_Iter_T oIter);
+
+#endif
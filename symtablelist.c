@@ -8,20 +8,47 @@ Author: David Wang
 #include <string.h>
 #include <stddef.h>
 #include "symtable.h"
+#include "symtableiter.h"
+#include "symhash.h"
 
 
 /* Each item is stored in a SymTableNode.  SymTableNodes are linked to
-   form a list.  */
+   form a list. A node and the defensive copy of its key are a single
+   allocation.  */
 struct SymTableNode
 {
     /* pointer to the value. */
     const void *pvValue;
 
-    /* pointer to defensive copy of the key string */
-    const char *pcKey;
-
     /* The address of the next SymTableNode. */
     struct SymTableNode *psNextNode;
+
+    /* hash code of the key, compared before the key itself by the
+    SymTable_*Hashed functions */
+    size_t uHash;
+
+    /* length of the key in bytes, not counting the '\0' that ends
+    the copy */
+    size_t uKeyLength;
+
+    /* defensive copy of the key, stored inline and '\0'-terminated */
+    char acKey[];
+};
+
+
+/* A SymTableIter is a position in the list. SymTableIters of the same
+   SymTable are linked to form a list, so that removing a node can move
+   any that are about to visit it. */
+struct SymTableIter
+{
+    /* The SymTable being traversed */
+    SymTable_T oSymTable;
+
+    /* The next SymTableNode to visit, or NULL at the end */
+    struct SymTableNode *psNextNode;
+
+    /* The address of the next SymTableIter of the same SymTable. */
+    struct SymTableIter *psNextIter;
 };
 
 
@@ -33,9 +60,21 @@ struct SymTable
 
     /* The number of bindings in the SymTable */
     size_t length;
+
+    /* The address of the first SymTableIter in use */
+    struct SymTableIter *psFirstIter;
 };
 
 
+/* Return a hash code for the uKeyLength bytes at pcKey. */
+static size_t SymTable_hash(const char *pcKey, size_t uKeyLength)
+{
+    assert(pcKey != NULL);
+
+    return (size_t)SymHash_hash(pcKey, uKeyLength);
+}
+
+
 SymTable_T SymTable_new(void)
 {
     SymTable_T oSymTable;
@@ -46,23 +85,32 @@ SymTable_T SymTable_new(void)
 
     oSymTable->psFirstNode = NULL;
     oSymTable->length = 0;
+    oSymTable->psFirstIter = NULL;
     return oSymTable;
 }
 
 
+/* a list has no array to size in advance */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    (void)uCapacity;
+    return SymTable_new();
+}
+
+
 void SymTable_free(SymTable_T oSymTable)
 {
     struct SymTableNode *psCurrentNode;
     struct SymTableNode *psNextNode;
 
     assert(oSymTable != NULL);
+    assert(oSymTable->psFirstIter == NULL);
 
     for (psCurrentNode = oSymTable->psFirstNode;
         psCurrentNode != NULL;
         psCurrentNode = psNextNode)
     {
         psNextNode = psCurrentNode->psNextNode;
-        free((char *) psCurrentNode->pcKey);
         free(psCurrentNode);
     }
 
@@ -75,61 +123,149 @@ size_t SymTable_getLength(SymTable_T oSymTable) {
 }
 
 
-int SymTable_put(SymTable_T oSymTable, 
-    const char *pcKey, const void *pvValue)
+/*
+return the address of the link (psFirstNode or psNextNode field) that
+points to the SymTableNode in oSymTable whose key is the uKeyLength
+bytes at pcKey. If puHash is not NULL, *puHash is the hash code of
+the key and nodes with other hash codes are skipped without comparing
+keys. If no matching key exists in the symbol table, return the
+address of the NULL link that ends the list.
+*/
+static struct SymTableNode **SymTable_findLink(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength, const size_t *puHash)
 {
-    struct SymTableNode *psNewNode;
+    struct SymTableNode **ppsLink;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    /* check if SymTable already contains key */
-    if (SymTable_contains(oSymTable, pcKey))
-        return 0;
-    
-    psNewNode = (struct SymTableNode*)malloc(
-            sizeof(struct SymTableNode));
-    if (psNewNode == NULL)
-        return 0;
+    for (ppsLink = &oSymTable->psFirstNode;
+        *ppsLink != NULL;
+        ppsLink = &(*ppsLink)->psNextNode)
+    {
+        if (puHash != NULL && (*ppsLink)->uHash != *puHash)
+            continue;
+        if ((*ppsLink)->uKeyLength == uKeyLength &&
+            memcmp((*ppsLink)->acKey, pcKey, uKeyLength)==0)
+            return ppsLink;
+    }
+    return ppsLink;
+}
 
-    /* create defensive copy of key */
-    psNewNode->pcKey = (const char*)malloc(strlen(pcKey)+1);
-    if (psNewNode->pcKey == NULL)
-        return 0;
-    strcpy((char *) psNewNode->pcKey, pcKey);
+
+/*
+return a pointer to the SymTableNode in oSymTable whose key is pcKey. 
+If no matching key exists in the symbol table, return NULL.
+*/
+static struct SymTableNode *SymTable_getNode(SymTable_T oSymTable, 
+    const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return *SymTable_findLink(oSymTable, pcKey, strlen(pcKey), NULL);
+}
+
+
+/*
+Add to the front of oSymTable, which must not contain the key, a new
+binding whose key is the uKeyLength bytes at pcKey, with hash code
+uHash and value pvValue, and return its node. If insufficient memory
+is available, leave oSymTable unchanged and return NULL.
+*/
+static struct SymTableNode *SymTable_insertNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength, size_t uHash,
+    const void *pvValue)
+{
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* allocate the node together with room for its key */
+    psNode = (struct SymTableNode*)malloc(
+            sizeof(struct SymTableNode) + uKeyLength+1);
+    if (psNode == NULL)
+        return NULL;
+
+    /* create defensive copy of key, which need not end in '\0' */
+    memcpy(psNode->acKey, pcKey, uKeyLength);
+    psNode->acKey[uKeyLength] = '\0';
+    psNode->uKeyLength = uKeyLength;
+    psNode->uHash = uHash;
 
     /* assign value */
-    psNewNode->pvValue = pvValue;
+    psNode->pvValue = pvValue;
 
     /* insert binding to beginning of linked list */
-    psNewNode->psNextNode = oSymTable->psFirstNode;
-    oSymTable->psFirstNode = psNewNode;
+    psNode->psNextNode = oSymTable->psFirstNode;
+    oSymTable->psFirstNode = psNode;
     /* increment length of SymTable */
     oSymTable->length += 1;
-    return 1;
+    return psNode;
 }
 
 
-/*
-return a pointer to the SymTableNode in oSymTable whose key is pcKey. 
-If no matching key exists in the symbol table, return NULL.
-*/
-static struct SymTableNode *SymTable_getNode(SymTable_T oSymTable, 
-    const char *pcKey)
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvDefault, int *piInserted)
 {
-    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNode;
+    size_t uKeyLength;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
+    assert(piInserted != NULL);
 
-    for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
-    {   
-        if (strcmp(psCurrentNode->pcKey, pcKey)==0)
-            return psCurrentNode;
+    *piInserted = 0;
+
+    /* walk the list exactly once */
+    uKeyLength = strlen(pcKey);
+    psNode = *SymTable_findLink(oSymTable, pcKey, uKeyLength, NULL);
+    if (psNode != NULL)
+        return (void **) &psNode->pvValue;
+
+    psNode = SymTable_insertNode(oSymTable, pcKey, uKeyLength,
+        SymTable_hash(pcKey, uKeyLength), pvDefault);
+    if (psNode == NULL)
+        return NULL;
+    *piInserted = 1;
+    return (void **) &psNode->pvValue;
+}
+
+
+int SymTable_put(SymTable_T oSymTable, 
+    const char *pcKey, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+/* a list has no buckets to fetch ahead of time, so the batch is put
+one binding at a time */
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+    const void **apvValues, size_t uCount, int *aiResults)
+{
+    size_t i;
+    size_t uAdded = 0;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvValues != NULL);
+
+    for (i = 0; i < uCount; i++) {
+        iInserted = SymTable_put(oSymTable, apcKeys[i], apvValues[i]);
+        if (aiResults != NULL)
+            aiResults[i] = iInserted;
+        uAdded += (size_t)iInserted;
     }
-    return NULL;
+    return uAdded;
 }
 
 
@@ -182,38 +318,195 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
 }
 
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+/* a list is searched node by node, each found through the last, so
+the batch is searched one key at a time */
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+    size_t uCount, void **apvOut)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvOut != NULL);
+
+    for (i = 0; i < uCount; i++)
+        apvOut[i] = SymTable_get(oSymTable, apcKeys[i]);
+}
+
+
+/*
+If oSymTable contains a binding whose key is the uKeyLength bytes at
+pcKey, remove that binding from oSymTable and return the binding's
+value. Otherwise, do not change oSymTable and return NULL. puHash is
+as for SymTable_findLink.
+*/
+static void *SymTable_removeNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength, const size_t *puHash)
 {
-    struct SymTableNode *psPrevNode = NULL;
+    struct SymTableNode **ppsLink;
     struct SymTableNode *psCurrentNode;
+    struct SymTableIter *psIter;
     const void *pvValue;
 
     assert(oSymTable != NULL);
     assert(pcKey != NULL);
 
-    for (psCurrentNode = oSymTable->psFirstNode;
-        psCurrentNode != NULL;
-        psCurrentNode = psCurrentNode->psNextNode)
-    {
-        if (strcmp(psCurrentNode->pcKey, pcKey)==0) {
-            if (psPrevNode==NULL) {
-                /* condition that we remove the first node */
-                pvValue = psCurrentNode->pvValue;
-                oSymTable->psFirstNode = psCurrentNode->psNextNode;
-            }
-            else {
-                pvValue = psCurrentNode->pvValue;
-                psPrevNode->psNextNode = psCurrentNode->psNextNode;
-            }
-            free((char *) psCurrentNode->pcKey);
-            free(psCurrentNode);
-            /* decrement length of SymTable */
-            oSymTable->length -= 1;
-            return (void *) pvValue;
-        }
-        psPrevNode = psCurrentNode;
+    ppsLink = SymTable_findLink(oSymTable, pcKey, uKeyLength, puHash);
+    psCurrentNode = *ppsLink;
+    if (psCurrentNode == NULL)
+        return NULL;
+
+    /* an iterator about to visit the node skips it instead */
+    for (psIter = oSymTable->psFirstIter; psIter != NULL;
+        psIter = psIter->psNextIter)
+        if (psIter->psNextNode == psCurrentNode)
+            psIter->psNextNode = psCurrentNode->psNextNode;
+
+    /* unlink the node, whether it is first in the list or not */
+    pvValue = psCurrentNode->pvValue;
+    *ppsLink = psCurrentNode->psNextNode;
+    free(psCurrentNode);
+    /* decrement length of SymTable */
+    oSymTable->length -= 1;
+    return (void *) pvValue;
+}
+
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_removeNode(oSymTable, pcKey, strlen(pcKey), NULL);
+}
+
+
+SymTable_Hash_T SymTable_hashKey(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return (SymTable_Hash_T)SymTable_hash(pcKey, strlen(pcKey));
+}
+
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash, const void *pvValue)
+{
+    size_t uListHash = (size_t)uHash;
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uKeyLength = strlen(pcKey);
+    if (*SymTable_findLink(oSymTable, pcKey, uKeyLength, &uListHash)
+        != NULL)
+        return 0;
+    return SymTable_insertNode(oSymTable, pcKey, uKeyLength, uListHash,
+        pvValue) != NULL;
+}
+
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    struct SymTableNode *node;
+    size_t uListHash = (size_t)uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    node = *SymTable_findLink(oSymTable, pcKey, strlen(pcKey),
+        &uListHash);
+    if (node==NULL) {
+        return NULL;
+    }
+    return (void *) node->pvValue;
+}
+
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    size_t uListHash = (size_t)uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_removeNode(oSymTable, pcKey, strlen(pcKey),
+        &uListHash);
+}
+
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength, const void *pvValue)
+{
+    const char *pcKey = (const char *)pvKey;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    if (*SymTable_findLink(oSymTable, pcKey, uKeyLength, NULL) != NULL)
+        return 0;
+    return SymTable_insertNode(oSymTable, pcKey, uKeyLength,
+        SymTable_hash(pcKey, uKeyLength), pvValue) != NULL;
+}
+
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return *SymTable_findLink(oSymTable, (const char *)pvKey,
+        uKeyLength, NULL) != NULL;
+}
+
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    struct SymTableNode *node;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    node = *SymTable_findLink(oSymTable, (const char *)pvKey,
+        uKeyLength, NULL);
+    if (node==NULL) {
+        return NULL;
     }
-    return NULL;
+    return (void *) node->pvValue;
+}
+
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_removeNode(oSymTable, (const char *)pvKey,
+        uKeyLength, NULL);
+}
+
+
+/* as for SymTable_newWithCapacity, there is nothing to size */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    assert(oSymTable != NULL);
+
+    (void)uCapacity;
+    return 1;
+}
+
+
+/* every node is allocated on its own and freed as soon as it is
+removed, so there is nothing to give back */
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
 }
 
 
@@ -229,6 +522,58 @@ void SymTable_map(SymTable_T oSymTable,
     for (psCurrentNode = oSymTable->psFirstNode;
         psCurrentNode != NULL;
         psCurrentNode = psCurrentNode->psNextNode)
-        (*pfApply)(psCurrentNode->pcKey, (void*)psCurrentNode->pvValue, 
+        (*pfApply)(psCurrentNode->acKey, (void*)psCurrentNode->pvValue, 
             (void*)pvExtra);
 }
+
+
+SymTable_Iter_T SymTable_iterBegin(SymTable_T oSymTable)
+{
+    struct SymTableIter *psIter;
+
+    assert(oSymTable != NULL);
+
+    psIter = (struct SymTableIter *)malloc(sizeof(struct SymTableIter));
+    if (psIter == NULL)
+        return NULL;
+
+    psIter->oSymTable = oSymTable;
+    psIter->psNextNode = oSymTable->psFirstNode;
+    psIter->psNextIter = oSymTable->psFirstIter;
+    oSymTable->psFirstIter = psIter;
+    return psIter;
+}
+
+
+int SymTable_iterNext(SymTable_Iter_T oIter,
+    const char **ppcKey, void **ppvValue)
+{
+    struct SymTableNode *psNode;
+
+    assert(oIter != NULL);
+    assert(ppcKey != NULL);
+    assert(ppvValue != NULL);
+
+    psNode = oIter->psNextNode;
+    if (psNode == NULL)
+        return 0;
+
+    *ppcKey = psNode->acKey;
+    *ppvValue = (void *) psNode->pvValue;
+    oIter->psNextNode = psNode->psNextNode;
+    return 1;
+}
+
+
+void SymTable_iterEnd(SymTable_Iter_T oIter)
+{
+    struct SymTableIter **ppsLink;
+
+    assert(oIter != NULL);
+
+    for (ppsLink = &oIter->oSymTable->psFirstIter; *ppsLink != oIter;
+        ppsLink = &(*ppsLink)->psNextIter)
+        assert(*ppsLink != NULL);
+    *ppsLink = oIter->psNextIter;
+    free(oIter);
+}
@@ -0,0 +1,905 @@
+/*
+symtableopen.c
+Author: David Wang
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "symtable.h"
+#include "symtableparallel.h"
+#include "symhash.h"
+#include "symparallel.h"
+
+/* SymTable_prefetch(pv) starts bringing the memory at pv into the
+cache without waiting for it, where the compiler offers a way to. */
+#if defined(__GNUC__)
+#define SymTable_prefetch(pv) __builtin_prefetch(pv)
+#else
+#define SymTable_prefetch(pv) ((void)(pv))
+#endif
+
+
+/* initial number of slots in the symbol table; always a power of 2 */
+static const size_t uInitSlotCount = 512;
+
+/* the table grows once more than uMaxLoadNum/uMaxLoadDen of its
+slots are occupied */
+static const size_t uMaxLoadNum = 7;
+static const size_t uMaxLoadDen = 8;
+
+/* SymTable_putBatch hashes each key and prefetches the slot where its
+probe starts BATCH_WINDOW keys before inserting it, so that the cache
+misses of that many keys are outstanding at once. */
+enum {BATCH_WINDOW = 16};
+
+/* SymTable_getBatch likewise hashes each key and prefetches its
+first slot LOOKUP_WINDOW keys before searching for it, and prefetches
+the key of that slot halfway in between if their hash codes agree. */
+enum {LOOKUP_WINDOW = 16};
+
+/* passed in place of a key's length when the caller knows only the
+key's hash code; such keys are compared with strcmp once the hash
+codes agree */
+static const size_t uUnknownKeyLength = (size_t)-1;
+
+/* Each binding is stored in a SymTableSlot. SymTableSlots are laid
+   out in one flat array and collisions are resolved by Robin Hood
+   linear probing. */
+struct SymTableSlot
+{
+    /* full hash code of the key; meaningful only if pcKey != NULL */
+    size_t uHash;
+
+    /* pointer to defensive copy of the key, '\0'-terminated,
+    or NULL if the slot is empty */
+    const char *pcKey;
+
+    /* length of the key in bytes, not counting the '\0' that ends
+    the copy */
+    size_t uKeyLength;
+
+    /* pointer to the value. */
+    const void *pvValue;
+};
+
+
+/* A SymTableMapping is one call of SymTable_mapParallel, shared by the
+   threads that carry it out. */
+struct SymTableMapping
+{
+    /* The SymTable being traversed */
+    SymTable_T oSymTable;
+
+    /* The function to apply to each binding, and its extra
+    parameter */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+
+/* A SymTable owns the array of slots. */
+struct SymTable
+{
+    /* Pointer to the first element of the array of slots. */
+    struct SymTableSlot *psSlots;
+
+    /* The number of slots in the array, always a power of 2 */
+    size_t uSlotCount;
+
+    /* The secret seed under which the hash codes of keys are rehashed
+    before they are stored, so that keys colliding in one SymTable need
+    not collide in another */
+    uint64_t uSeed;
+
+    /* The number of bindings in the SymTable */
+    size_t length;
+};
+
+
+/* Return the full hash code in oSymTable of a key whose
+   table-independent hash code is uHash. */
+static size_t SymTable_tableHash(SymTable_T oSymTable,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+
+    return (size_t)SymHash_tableHash(uHash, oSymTable->uSeed);
+}
+
+
+/* Return the full hash code in oSymTable for the uKeyLength bytes at
+   pcKey. The bits of the result are mixed so that its low-order bits
+   can be used directly as a slot index. */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uKeyLength)
+{
+    assert(pcKey != NULL);
+
+    return SymTable_tableHash(oSymTable, SymHash_hash(pcKey, uKeyLength));
+}
+
+
+/* Return the distance between index uIndex and the slot that
+   uHash prefers in an array of uSlotCount slots. */
+static size_t SymTable_probeDistance(size_t uHash, size_t uIndex,
+    size_t uSlotCount)
+{
+    return (uIndex - (uHash & (uSlotCount - 1))) & (uSlotCount - 1);
+}
+
+
+/* Place sBinding, whose key is owned by the table, at index uIndex of
+   the array psSlots of uSlotCount slots, where its probe distance is
+   uDistance. The array must contain at least one empty slot and must
+   not already contain sBinding's key, and uIndex must be an empty slot
+   or hold a binding closer to its preferred slot than uDistance.
+   Bindings that are closer to their preferred slot give way to the
+   incoming binding (Robin Hood hashing). */
+static void SymTable_insertAt(struct SymTableSlot *psSlots,
+    size_t uSlotCount, size_t uIndex, size_t uDistance,
+    struct SymTableSlot sBinding)
+{
+    struct SymTableSlot sCarried;
+    struct SymTableSlot sTemp;
+    size_t uResidentDistance;
+
+    assert(psSlots != NULL);
+    assert(sBinding.pcKey != NULL);
+
+    sCarried = sBinding;
+
+    for (; ; uIndex = (uIndex + 1) & (uSlotCount - 1))
+    {
+        if (psSlots[uIndex].pcKey == NULL) {
+            psSlots[uIndex] = sCarried;
+            return;
+        }
+        uResidentDistance = SymTable_probeDistance(
+            psSlots[uIndex].uHash, uIndex, uSlotCount);
+        if (uResidentDistance < uDistance) {
+            /* resident is richer: it gives up its slot and we
+            continue looking for a home for it instead */
+            sTemp = psSlots[uIndex];
+            psSlots[uIndex] = sCarried;
+            sCarried = sTemp;
+            uDistance = uResidentDistance;
+        }
+        uDistance++;
+    }
+}
+
+
+/* Insert sBinding, whose key is owned by the table, into the array
+   psSlots of uSlotCount slots, which must contain at least one empty
+   slot and must not already contain sBinding's key. */
+static void SymTable_insertSlot(struct SymTableSlot *psSlots,
+    size_t uSlotCount, struct SymTableSlot sBinding)
+{
+    SymTable_insertAt(psSlots, uSlotCount,
+        sBinding.uHash & (uSlotCount - 1), 0, sBinding);
+}
+
+
+/* Store in *puSlotCount the fewest slots, a power of 2 and at least
+   uInitSlotCount, that hold uCapacity bindings within the maximum
+   load, and return 1 (TRUE). Return 0 (FALSE) if so many slots could
+   not be indexed by a size_t. */
+static int SymTable_slotCountFor(size_t uCapacity, size_t *puSlotCount)
+{
+    size_t uSlotCount;
+
+    assert(puSlotCount != NULL);
+
+    for (uSlotCount = uInitSlotCount;
+        uCapacity > uSlotCount / uMaxLoadDen * uMaxLoadNum;
+        uSlotCount *= 2)
+        if (uSlotCount > (size_t)-1 / 2 / sizeof(struct SymTableSlot))
+            return 0;
+    *puSlotCount = uSlotCount;
+    return 1;
+}
+
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uSlotCount;
+
+    if (!SymTable_slotCountFor(uCapacity, &uSlotCount))
+        return NULL;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    /* calloc leaves every slot with a NULL key, i.e. empty */
+    oSymTable->psSlots = (struct SymTableSlot *)
+        calloc(uSlotCount, sizeof(struct SymTableSlot));
+    if (oSymTable->psSlots == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+
+    oSymTable->uSlotCount = uSlotCount;
+    oSymTable->uSeed = SymHash_newSeed();
+    oSymTable->length = 0;
+    return oSymTable;
+}
+
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    for (i=0; i<oSymTable->uSlotCount; i++)
+        free((char *) oSymTable->psSlots[i].pcKey);
+
+    free(oSymTable->psSlots);
+    free(oSymTable);
+}
+
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    return oSymTable->length;
+}
+
+
+/* Move every binding of oSymTable into a new array of uNewSlotCount
+   slots, a power of 2 with room for all of them, reinserting each
+   using its stored hash code. Return 1 (TRUE) if successful, or
+   0 (FALSE) if insufficient memory is available, in which case
+   oSymTable is unchanged. */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewSlotCount) {
+    size_t i;
+    struct SymTableSlot *psNewSlots;
+    struct SymTableSlot *psOldSlot;
+
+    assert(oSymTable != NULL);
+    assert(uNewSlotCount > oSymTable->length);
+
+    psNewSlots = (struct SymTableSlot *)
+        calloc(uNewSlotCount, sizeof(struct SymTableSlot));
+    if (psNewSlots == NULL)
+        return 0;
+
+    for (i=0; i<oSymTable->uSlotCount; i++) {
+        psOldSlot = &oSymTable->psSlots[i];
+        if (psOldSlot->pcKey != NULL)
+            SymTable_insertSlot(psNewSlots, uNewSlotCount, *psOldSlot);
+    }
+
+    free(oSymTable->psSlots);
+    oSymTable->psSlots = psNewSlots;
+    oSymTable->uSlotCount = uNewSlotCount;
+    return 1;
+}
+
+
+/* Double the number of slots in oSymTable. Return 1 (TRUE) if
+   successful, or 0 (FALSE) if the slot count cannot grow or
+   insufficient memory is available, in which case oSymTable is
+   unchanged. */
+static int SymTable_expand(SymTable_T oSymTable) {
+    size_t uNewSlotCount;
+
+    assert(oSymTable != NULL);
+
+    uNewSlotCount = oSymTable->uSlotCount * 2;
+    if (uNewSlotCount / 2 != oSymTable->uSlotCount ||
+        uNewSlotCount > (size_t)-1 / sizeof(struct SymTableSlot))
+        return 0;
+
+    return SymTable_resize(oSymTable, uNewSlotCount);
+}
+
+
+/* Halve the number of slots in oSymTable if fewer than an eighth of
+   them are occupied and it has more than uInitSlotCount. A halved
+   table is then less than a quarter full, far from the load at which
+   it grows, so a table whose length hovers around one threshold does
+   not resize back and forth. If insufficient memory is available,
+   leave oSymTable unchanged. */
+static void SymTable_contract(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    if (oSymTable->uSlotCount > uInitSlotCount &&
+        oSymTable->length < oSymTable->uSlotCount / 8)
+        (void)SymTable_resize(oSymTable, oSymTable->uSlotCount / 2);
+}
+
+
+/* Return 1 (TRUE) if psSlot holds the key pcKey, whose full hash code
+   is uHash and whose length is uKeyLength (or uUnknownKeyLength), and
+   0 (FALSE) otherwise. The key bytes are compared only if the hash
+   codes and lengths agree. */
+static int SymTable_slotMatches(const struct SymTableSlot *psSlot,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    assert(psSlot != NULL);
+    assert(pcKey != NULL);
+
+    if (psSlot->uHash != uHash)
+        return 0;
+    /* a stored key containing '\0' only looks equal to the string */
+    if (uKeyLength == uUnknownKeyLength)
+        return strcmp(psSlot->pcKey, pcKey) == 0 &&
+            strlen(psSlot->pcKey) == psSlot->uKeyLength;
+    return psSlot->uKeyLength == uKeyLength &&
+        memcmp(psSlot->pcKey, pcKey, uKeyLength) == 0;
+}
+
+
+/*
+Probe oSymTable for pcKey, whose full hash code is uHash and whose
+length is uKeyLength (or uUnknownKeyLength). If pcKey is present,
+store the index of its slot in *puIndex and return 1 (TRUE).
+Otherwise store in *puIndex the slot where pcKey belongs and in
+*puDistance its probe distance there, and return 0 (FALSE).
+*/
+static int SymTable_probe(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash, size_t uKeyLength, size_t *puIndex,
+    size_t *puDistance)
+{
+    const struct SymTableSlot *psSlot;
+    size_t uMask;
+    size_t uIndex;
+    size_t uDistance;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(puIndex != NULL);
+    assert(puDistance != NULL);
+
+    uMask = oSymTable->uSlotCount - 1;
+    for (uIndex = uHash & uMask, uDistance = 0; ;
+        uIndex = (uIndex + 1) & uMask, uDistance++)
+    {
+        psSlot = &oSymTable->psSlots[uIndex];
+        /* an empty slot, or a resident closer to home than we are,
+        means pcKey would have been placed before this point */
+        if (psSlot->pcKey == NULL ||
+            SymTable_probeDistance(psSlot->uHash, uIndex,
+                oSymTable->uSlotCount) < uDistance) {
+            *puIndex = uIndex;
+            *puDistance = uDistance;
+            return 0;
+        }
+        if (SymTable_slotMatches(psSlot, pcKey, uHash, uKeyLength)) {
+            *puIndex = uIndex;
+            return 1;
+        }
+    }
+}
+
+
+/*
+return the index of the slot in oSymTable whose key is pcKey, whose
+full hash code is uHash and whose length is uKeyLength (or
+uUnknownKeyLength). If no matching key exists in the symbol table,
+return oSymTable->uSlotCount.
+*/
+static size_t SymTable_findSlot(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    size_t uIndex;
+    size_t uDistance;
+
+    if (SymTable_probe(oSymTable, pcKey, uHash, uKeyLength, &uIndex,
+        &uDistance))
+        return uIndex;
+    return oSymTable->uSlotCount;
+}
+
+
+/*
+return the index of the slot in oSymTable whose key is the uKeyLength
+bytes at pcKey. If no matching key exists in the symbol table, return
+oSymTable->uSlotCount.
+*/
+static size_t SymTable_findKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength)
+{
+    return SymTable_findSlot(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength);
+}
+
+
+/*
+Do the work of SymTable_findOrInsert for pcKey, whose full hash code
+is uHash and whose length is uKeyLength (or uUnknownKeyLength).
+*/
+static void **SymTable_findOrInsertHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength,
+    const void *pvDefault, int *piInserted)
+{
+    size_t uIndex;
+    size_t uDistance;
+    char *pcKeyCopy;
+    struct SymTableSlot sBinding;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    *piInserted = 0;
+
+    /* probe for the key exactly once */
+    if (SymTable_probe(oSymTable, pcKey, uHash, uKeyLength, &uIndex,
+        &uDistance))
+        return (void **) &oSymTable->psSlots[uIndex].pvValue;
+
+    /* expand SymTable if necessary, which moves every binding and so
+    requires probing again; a table that cannot grow keeps accepting
+    bindings until it is full */
+    if ((oSymTable->length + 1) * uMaxLoadDen >
+        oSymTable->uSlotCount * uMaxLoadNum) {
+        if (SymTable_expand(oSymTable))
+            (void)SymTable_probe(oSymTable, pcKey, uHash, uKeyLength,
+                &uIndex, &uDistance);
+        else if (oSymTable->length == oSymTable->uSlotCount)
+            return NULL;
+    }
+
+    /* create defensive copy of key, which need not end in '\0' */
+    if (uKeyLength == uUnknownKeyLength)
+        uKeyLength = strlen(pcKey);
+    pcKeyCopy = (char *)malloc(uKeyLength+1);
+    if (pcKeyCopy == NULL)
+        return NULL;
+    memcpy(pcKeyCopy, pcKey, uKeyLength);
+    pcKeyCopy[uKeyLength] = '\0';
+
+    sBinding.uHash = uHash;
+    sBinding.pcKey = pcKeyCopy;
+    sBinding.uKeyLength = uKeyLength;
+    sBinding.pvValue = pvDefault;
+
+    /* the new binding takes the slot where the probe stopped, and
+    any binding it displaces moves further along */
+    SymTable_insertAt(oSymTable->psSlots, oSymTable->uSlotCount,
+        uIndex, uDistance, sBinding);
+    /* increment length of SymTable */
+    oSymTable->length += 1;
+    *piInserted = 1;
+    return (void **) &oSymTable->psSlots[uIndex].pvValue;
+}
+
+
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvDefault, int *piInserted)
+{
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    /* hash the key exactly once */
+    uKeyLength = strlen(pcKey);
+    return SymTable_findOrInsertHashed(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength, pvDefault,
+        piInserted);
+}
+
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+    const void **apvValues, size_t uCount, int *aiResults)
+{
+    size_t auHash[BATCH_WINDOW];
+    size_t auKeyLength[BATCH_WINDOW];
+    size_t i;
+    size_t uIndex;
+    size_t uAdded = 0;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvValues != NULL);
+
+    /* size the table for the whole batch at once, so that no insertion
+    moves the slots prefetched for the ones after it; without memory
+    for that, it grows as SymTable_put would grow it */
+    if (uCount <= (size_t)-1 - oSymTable->length)
+        (void)SymTable_reserve(oSymTable, oSymTable->length + uCount);
+
+    /* each pass inserts one key and hashes the key BATCH_WINDOW
+    ahead of it, into the entries of auHash and auKeyLength that the
+    insertion has just finished with */
+    for (i = 0; i < uCount + BATCH_WINDOW; i++) {
+        if (i >= BATCH_WINDOW) {
+            uIndex = i - BATCH_WINDOW;
+            (void)SymTable_findOrInsertHashed(oSymTable, apcKeys[uIndex],
+                auHash[uIndex % BATCH_WINDOW],
+                auKeyLength[uIndex % BATCH_WINDOW], apvValues[uIndex],
+                &iInserted);
+            if (aiResults != NULL)
+                aiResults[uIndex] = iInserted;
+            uAdded += (size_t)iInserted;
+        }
+
+        if (i < uCount) {
+            assert(apcKeys[i] != NULL);
+            auKeyLength[i % BATCH_WINDOW] = strlen(apcKeys[i]);
+            auHash[i % BATCH_WINDOW] = SymTable_hash(oSymTable,
+                apcKeys[i], auKeyLength[i % BATCH_WINDOW]);
+            SymTable_prefetch(&oSymTable->psSlots[
+                auHash[i % BATCH_WINDOW] & (oSymTable->uSlotCount - 1)]);
+        }
+    }
+    return uAdded;
+}
+
+
+SymTable_Hash_T SymTable_hashKey(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return SymHash_hash(pcKey, strlen(pcKey));
+}
+
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsertHashed(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength, pvValue,
+        &iInserted);
+    return iInserted;
+}
+
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    size_t uIndex;
+    const void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findKey(oSymTable, pcKey, strlen(pcKey));
+    if (uIndex == oSymTable->uSlotCount) {
+        return NULL;
+    }
+    pvOldValue = oSymTable->psSlots[uIndex].pvValue;
+    oSymTable->psSlots[uIndex].pvValue = pvValue;
+    return (void *) pvOldValue;
+}
+
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findKey(oSymTable, pcKey, strlen(pcKey));
+    if (uIndex == oSymTable->uSlotCount) {
+        return 0;
+    }
+    return 1;
+}
+
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findKey(oSymTable, pcKey, strlen(pcKey));
+    if (uIndex == oSymTable->uSlotCount) {
+        return NULL;
+    }
+    return (void *) oSymTable->psSlots[uIndex].pvValue;
+}
+
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+    size_t uCount, void **apvOut)
+{
+    size_t auHash[LOOKUP_WINDOW];
+    size_t auKeyLength[LOOKUP_WINDOW];
+    size_t i;
+    size_t uIndex;
+    size_t uSlot;
+    const struct SymTableSlot *psSlot;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvOut != NULL);
+
+    /* each pass searches for one key, looks at the first slot of the
+    key LOOKUP_WINDOW/2 behind the newest, and hashes the newest */
+    for (i = 0; i < uCount + LOOKUP_WINDOW; i++) {
+        if (i >= LOOKUP_WINDOW) {
+            uIndex = i - LOOKUP_WINDOW;
+            uSlot = SymTable_findSlot(oSymTable, apcKeys[uIndex],
+                auHash[uIndex % LOOKUP_WINDOW],
+                auKeyLength[uIndex % LOOKUP_WINDOW]);
+            apvOut[uIndex] = uSlot == oSymTable->uSlotCount ? NULL :
+                (void *) oSymTable->psSlots[uSlot].pvValue;
+        }
+
+        if (i >= LOOKUP_WINDOW/2 && i - LOOKUP_WINDOW/2 < uCount) {
+            uIndex = i - LOOKUP_WINDOW/2;
+            psSlot = &oSymTable->psSlots[auHash[uIndex % LOOKUP_WINDOW] &
+                (oSymTable->uSlotCount - 1)];
+            if (psSlot->pcKey != NULL &&
+                psSlot->uHash == auHash[uIndex % LOOKUP_WINDOW])
+                SymTable_prefetch(psSlot->pcKey);
+        }
+
+        if (i < uCount) {
+            assert(apcKeys[i] != NULL);
+            auKeyLength[i % LOOKUP_WINDOW] = strlen(apcKeys[i]);
+            auHash[i % LOOKUP_WINDOW] = SymTable_hash(oSymTable,
+                apcKeys[i], auKeyLength[i % LOOKUP_WINDOW]);
+            SymTable_prefetch(&oSymTable->psSlots[
+                auHash[i % LOOKUP_WINDOW] & (oSymTable->uSlotCount - 1)]);
+        }
+    }
+}
+
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findSlot(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength);
+    if (uIndex == oSymTable->uSlotCount) {
+        return NULL;
+    }
+    return (void *) oSymTable->psSlots[uIndex].pvValue;
+}
+
+
+/*
+If oSymTable contains a binding with key pcKey, whose full hash code
+is uHash and whose length is uKeyLength (or uUnknownKeyLength), remove
+that binding from oSymTable and return the binding's value.
+Otherwise, do not change oSymTable and return NULL.
+*/
+static void *SymTable_removeSlot(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    size_t uIndex;
+    size_t uNextIndex;
+    size_t uMask;
+    const void *pvValue;
+    struct SymTableSlot *psSlots;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findSlot(oSymTable, pcKey, uHash, uKeyLength);
+    if (uIndex == oSymTable->uSlotCount)
+        return NULL;
+
+    psSlots = oSymTable->psSlots;
+    uMask = oSymTable->uSlotCount - 1;
+    pvValue = psSlots[uIndex].pvValue;
+    free((char *) psSlots[uIndex].pcKey);
+
+    /* backward-shift deletion: pull each following binding that is
+    not in its preferred slot one step closer to it, so no
+    tombstone is left behind */
+    for (uNextIndex = (uIndex + 1) & uMask;
+        psSlots[uNextIndex].pcKey != NULL &&
+        SymTable_probeDistance(psSlots[uNextIndex].uHash, uNextIndex,
+            oSymTable->uSlotCount) != 0;
+        uNextIndex = (uNextIndex + 1) & uMask)
+    {
+        psSlots[uIndex] = psSlots[uNextIndex];
+        uIndex = uNextIndex;
+    }
+    psSlots[uIndex].pcKey = NULL;
+    psSlots[uIndex].pvValue = NULL;
+
+    /* decrement length of SymTable */
+    oSymTable->length -= 1;
+
+    /* shrink SymTable if necessary */
+    SymTable_contract(oSymTable);
+    return (void *) pvValue;
+}
+
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uKeyLength = strlen(pcKey);
+    return SymTable_removeSlot(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength);
+}
+
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_removeSlot(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength);
+}
+
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    (void)SymTable_findOrInsertHashed(oSymTable, (const char *)pvKey,
+        SymTable_hash(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_findKey(oSymTable, (const char *)pvKey, uKeyLength)
+        != oSymTable->uSlotCount;
+}
+
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    uIndex = SymTable_findKey(oSymTable, (const char *)pvKey, uKeyLength);
+    if (uIndex == oSymTable->uSlotCount) {
+        return NULL;
+    }
+    return (void *) oSymTable->psSlots[uIndex].pvValue;
+}
+
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_removeSlot(oSymTable, (const char *)pvKey,
+        SymTable_hash(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength);
+}
+
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    if (!SymTable_slotCountFor(uCapacity, &uSlotCount))
+        return 0;
+    if (uSlotCount <= oSymTable->uSlotCount)
+        return 1;
+    return SymTable_resize(oSymTable, uSlotCount);
+}
+
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    if (SymTable_slotCountFor(oSymTable->length, &uSlotCount) &&
+        uSlotCount < oSymTable->uSlotCount)
+        (void)SymTable_resize(oSymTable, uSlotCount);
+}
+
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    size_t i;
+    const struct SymTableSlot *psSlot;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (i=0; i<oSymTable->uSlotCount; i++) {
+        psSlot = &oSymTable->psSlots[i];
+        if (psSlot->pcKey != NULL)
+            (*pfApply)(psSlot->pcKey, (void*)psSlot->pvValue,
+                (void*)pvExtra);
+    }
+}
+
+
+/* Apply the function of the SymTableMapping pvMapping to the binding
+   in each occupied slot among the slots uBegin through uEnd - 1 of its
+   table. */
+static void SymTable_mapSlots(size_t uBegin, size_t uEnd,
+    void *pvMapping)
+{
+    const struct SymTableMapping *psMapping =
+        (const struct SymTableMapping *)pvMapping;
+    const struct SymTableSlot *psSlot;
+    size_t i;
+
+    assert(psMapping != NULL);
+
+    for (i = uBegin; i < uEnd; i++) {
+        psSlot = &psMapping->oSymTable->psSlots[i];
+        if (psSlot->pcKey != NULL)
+            (*psMapping->pfApply)(psSlot->pcKey, (void*)psSlot->pvValue,
+                (void*)psMapping->pvExtra);
+    }
+}
+
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, size_t uThreadCount)
+{
+    struct SymTableMapping sMapping;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    sMapping.oSymTable = oSymTable;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymParallel_run(oSymTable->uSlotCount, SymTable_mapSlots, &sMapping,
+        uThreadCount);
+}
@@ -0,0 +1,54 @@
+/*
+symtableordered.h
+Author: David Wang
+*/
+
+#ifndef SYMTABLEORDERED_INCLUDED
+#define SYMTABLEORDERED_INCLUDED
+#include "symtable.h"
+
+/*
+Ordered operations, provided by the implementations of symtable.h that
+keep their keys sorted. Keys are ordered byte by byte as unsigned
+chars, and a key orders before every longer key that it begins, so
+strings order as strcmp orders them. SymTable_map visits the bindings
+of such an implementation in ascending key order.
+*/
+
+/*
+Apply function *pfApply to each binding in oSymTable whose key is at
+least pcLo and at most pcHi, in ascending key order, passing pvExtra
+as an extra parameter. A NULL pcLo or pcHi leaves that end of the
+range open. pfApply must not add or remove bindings.
+*/
+void SymTable_mapRange(SymTable_T oSymTable,
+    const char *pcLo, const char *pcHi,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*
+Apply function *pfApply to each binding in oSymTable whose key begins
+with pcPrefix, in ascending key order, passing pvExtra as an extra
+parameter. The work done is proportional to the number of matching
+bindings, plus the cost of one search. pfApply must not add or remove
+bindings.
+*/
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*
+Return the greatest key in oSymTable that is at most pcKey, or NULL
+if every key is greater. The returned key is oSymTable's own copy,
+valid until its binding is removed.
+*/
+const char *SymTable_floor(SymTable_T oSymTable, const char *pcKey);
+
+/*
+Return the least key in oSymTable that is at least pcKey, or NULL if
+every key is less. The returned key is oSymTable's own copy, valid
+until its binding is removed.
+*/
+const char *SymTable_ceiling(SymTable_T oSymTable, const char *pcKey);
+
+#endif
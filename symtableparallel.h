@@ -0,0 +1,34 @@
+/*
+symtableparallel.h
+Author: David Wang
+*/
+
+#ifndef SYMTABLEPARALLEL_INCLUDED
+#define SYMTABLEPARALLEL_INCLUDED
+#include <stddef.h>
+#include "symtable.h"
+
+/*
+Parallel traversal, provided by the implementations of symtable.h that
+keep their bindings in an array of buckets or slots: the expanding
+hash, open, Swiss and concurrent tables.
+*/
+
+/*
+Apply function *pfApply to each binding in oSymTable, passing pvExtra
+as an extra parameter, on up to uThreadCount threads at once, the
+calling thread among them, in no particular order. The array is split
+into chunks, and a thread that runs out of chunks takes half of those
+another has left, so a slow chunk does not hold the others up. If
+fewer threads can be started, the ones that are finish the work; a
+uThreadCount of 0 or 1 uses the calling thread alone. pfApply must be
+safe to call from several threads at once, and must not call any
+function on oSymTable. In the concurrent table, other threads may look
+keys up meanwhile, but calls that change the table wait until the
+traversal is done.
+*/
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, size_t uThreadCount);
+
+#endif
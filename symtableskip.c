@@ -0,0 +1,667 @@
+/*
+symtableskip.c
+Author: David Wang
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "symtable.h"
+#include "symtableordered.h"
+#include "symhash.h"
+
+
+/* the most levels a node may have; with one node in four promoted to
+each next level, enough for far more bindings than fit in memory */
+enum {MAX_LEVEL_COUNT = 24};
+
+/* Each binding is stored in a SymTableNode. SymTableNodes are linked
+   in ascending key order on level 0, and every node on level i + 1 is
+   also on level i, so a search descends the levels from the top,
+   skipping most nodes, in O(log n) expected steps. A node, its
+   forward links and the defensive copy of its key are a single
+   allocation, so a comparison during a search touches the node it has
+   already reached. */
+struct SymTableNode
+{
+    /* pointer to the value. */
+    const void *pvValue;
+
+    /* length of the key in bytes, not counting the '\0' that ends
+    the copy */
+    size_t uKeyLength;
+
+    /* number of levels the node is linked on */
+    int iLevelCount;
+
+    /* apsNext[i] is the address of the next SymTableNode on level i;
+    the defensive copy of the key, '\0'-terminated, follows the last
+    link */
+    struct SymTableNode *apsNext[];
+};
+
+
+/* A SymTable is a "dummy" node that points to the first SymTableNode
+   on every level. */
+struct SymTable
+{
+    /* The head node, which has MAX_LEVEL_COUNT levels and no key */
+    struct SymTableNode *psHead;
+
+    /* The number of levels on which at least one node is linked */
+    int iLevelCount;
+
+    /* The state of the generator that chooses node levels */
+    uint64_t uRandom;
+
+    /* The number of bindings in the SymTable */
+    size_t length;
+};
+
+
+/* Return the key of psNode. */
+static const char *SymTable_nodeKey(const struct SymTableNode *psNode)
+{
+    assert(psNode != NULL);
+
+    return (const char *)&psNode->apsNext[psNode->iLevelCount];
+}
+
+
+/* Return a negative number, 0, or a positive number according to
+   whether the key of psNode orders before, with, or after the key of
+   uKeyLength bytes at pcKey. */
+static int SymTable_compare(const struct SymTableNode *psNode,
+    const char *pcKey, size_t uKeyLength)
+{
+    int iCompare;
+
+    assert(psNode != NULL);
+    assert(pcKey != NULL);
+
+    iCompare = memcmp(SymTable_nodeKey(psNode), pcKey,
+        psNode->uKeyLength < uKeyLength ? psNode->uKeyLength : uKeyLength);
+    if (iCompare != 0)
+        return iCompare;
+    return (psNode->uKeyLength > uKeyLength) -
+        (psNode->uKeyLength < uKeyLength);
+}
+
+
+/* Return the number of levels for a new node of oSymTable: 1, and
+   one more with probability 1/4 for each level above that. */
+static int SymTable_randomLevelCount(SymTable_T oSymTable)
+{
+    uint64_t uRandom;
+    int iLevelCount = 1;
+
+    assert(oSymTable != NULL);
+
+    /* xorshift64 */
+    uRandom = oSymTable->uRandom;
+    uRandom ^= uRandom << 13;
+    uRandom ^= uRandom >> 7;
+    uRandom ^= uRandom << 17;
+    oSymTable->uRandom = uRandom;
+
+    for (; iLevelCount < MAX_LEVEL_COUNT && (uRandom & 3) == 0;
+        uRandom >>= 2)
+        iLevelCount++;
+    return iLevelCount;
+}
+
+
+/*
+Search oSymTable for the key of uKeyLength bytes at pcKey, storing in
+apsUpdate[i], for each level i in use, the last node on level i whose
+key orders before pcKey (possibly the head). Return the node that
+follows apsUpdate[0] on level 0, which is the first node whose key is
+at least pcKey, or NULL if there is none.
+*/
+static struct SymTableNode *SymTable_search(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength,
+    struct SymTableNode *apsUpdate[])
+{
+    struct SymTableNode *psNode;
+    int iLevel;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(apsUpdate != NULL);
+
+    psNode = oSymTable->psHead;
+    for (iLevel = oSymTable->iLevelCount - 1; iLevel >= 0; iLevel--) {
+        while (psNode->apsNext[iLevel] != NULL &&
+            SymTable_compare(psNode->apsNext[iLevel], pcKey,
+                uKeyLength) < 0)
+            psNode = psNode->apsNext[iLevel];
+        apsUpdate[iLevel] = psNode;
+    }
+    return psNode->apsNext[0];
+}
+
+
+/*
+Return the first node of oSymTable whose key is at least the key of
+uKeyLength bytes at pcKey, or NULL if there is none.
+*/
+static struct SymTableNode *SymTable_lowerBound(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength)
+{
+    struct SymTableNode *apsUpdate[MAX_LEVEL_COUNT];
+
+    return SymTable_search(oSymTable, pcKey, uKeyLength, apsUpdate);
+}
+
+
+/*
+return a pointer to the SymTableNode in oSymTable whose key is the
+uKeyLength bytes at pcKey. If no matching key exists in the symbol
+table, return NULL.
+*/
+static struct SymTableNode *SymTable_getNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength)
+{
+    struct SymTableNode *psNode;
+
+    psNode = SymTable_lowerBound(oSymTable, pcKey, uKeyLength);
+    if (psNode == NULL || SymTable_compare(psNode, pcKey, uKeyLength) != 0)
+        return NULL;
+    return psNode;
+}
+
+
+SymTable_T SymTable_new(void)
+{
+    SymTable_T oSymTable;
+    int iLevel;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    oSymTable->psHead = (struct SymTableNode *)malloc(
+        sizeof(struct SymTableNode) +
+        MAX_LEVEL_COUNT * sizeof(struct SymTableNode *) + 1);
+    if (oSymTable->psHead == NULL) {
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->psHead->pvValue = NULL;
+    oSymTable->psHead->uKeyLength = 0;
+    oSymTable->psHead->iLevelCount = MAX_LEVEL_COUNT;
+    for (iLevel = 0; iLevel < MAX_LEVEL_COUNT; iLevel++)
+        oSymTable->psHead->apsNext[iLevel] = NULL;
+    ((char *)&oSymTable->psHead->apsNext[MAX_LEVEL_COUNT])[0] = '\0';
+
+    oSymTable->iLevelCount = 1;
+    /* xorshift64 needs a nonzero state */
+    oSymTable->uRandom = SymHash_newSeed() | 1;
+    oSymTable->length = 0;
+    return oSymTable;
+}
+
+
+/* a skip list allocates each node as it is added, so it has nothing
+to size in advance */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    (void)uCapacity;
+    return SymTable_new();
+}
+
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    struct SymTableNode *psCurrentNode;
+    struct SymTableNode *psNextNode;
+
+    assert(oSymTable != NULL);
+
+    for (psCurrentNode = oSymTable->psHead;
+        psCurrentNode != NULL;
+        psCurrentNode = psNextNode)
+    {
+        psNextNode = psCurrentNode->apsNext[0];
+        free(psCurrentNode);
+    }
+
+    free(oSymTable);
+}
+
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    return oSymTable->length;
+}
+
+
+/*
+return a pointer to the SymTableNode in oSymTable whose key is the
+uKeyLength bytes at pcKey, and set *piInserted to 0 (FALSE). If no
+such node exists, add one with value pvDefault, set *piInserted to
+1 (TRUE), and return it. If insufficient memory is available, leave
+oSymTable unchanged, set *piInserted to 0 (FALSE), and return NULL.
+*/
+static struct SymTableNode *SymTable_findOrInsertNode(
+    SymTable_T oSymTable, const char *pcKey, size_t uKeyLength,
+    const void *pvDefault, int *piInserted)
+{
+    struct SymTableNode *apsUpdate[MAX_LEVEL_COUNT];
+    struct SymTableNode *psNode;
+    char *pcKeyCopy;
+    int iLevelCount;
+    int iLevel;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    *piInserted = 0;
+
+    /* search for the key exactly once */
+    psNode = SymTable_search(oSymTable, pcKey, uKeyLength, apsUpdate);
+    if (psNode != NULL && SymTable_compare(psNode, pcKey, uKeyLength) == 0)
+        return psNode;
+
+    iLevelCount = SymTable_randomLevelCount(oSymTable);
+
+    /* allocate the node together with its links and its key */
+    psNode = (struct SymTableNode *)malloc(sizeof(struct SymTableNode) +
+        (size_t)iLevelCount * sizeof(struct SymTableNode *) +
+        uKeyLength + 1);
+    if (psNode == NULL)
+        return NULL;
+
+    psNode->pvValue = pvDefault;
+    psNode->uKeyLength = uKeyLength;
+    psNode->iLevelCount = iLevelCount;
+
+    /* create defensive copy of key, which need not end in '\0' */
+    pcKeyCopy = (char *)&psNode->apsNext[iLevelCount];
+    memcpy(pcKeyCopy, pcKey, uKeyLength);
+    pcKeyCopy[uKeyLength] = '\0';
+
+    /* levels above those in use are reached from the head */
+    for (iLevel = oSymTable->iLevelCount; iLevel < iLevelCount; iLevel++)
+        apsUpdate[iLevel] = oSymTable->psHead;
+    if (iLevelCount > oSymTable->iLevelCount)
+        oSymTable->iLevelCount = iLevelCount;
+
+    for (iLevel = 0; iLevel < iLevelCount; iLevel++) {
+        psNode->apsNext[iLevel] = apsUpdate[iLevel]->apsNext[iLevel];
+        apsUpdate[iLevel]->apsNext[iLevel] = psNode;
+    }
+
+    /* increment length of SymTable */
+    oSymTable->length += 1;
+    *piInserted = 1;
+    return psNode;
+}
+
+
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvDefault, int *piInserted)
+{
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    psNode = SymTable_findOrInsertNode(oSymTable, pcKey, strlen(pcKey),
+        pvDefault, piInserted);
+    if (psNode == NULL)
+        return NULL;
+    return (void **) &psNode->pvValue;
+}
+
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+/* each insertion's path depends on the links the last one changed,
+so the batch is put one binding at a time */
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+    const void **apvValues, size_t uCount, int *aiResults)
+{
+    size_t i;
+    size_t uAdded = 0;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvValues != NULL);
+
+    for (i = 0; i < uCount; i++) {
+        iInserted = SymTable_put(oSymTable, apcKeys[i], apvValues[i]);
+        if (aiResults != NULL)
+            aiResults[i] = iInserted;
+        uAdded += (size_t)iInserted;
+    }
+    return uAdded;
+}
+
+
+SymTable_Hash_T SymTable_hashKey(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return SymHash_hash(pcKey, strlen(pcKey));
+}
+
+
+/* A skip list orders its keys rather than hashing them, so the
+   SymTable_*Hashed functions ignore the hash code. */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash, const void *pvValue)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)uHash;
+    return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    struct SymTableNode *psNode;
+    const void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = SymTable_getNode(oSymTable, pcKey, strlen(pcKey));
+    if (psNode == NULL)
+        return NULL;
+    pvOldValue = psNode->pvValue;
+    psNode->pvValue = pvValue;
+    return (void *) pvOldValue;
+}
+
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_getNode(oSymTable, pcKey, strlen(pcKey)) != NULL;
+}
+
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = SymTable_getNode(oSymTable, pcKey, strlen(pcKey));
+    if (psNode == NULL)
+        return NULL;
+    return (void *) psNode->pvValue;
+}
+
+
+/* each step of a skip list search follows a link of the node the last
+step reached, so the batch is searched one key at a time */
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+    size_t uCount, void **apvOut)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvOut != NULL);
+
+    for (i = 0; i < uCount; i++)
+        apvOut[i] = SymTable_get(oSymTable, apcKeys[i]);
+}
+
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)uHash;
+    return SymTable_get(oSymTable, pcKey);
+}
+
+
+/*
+If oSymTable contains a binding whose key is the uKeyLength bytes at
+pcKey, remove that binding from oSymTable and return the binding's
+value. Otherwise, do not change oSymTable and return NULL.
+*/
+static void *SymTable_removeNode(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength)
+{
+    struct SymTableNode *apsUpdate[MAX_LEVEL_COUNT];
+    struct SymTableNode *psNode;
+    const void *pvValue;
+    int iLevel;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = SymTable_search(oSymTable, pcKey, uKeyLength, apsUpdate);
+    if (psNode == NULL || SymTable_compare(psNode, pcKey, uKeyLength) != 0)
+        return NULL;
+
+    /* unlink the node on every level it is linked on */
+    for (iLevel = 0; iLevel < psNode->iLevelCount; iLevel++)
+        apsUpdate[iLevel]->apsNext[iLevel] = psNode->apsNext[iLevel];
+    while (oSymTable->iLevelCount > 1 &&
+        oSymTable->psHead->apsNext[oSymTable->iLevelCount - 1] == NULL)
+        oSymTable->iLevelCount--;
+
+    pvValue = psNode->pvValue;
+    free(psNode);
+    /* decrement length of SymTable */
+    oSymTable->length -= 1;
+    return (void *) pvValue;
+}
+
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_removeNode(oSymTable, pcKey, strlen(pcKey));
+}
+
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)uHash;
+    return SymTable_remove(oSymTable, pcKey);
+}
+
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    (void)SymTable_findOrInsertNode(oSymTable, (const char *)pvKey,
+        uKeyLength, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_getNode(oSymTable, (const char *)pvKey, uKeyLength)
+        != NULL;
+}
+
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    psNode = SymTable_getNode(oSymTable, (const char *)pvKey, uKeyLength);
+    if (psNode == NULL)
+        return NULL;
+    return (void *) psNode->pvValue;
+}
+
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_removeNode(oSymTable, (const char *)pvKey, uKeyLength);
+}
+
+
+/* as for SymTable_newWithCapacity, there is nothing to size */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    assert(oSymTable != NULL);
+
+    (void)uCapacity;
+    return 1;
+}
+
+
+/* every node is allocated on its own, at its own height, and freed as
+soon as it is removed, so there is nothing to give back */
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+}
+
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    SymTable_mapRange(oSymTable, NULL, NULL, pfApply, pvExtra);
+}
+
+
+void SymTable_mapRange(SymTable_T oSymTable,
+    const char *pcLo, const char *pcHi,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableNode *psCurrentNode;
+    size_t uHiLength = 0;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    if (pcLo == NULL)
+        psCurrentNode = oSymTable->psHead->apsNext[0];
+    else
+        psCurrentNode = SymTable_lowerBound(oSymTable, pcLo, strlen(pcLo));
+    if (pcHi != NULL)
+        uHiLength = strlen(pcHi);
+
+    /* level 0 holds every node in ascending key order */
+    for (; psCurrentNode != NULL &&
+        (pcHi == NULL ||
+            SymTable_compare(psCurrentNode, pcHi, uHiLength) <= 0);
+        psCurrentNode = psCurrentNode->apsNext[0])
+        (*pfApply)(SymTable_nodeKey(psCurrentNode),
+            (void*)psCurrentNode->pvValue, (void*)pvExtra);
+}
+
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    struct SymTableNode *psCurrentNode;
+    size_t uPrefixLength;
+
+    assert(oSymTable != NULL);
+    assert(pcPrefix != NULL);
+    assert(pfApply != NULL);
+
+    /* the keys that begin with pcPrefix are consecutive, starting at
+    the least key that is at least pcPrefix */
+    uPrefixLength = strlen(pcPrefix);
+    for (psCurrentNode = SymTable_lowerBound(oSymTable, pcPrefix,
+            uPrefixLength);
+        psCurrentNode != NULL &&
+            psCurrentNode->uKeyLength >= uPrefixLength &&
+            memcmp(SymTable_nodeKey(psCurrentNode), pcPrefix,
+                uPrefixLength) == 0;
+        psCurrentNode = psCurrentNode->apsNext[0])
+        (*pfApply)(SymTable_nodeKey(psCurrentNode),
+            (void*)psCurrentNode->pvValue, (void*)pvExtra);
+}
+
+
+const char *SymTable_floor(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableNode *psNode;
+    size_t uKeyLength;
+    int iLevel;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /* descend to the last node whose key is at most pcKey */
+    uKeyLength = strlen(pcKey);
+    psNode = oSymTable->psHead;
+    for (iLevel = oSymTable->iLevelCount - 1; iLevel >= 0; iLevel--)
+        while (psNode->apsNext[iLevel] != NULL &&
+            SymTable_compare(psNode->apsNext[iLevel], pcKey,
+                uKeyLength) <= 0)
+            psNode = psNode->apsNext[iLevel];
+
+    if (psNode == oSymTable->psHead)
+        return NULL;
+    return SymTable_nodeKey(psNode);
+}
+
+
+const char *SymTable_ceiling(SymTable_T oSymTable, const char *pcKey)
+{
+    struct SymTableNode *psNode;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = SymTable_lowerBound(oSymTable, pcKey, strlen(pcKey));
+    if (psNode == NULL)
+        return NULL;
+    return SymTable_nodeKey(psNode);
+}
@@ -0,0 +1,1010 @@
+/*
+symtableswiss.c
+Author: David Wang
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "symtable.h"
+#include "symtableparallel.h"
+#include "symhash.h"
+#include "symparallel.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* SymTable_prefetch(pv) starts bringing the memory at pv into the
+cache without waiting for it, where the compiler offers a way to. */
+#if defined(__GNUC__)
+#define SymTable_prefetch(pv) __builtin_prefetch(pv)
+#else
+#define SymTable_prefetch(pv) ((void)(pv))
+#endif
+
+
+/* initial number of slots in the symbol table; always a power of 2
+and a multiple of uGroupWidth */
+static const size_t uInitSlotCount = 512;
+
+/* number of slots whose control bytes are examined together */
+static const size_t uGroupWidth = 16;
+
+/* the table is rebuilt once more than uMaxLoadNum/uMaxLoadDen of its
+slots are occupied or deleted */
+static const size_t uMaxLoadNum = 7;
+static const size_t uMaxLoadDen = 8;
+
+/* control byte values; a slot holding a binding has a control byte
+holding the low 7 bits of the binding's hash code, so its high bit is
+clear */
+static const unsigned char ucEmpty = 0x80;
+static const unsigned char ucDeleted = 0xFE;
+
+/* SymTable_putBatch hashes each key and prefetches the control bytes
+and slots of the first group it probes BATCH_WINDOW keys before
+inserting it, so that the cache misses of that many keys are
+outstanding at once. */
+enum {BATCH_WINDOW = 16};
+
+/* SymTable_getBatch likewise hashes each key and prefetches its first
+group LOOKUP_WINDOW keys before searching for it, and prefetches the
+key of the group's first likely match halfway in between. */
+enum {LOOKUP_WINDOW = 16};
+
+/* passed in place of a key's length when the caller knows only the
+key's hash code; such keys are compared with strcmp once the hash
+codes agree */
+static const size_t uUnknownKeyLength = (size_t)-1;
+
+/* Each binding is stored in a SymTableSlot. SymTableSlots are laid
+   out in one flat array, divided into groups of uGroupWidth slots,
+   with a parallel array of one control byte per slot. A lookup
+   compares the control bytes of a whole group with 7 bits of the hash
+   code at once and examines only the slots that agree, so most
+   misses never read a key. Collisions are resolved by probing the
+   groups quadratically. */
+struct SymTableSlot
+{
+    /* full hash code of the key */
+    size_t uHash;
+
+    /* pointer to defensive copy of the key, '\0'-terminated */
+    const char *pcKey;
+
+    /* length of the key in bytes, not counting the '\0' that ends
+    the copy */
+    size_t uKeyLength;
+
+    /* pointer to the value. */
+    const void *pvValue;
+};
+
+
+/* A SymTableMapping is one call of SymTable_mapParallel, shared by the
+   threads that carry it out. */
+struct SymTableMapping
+{
+    /* The SymTable being traversed */
+    SymTable_T oSymTable;
+
+    /* The function to apply to each binding, and its extra
+    parameter */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    const void *pvExtra;
+};
+
+
+/* A SymTable owns the array of slots and their control bytes. */
+struct SymTable
+{
+    /* Pointer to the first of uSlotCount control bytes. A slot's
+    control byte is ucEmpty, ucDeleted, or the low 7 bits of the hash
+    code of the binding it holds. */
+    unsigned char *pucControl;
+
+    /* Pointer to the first element of the array of slots. A slot is
+    meaningful only if its control byte says it holds a binding. */
+    struct SymTableSlot *psSlots;
+
+    /* The number of slots in the array, always a power of 2 and a
+    multiple of uGroupWidth */
+    size_t uSlotCount;
+
+    /* The number of empty slots that may still be filled before the
+    table is rebuilt */
+    size_t uGrowthLeft;
+
+    /* The secret seed under which the hash codes of keys are rehashed
+    before they are stored, so that keys colliding in one SymTable need
+    not collide in another */
+    uint64_t uSeed;
+
+    /* The number of bindings in the SymTable */
+    size_t length;
+};
+
+
+/* Return the full hash code in oSymTable of a key whose
+   table-independent hash code is uHash. */
+static size_t SymTable_tableHash(SymTable_T oSymTable,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+
+    return (size_t)SymHash_tableHash(uHash, oSymTable->uSeed);
+}
+
+
+/* Return the full hash code in oSymTable for the uKeyLength bytes at
+   pcKey. The bits of the result are mixed, so its low 7 bits serve as
+   the control byte and the remaining bits choose the first group. */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+    size_t uKeyLength)
+{
+    assert(pcKey != NULL);
+
+    return SymTable_tableHash(oSymTable, SymHash_hash(pcKey, uKeyLength));
+}
+
+
+/* Return the control byte of a binding whose full hash code is
+   uHash. */
+static unsigned char SymTable_controlByte(size_t uHash)
+{
+    return (unsigned char)(uHash & 0x7F);
+}
+
+
+/* Return the index of the first group probed for a binding whose full
+   hash code is uHash, in an array of uSlotCount slots. */
+static size_t SymTable_firstGroup(size_t uHash, size_t uSlotCount)
+{
+    return (uHash >> 7) & (uSlotCount / uGroupWidth - 1);
+}
+
+
+/* Return a mask with bit i set if the i-th control byte of the group
+   pucGroup equals ucByte. */
+static unsigned SymTable_matchByte(const unsigned char *pucGroup,
+    unsigned char ucByte)
+{
+#if defined(__SSE2__)
+    __m128i vGroup;
+
+    assert(pucGroup != NULL);
+
+    vGroup = _mm_loadu_si128((const __m128i *)(const void *)pucGroup);
+    return (unsigned)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(vGroup, _mm_set1_epi8((char)ucByte)));
+#else
+    unsigned uMask = 0;
+    size_t i;
+
+    assert(pucGroup != NULL);
+
+    for (i = 0; i < uGroupWidth; i++)
+        if (pucGroup[i] == ucByte)
+            uMask |= 1u << i;
+    return uMask;
+#endif
+}
+
+
+/* Return a mask with bit i set if the i-th slot of the group pucGroup
+   is empty or deleted, i.e. if the high bit of its control byte is
+   set. */
+static unsigned SymTable_matchFree(const unsigned char *pucGroup)
+{
+#if defined(__SSE2__)
+    assert(pucGroup != NULL);
+
+    return (unsigned)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)(const void *)pucGroup));
+#else
+    unsigned uMask = 0;
+    size_t i;
+
+    assert(pucGroup != NULL);
+
+    for (i = 0; i < uGroupWidth; i++)
+        if ((pucGroup[i] & 0x80) != 0)
+            uMask |= 1u << i;
+    return uMask;
+#endif
+}
+
+
+/* Return the index of the lowest set bit of uMask, which must not be
+   0. */
+static size_t SymTable_lowestBit(unsigned uMask)
+{
+#if defined(__GNUC__)
+    assert(uMask != 0);
+
+    return (size_t)__builtin_ctz(uMask);
+#else
+    size_t uBit = 0;
+
+    assert(uMask != 0);
+
+    for (; (uMask & 1u) == 0; uMask >>= 1)
+        uBit++;
+    return uBit;
+#endif
+}
+
+
+/* Return the maximum number of slots of an array of uSlotCount slots
+   that may be occupied or deleted. */
+static size_t SymTable_capacity(size_t uSlotCount)
+{
+    return uSlotCount / uMaxLoadDen * uMaxLoadNum;
+}
+
+
+/* Return the index of the first empty or deleted slot in the probe
+   sequence of a binding whose full hash code is uHash, in the arrays
+   pucControl of uSlotCount control bytes, which must contain at least
+   one empty slot. */
+static size_t SymTable_findFree(const unsigned char *pucControl,
+    size_t uSlotCount, size_t uHash)
+{
+    size_t uGroupMask;
+    size_t uGroup;
+    size_t uStep;
+    unsigned uFree;
+
+    assert(pucControl != NULL);
+
+    uGroupMask = uSlotCount / uGroupWidth - 1;
+    /* triangular steps visit every group of a power-of-2 count */
+    for (uGroup = SymTable_firstGroup(uHash, uSlotCount), uStep = 1; ;
+        uGroup = (uGroup + uStep++) & uGroupMask)
+    {
+        uFree = SymTable_matchFree(&pucControl[uGroup * uGroupWidth]);
+        if (uFree != 0)
+            return uGroup * uGroupWidth + SymTable_lowestBit(uFree);
+    }
+}
+
+
+/* Rebuild oSymTable with uNewSlotCount slots, reinserting every
+   binding using its stored hash code and dropping every deleted slot.
+   Return 1 (TRUE) if successful, or 0 (FALSE) if insufficient memory
+   is available, in which case oSymTable is unchanged. */
+static int SymTable_rebuild(SymTable_T oSymTable, size_t uNewSlotCount)
+{
+    size_t i;
+    size_t uIndex;
+    unsigned char *pucNewControl;
+    struct SymTableSlot *psNewSlots;
+
+    assert(oSymTable != NULL);
+    assert(uNewSlotCount % uGroupWidth == 0);
+
+    pucNewControl = (unsigned char *)malloc(uNewSlotCount);
+    if (pucNewControl == NULL)
+        return 0;
+    psNewSlots = (struct SymTableSlot *)
+        malloc(uNewSlotCount * sizeof(struct SymTableSlot));
+    if (psNewSlots == NULL) {
+        free(pucNewControl);
+        return 0;
+    }
+    memset(pucNewControl, ucEmpty, uNewSlotCount);
+
+    for (i=0; i<oSymTable->uSlotCount; i++) {
+        if ((oSymTable->pucControl[i] & 0x80) != 0)
+            continue;
+        uIndex = SymTable_findFree(pucNewControl, uNewSlotCount,
+            oSymTable->psSlots[i].uHash);
+        pucNewControl[uIndex] = oSymTable->pucControl[i];
+        psNewSlots[uIndex] = oSymTable->psSlots[i];
+    }
+
+    free(oSymTable->pucControl);
+    free(oSymTable->psSlots);
+    oSymTable->pucControl = pucNewControl;
+    oSymTable->psSlots = psNewSlots;
+    oSymTable->uSlotCount = uNewSlotCount;
+    oSymTable->uGrowthLeft = SymTable_capacity(uNewSlotCount) -
+        oSymTable->length;
+    return 1;
+}
+
+
+/* Make room in oSymTable for one more binding in an empty slot: if
+   deleted slots make up a large share of the table, rebuild it at the
+   same size to reclaim them, and otherwise double it. Return 1 (TRUE)
+   if successful, or 0 (FALSE) if the slot count cannot grow or
+   insufficient memory is available, in which case oSymTable is
+   unchanged. */
+static int SymTable_makeRoom(SymTable_T oSymTable)
+{
+    size_t uNewSlotCount;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->length < SymTable_capacity(oSymTable->uSlotCount) / 2)
+        return SymTable_rebuild(oSymTable, oSymTable->uSlotCount);
+
+    uNewSlotCount = oSymTable->uSlotCount * 2;
+    if (uNewSlotCount / 2 != oSymTable->uSlotCount ||
+        uNewSlotCount > (size_t)-1 / sizeof(struct SymTableSlot))
+        return 0;
+    return SymTable_rebuild(oSymTable, uNewSlotCount);
+}
+
+
+/* Rebuild oSymTable with half as many slots if fewer than an eighth of
+   them hold bindings and it has more than uInitSlotCount. A halved
+   table is then less than a quarter full, far from the load at which
+   it grows, so a table whose length hovers around one threshold does
+   not rebuild back and forth. If insufficient memory is available,
+   leave oSymTable unchanged. */
+static void SymTable_contract(SymTable_T oSymTable)
+{
+    assert(oSymTable != NULL);
+
+    if (oSymTable->uSlotCount > uInitSlotCount &&
+        oSymTable->length < oSymTable->uSlotCount / 8)
+        (void)SymTable_rebuild(oSymTable, oSymTable->uSlotCount / 2);
+}
+
+
+/* Store in *puSlotCount the fewest slots, a power of 2 and at least
+   uInitSlotCount, that hold uCapacity bindings within the maximum
+   load, and return 1 (TRUE). Return 0 (FALSE) if so many slots could
+   not be indexed by a size_t. */
+static int SymTable_slotCountFor(size_t uCapacity, size_t *puSlotCount)
+{
+    size_t uSlotCount;
+
+    assert(puSlotCount != NULL);
+
+    for (uSlotCount = uInitSlotCount;
+        uCapacity > SymTable_capacity(uSlotCount); uSlotCount *= 2)
+        if (uSlotCount > (size_t)-1 / 2 / sizeof(struct SymTableSlot))
+            return 0;
+    *puSlotCount = uSlotCount;
+    return 1;
+}
+
+
+SymTable_T SymTable_new(void)
+{
+    return SymTable_newWithCapacity(0);
+}
+
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity)
+{
+    SymTable_T oSymTable;
+    size_t uSlotCount;
+
+    if (!SymTable_slotCountFor(uCapacity, &uSlotCount))
+        return NULL;
+
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable == NULL)
+        return NULL;
+
+    oSymTable->pucControl = (unsigned char *)malloc(uSlotCount);
+    oSymTable->psSlots = (struct SymTableSlot *)
+        malloc(uSlotCount * sizeof(struct SymTableSlot));
+    if (oSymTable->pucControl == NULL || oSymTable->psSlots == NULL) {
+        free(oSymTable->pucControl);
+        free(oSymTable->psSlots);
+        free(oSymTable);
+        return NULL;
+    }
+    memset(oSymTable->pucControl, ucEmpty, uSlotCount);
+
+    oSymTable->uSlotCount = uSlotCount;
+    oSymTable->uGrowthLeft = SymTable_capacity(uSlotCount);
+    oSymTable->uSeed = SymHash_newSeed();
+    oSymTable->length = 0;
+    return oSymTable;
+}
+
+
+void SymTable_free(SymTable_T oSymTable)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    for (i=0; i<oSymTable->uSlotCount; i++)
+        if ((oSymTable->pucControl[i] & 0x80) == 0)
+            free((char *) oSymTable->psSlots[i].pcKey);
+
+    free(oSymTable->pucControl);
+    free(oSymTable->psSlots);
+    free(oSymTable);
+}
+
+
+size_t SymTable_getLength(SymTable_T oSymTable) {
+    assert(oSymTable != NULL);
+
+    return oSymTable->length;
+}
+
+
+/* Return 1 (TRUE) if psSlot holds the key pcKey, whose full hash code
+   is uHash and whose length is uKeyLength (or uUnknownKeyLength), and
+   0 (FALSE) otherwise. The key bytes are compared only if the hash
+   codes and lengths agree. */
+static int SymTable_slotMatches(const struct SymTableSlot *psSlot,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    assert(psSlot != NULL);
+    assert(pcKey != NULL);
+
+    if (psSlot->uHash != uHash)
+        return 0;
+    /* a stored key containing '\0' only looks equal to the string */
+    if (uKeyLength == uUnknownKeyLength)
+        return strcmp(psSlot->pcKey, pcKey) == 0 &&
+            strlen(psSlot->pcKey) == psSlot->uKeyLength;
+    return psSlot->uKeyLength == uKeyLength &&
+        memcmp(psSlot->pcKey, pcKey, uKeyLength) == 0;
+}
+
+
+/*
+return the index of the slot in oSymTable whose key is pcKey, whose
+full hash code is uHash and whose length is uKeyLength (or
+uUnknownKeyLength). If no matching key exists in the symbol table,
+return oSymTable->uSlotCount.
+*/
+static size_t SymTable_findSlot(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    const unsigned char *pucGroup;
+    size_t uGroupMask;
+    size_t uGroup;
+    size_t uStep;
+    size_t uIndex;
+    unsigned uMatches;
+    unsigned char ucControl;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ucControl = SymTable_controlByte(uHash);
+    uGroupMask = oSymTable->uSlotCount / uGroupWidth - 1;
+    for (uGroup = SymTable_firstGroup(uHash, oSymTable->uSlotCount),
+        uStep = 1; ; uGroup = (uGroup + uStep++) & uGroupMask)
+    {
+        pucGroup = &oSymTable->pucControl[uGroup * uGroupWidth];
+
+        /* only slots whose control byte agrees are examined */
+        for (uMatches = SymTable_matchByte(pucGroup, ucControl);
+            uMatches != 0; uMatches &= uMatches - 1)
+        {
+            uIndex = uGroup * uGroupWidth + SymTable_lowestBit(uMatches);
+            if (SymTable_slotMatches(&oSymTable->psSlots[uIndex], pcKey,
+                uHash, uKeyLength))
+                return uIndex;
+        }
+
+        /* an empty slot means pcKey would have been placed in this
+        group or an earlier one */
+        if (SymTable_matchByte(pucGroup, ucEmpty) != 0)
+            return oSymTable->uSlotCount;
+    }
+}
+
+
+/*
+return the index of the slot in oSymTable whose key is the uKeyLength
+bytes at pcKey. If no matching key exists in the symbol table, return
+oSymTable->uSlotCount.
+*/
+static size_t SymTable_findKey(SymTable_T oSymTable,
+    const char *pcKey, size_t uKeyLength)
+{
+    return SymTable_findSlot(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength);
+}
+
+
+/*
+Do the work of SymTable_findOrInsert for pcKey, whose full hash code
+is uHash and whose length is uKeyLength (or uUnknownKeyLength).
+*/
+static void **SymTable_findOrInsertHashed(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength,
+    const void *pvDefault, int *piInserted)
+{
+    size_t uIndex;
+    char *pcKeyCopy;
+    struct SymTableSlot *psSlot;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    *piInserted = 0;
+
+    uIndex = SymTable_findSlot(oSymTable, pcKey, uHash, uKeyLength);
+    if (uIndex != oSymTable->uSlotCount)
+        return (void **) &oSymTable->psSlots[uIndex].pvValue;
+
+    /* a deleted slot can be reused without using up growth, so the
+    table is rebuilt only if the new binding needs an empty slot */
+    uIndex = SymTable_findFree(oSymTable->pucControl,
+        oSymTable->uSlotCount, uHash);
+    if (oSymTable->pucControl[uIndex] == ucEmpty &&
+        oSymTable->uGrowthLeft == 0) {
+        if (! SymTable_makeRoom(oSymTable))
+            return NULL;
+        uIndex = SymTable_findFree(oSymTable->pucControl,
+            oSymTable->uSlotCount, uHash);
+    }
+
+    /* create defensive copy of key, which need not end in '\0' */
+    if (uKeyLength == uUnknownKeyLength)
+        uKeyLength = strlen(pcKey);
+    pcKeyCopy = (char *)malloc(uKeyLength+1);
+    if (pcKeyCopy == NULL)
+        return NULL;
+    memcpy(pcKeyCopy, pcKey, uKeyLength);
+    pcKeyCopy[uKeyLength] = '\0';
+
+    if (oSymTable->pucControl[uIndex] == ucEmpty)
+        oSymTable->uGrowthLeft -= 1;
+    oSymTable->pucControl[uIndex] = SymTable_controlByte(uHash);
+    psSlot = &oSymTable->psSlots[uIndex];
+    psSlot->uHash = uHash;
+    psSlot->pcKey = pcKeyCopy;
+    psSlot->uKeyLength = uKeyLength;
+    psSlot->pvValue = pvDefault;
+
+    /* increment length of SymTable */
+    oSymTable->length += 1;
+    *piInserted = 1;
+    return (void **) &psSlot->pvValue;
+}
+
+
+void **SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvDefault, int *piInserted)
+{
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    assert(piInserted != NULL);
+
+    /* hash the key exactly once */
+    uKeyLength = strlen(pcKey);
+    return SymTable_findOrInsertHashed(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength, pvDefault,
+        piInserted);
+}
+
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+size_t SymTable_putBatch(SymTable_T oSymTable, const char **apcKeys,
+    const void **apvValues, size_t uCount, int *aiResults)
+{
+    size_t auHash[BATCH_WINDOW];
+    size_t auKeyLength[BATCH_WINDOW];
+    size_t i;
+    size_t uIndex;
+    size_t uFirstSlot;
+    size_t uAdded = 0;
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvValues != NULL);
+
+    /* size the table for the whole batch at once, so that no insertion
+    moves the groups prefetched for the ones after it; without memory
+    for that, it grows as SymTable_put would grow it */
+    if (uCount <= (size_t)-1 - oSymTable->length)
+        (void)SymTable_reserve(oSymTable, oSymTable->length + uCount);
+
+    /* each pass inserts one key and hashes the key BATCH_WINDOW
+    ahead of it, into the entries of auHash and auKeyLength that the
+    insertion has just finished with */
+    for (i = 0; i < uCount + BATCH_WINDOW; i++) {
+        if (i >= BATCH_WINDOW) {
+            uIndex = i - BATCH_WINDOW;
+            (void)SymTable_findOrInsertHashed(oSymTable, apcKeys[uIndex],
+                auHash[uIndex % BATCH_WINDOW],
+                auKeyLength[uIndex % BATCH_WINDOW], apvValues[uIndex],
+                &iInserted);
+            if (aiResults != NULL)
+                aiResults[uIndex] = iInserted;
+            uAdded += (size_t)iInserted;
+        }
+
+        if (i < uCount) {
+            assert(apcKeys[i] != NULL);
+            auKeyLength[i % BATCH_WINDOW] = strlen(apcKeys[i]);
+            auHash[i % BATCH_WINDOW] = SymTable_hash(oSymTable,
+                apcKeys[i], auKeyLength[i % BATCH_WINDOW]);
+            uFirstSlot = SymTable_firstGroup(auHash[i % BATCH_WINDOW],
+                oSymTable->uSlotCount) * uGroupWidth;
+            SymTable_prefetch(&oSymTable->pucControl[uFirstSlot]);
+            SymTable_prefetch(&oSymTable->psSlots[uFirstSlot]);
+        }
+    }
+    return uAdded;
+}
+
+
+SymTable_Hash_T SymTable_hashKey(const char *pcKey)
+{
+    assert(pcKey != NULL);
+
+    return SymHash_hash(pcKey, strlen(pcKey));
+}
+
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    (void)SymTable_findOrInsertHashed(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength, pvValue,
+        &iInserted);
+    return iInserted;
+}
+
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue)
+{
+    size_t uIndex;
+    const void *pvOldValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findKey(oSymTable, pcKey, strlen(pcKey));
+    if (uIndex == oSymTable->uSlotCount) {
+        return NULL;
+    }
+    pvOldValue = oSymTable->psSlots[uIndex].pvValue;
+    oSymTable->psSlots[uIndex].pvValue = pvValue;
+    return (void *) pvOldValue;
+}
+
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findKey(oSymTable, pcKey, strlen(pcKey));
+    if (uIndex == oSymTable->uSlotCount) {
+        return 0;
+    }
+    return 1;
+}
+
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findKey(oSymTable, pcKey, strlen(pcKey));
+    if (uIndex == oSymTable->uSlotCount) {
+        return NULL;
+    }
+    return (void *) oSymTable->psSlots[uIndex].pvValue;
+}
+
+
+void SymTable_getBatch(SymTable_T oSymTable, const char **apcKeys,
+    size_t uCount, void **apvOut)
+{
+    size_t auHash[LOOKUP_WINDOW];
+    size_t auKeyLength[LOOKUP_WINDOW];
+    size_t i;
+    size_t uIndex;
+    size_t uSlot;
+    size_t uFirstSlot;
+    unsigned uMatch;
+
+    assert(oSymTable != NULL);
+    assert(apcKeys != NULL);
+    assert(apvOut != NULL);
+
+    /* each pass searches for one key, looks at the first group of the
+    key LOOKUP_WINDOW/2 behind the newest, and hashes the newest */
+    for (i = 0; i < uCount + LOOKUP_WINDOW; i++) {
+        if (i >= LOOKUP_WINDOW) {
+            uIndex = i - LOOKUP_WINDOW;
+            uSlot = SymTable_findSlot(oSymTable, apcKeys[uIndex],
+                auHash[uIndex % LOOKUP_WINDOW],
+                auKeyLength[uIndex % LOOKUP_WINDOW]);
+            apvOut[uIndex] = uSlot == oSymTable->uSlotCount ? NULL :
+                (void *) oSymTable->psSlots[uSlot].pvValue;
+        }
+
+        if (i >= LOOKUP_WINDOW/2 && i - LOOKUP_WINDOW/2 < uCount) {
+            uIndex = i - LOOKUP_WINDOW/2;
+            uFirstSlot = SymTable_firstGroup(auHash[uIndex % LOOKUP_WINDOW],
+                oSymTable->uSlotCount) * uGroupWidth;
+            uMatch = SymTable_matchByte(&oSymTable->pucControl[uFirstSlot],
+                SymTable_controlByte(auHash[uIndex % LOOKUP_WINDOW]));
+            if (uMatch != 0)
+                SymTable_prefetch(oSymTable->psSlots[uFirstSlot +
+                    SymTable_lowestBit(uMatch)].pcKey);
+        }
+
+        if (i < uCount) {
+            assert(apcKeys[i] != NULL);
+            auKeyLength[i % LOOKUP_WINDOW] = strlen(apcKeys[i]);
+            auHash[i % LOOKUP_WINDOW] = SymTable_hash(oSymTable,
+                apcKeys[i], auKeyLength[i % LOOKUP_WINDOW]);
+            uFirstSlot = SymTable_firstGroup(auHash[i % LOOKUP_WINDOW],
+                oSymTable->uSlotCount) * uGroupWidth;
+            SymTable_prefetch(&oSymTable->pucControl[uFirstSlot]);
+            SymTable_prefetch(&oSymTable->psSlots[uFirstSlot]);
+        }
+    }
+}
+
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findSlot(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength);
+    if (uIndex == oSymTable->uSlotCount) {
+        return NULL;
+    }
+    return (void *) oSymTable->psSlots[uIndex].pvValue;
+}
+
+
+/*
+If oSymTable contains a binding with key pcKey, whose full hash code
+is uHash and whose length is uKeyLength (or uUnknownKeyLength), remove
+that binding from oSymTable and return the binding's value.
+Otherwise, do not change oSymTable and return NULL.
+*/
+static void *SymTable_removeSlot(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, size_t uKeyLength)
+{
+    size_t uIndex;
+    const void *pvValue;
+    const unsigned char *pucGroup;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uIndex = SymTable_findSlot(oSymTable, pcKey, uHash, uKeyLength);
+    if (uIndex == oSymTable->uSlotCount)
+        return NULL;
+
+    pvValue = oSymTable->psSlots[uIndex].pvValue;
+    free((char *) oSymTable->psSlots[uIndex].pcKey);
+
+    /* a probe moves past a group only if the group has no empty slot,
+    and a group never regains one except here, so a group that still
+    has an empty slot was never probed past and its slot can become
+    empty again; otherwise it must be marked deleted */
+    pucGroup = &oSymTable->pucControl[uIndex - uIndex % uGroupWidth];
+    if (SymTable_matchByte(pucGroup, ucEmpty) != 0) {
+        oSymTable->pucControl[uIndex] = ucEmpty;
+        oSymTable->uGrowthLeft += 1;
+    }
+    else
+        oSymTable->pucControl[uIndex] = ucDeleted;
+
+    /* decrement length of SymTable */
+    oSymTable->length -= 1;
+
+    /* shrink SymTable if necessary */
+    SymTable_contract(oSymTable);
+    return (void *) pvValue;
+}
+
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey)
+{
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uKeyLength = strlen(pcKey);
+    return SymTable_removeSlot(oSymTable, pcKey,
+        SymTable_hash(oSymTable, pcKey, uKeyLength), uKeyLength);
+}
+
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+    SymTable_Hash_T uHash)
+{
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    return SymTable_removeSlot(oSymTable, pcKey,
+        SymTable_tableHash(oSymTable, uHash), uUnknownKeyLength);
+}
+
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength, const void *pvValue)
+{
+    int iInserted;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    (void)SymTable_findOrInsertHashed(oSymTable, (const char *)pvKey,
+        SymTable_hash(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength, pvValue, &iInserted);
+    return iInserted;
+}
+
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_findKey(oSymTable, (const char *)pvKey, uKeyLength)
+        != oSymTable->uSlotCount;
+}
+
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    size_t uIndex;
+
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    uIndex = SymTable_findKey(oSymTable, (const char *)pvKey, uKeyLength);
+    if (uIndex == oSymTable->uSlotCount) {
+        return NULL;
+    }
+    return (void *) oSymTable->psSlots[uIndex].pvValue;
+}
+
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+    size_t uKeyLength)
+{
+    assert(oSymTable != NULL);
+    assert(pvKey != NULL);
+
+    return SymTable_removeSlot(oSymTable, (const char *)pvKey,
+        SymTable_hash(oSymTable, (const char *)pvKey, uKeyLength),
+        uKeyLength);
+}
+
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    /* deleted slots count against the growth left, so a table with
+    enough slots may still need rebuilding to take uCapacity bindings
+    without rebuilding again */
+    if (uCapacity <= oSymTable->length ||
+        uCapacity - oSymTable->length <= oSymTable->uGrowthLeft)
+        return 1;
+    if (!SymTable_slotCountFor(uCapacity, &uSlotCount))
+        return 0;
+    if (uSlotCount < oSymTable->uSlotCount)
+        uSlotCount = oSymTable->uSlotCount;
+    return SymTable_rebuild(oSymTable, uSlotCount);
+}
+
+
+void SymTable_shrinkToFit(SymTable_T oSymTable)
+{
+    size_t uSlotCount;
+
+    assert(oSymTable != NULL);
+
+    if (SymTable_slotCountFor(oSymTable->length, &uSlotCount) &&
+        uSlotCount < oSymTable->uSlotCount)
+        (void)SymTable_rebuild(oSymTable, uSlotCount);
+}
+
+
+void SymTable_map(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra)
+{
+    size_t i;
+    const struct SymTableSlot *psSlot;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (i=0; i<oSymTable->uSlotCount; i++) {
+        if ((oSymTable->pucControl[i] & 0x80) != 0)
+            continue;
+        psSlot = &oSymTable->psSlots[i];
+        (*pfApply)(psSlot->pcKey, (void*)psSlot->pvValue,
+            (void*)pvExtra);
+    }
+}
+
+
+/* Apply the function of the SymTableMapping pvMapping to the binding
+   in each full slot among the slots uBegin through uEnd - 1 of its
+   table. */
+static void SymTable_mapSlots(size_t uBegin, size_t uEnd,
+    void *pvMapping)
+{
+    const struct SymTableMapping *psMapping =
+        (const struct SymTableMapping *)pvMapping;
+    SymTable_T oSymTable;
+    const struct SymTableSlot *psSlot;
+    size_t i;
+
+    assert(psMapping != NULL);
+
+    oSymTable = psMapping->oSymTable;
+    for (i = uBegin; i < uEnd; i++) {
+        if ((oSymTable->pucControl[i] & 0x80) != 0)
+            continue;
+        psSlot = &oSymTable->psSlots[i];
+        (*psMapping->pfApply)(psSlot->pcKey, (void*)psSlot->pvValue,
+            (void*)psMapping->pvExtra);
+    }
+}
+
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra, size_t uThreadCount)
+{
+    struct SymTableMapping sMapping;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    sMapping.oSymTable = oSymTable;
+    sMapping.pfApply = pfApply;
+    sMapping.pvExtra = pvExtra;
+    SymParallel_run(oSymTable->uSlotCount, SymTable_mapSlots, &sMapping,
+        uThreadCount);
+}
@@ -14,6 +14,10 @@
 #include <sys/resource.h>
 #endif
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
 /*--------------------------------------------------------------------*/
 
 #define ASSURE(i) assure(i, __LINE__)
@@ -83,6 +87,21 @@ static void printBindingSimple(const char *pcKey, void *pvValue,
 
 /*--------------------------------------------------------------------*/
 
+/* Count the binding whose key is pcKey by incrementing the int
+   pointed to by pvExtra. pvValue is unused. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   (void)pvValue;
+   (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the most basic SymTable functions. */
 
 static void testBasics(void)
@@ -467,6 +486,328 @@ static void testEmptyTable(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test the SymTable_findOrInsert() function. */
+
+static void testFindOrInsert(void)
+{
+   SymTable_T oSymTable;
+   char acJeter[] = "Jeter";
+   char acMantle[] = "Mantle";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
+
+   void **ppvValue;
+   char *pcValue;
+   int iInserted;
+   int iSuccessful;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_findOrInsert() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An absent key is inserted with the default value. */
+   ppvValue = SymTable_findOrInsert(oSymTable, acJeter, acShortstop,
+      &iInserted);
+   ASSURE(ppvValue != NULL);
+   ASSURE(iInserted);
+   ASSURE((ppvValue != NULL) && (*ppvValue == acShortstop));
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   /* A present key keeps its value and is not inserted again. */
+   ppvValue = SymTable_findOrInsert(oSymTable, acJeter, acCenterField,
+      &iInserted);
+   ASSURE(ppvValue != NULL);
+   ASSURE(! iInserted);
+   ASSURE((ppvValue != NULL) && (*ppvValue == acShortstop));
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 1);
+
+   /* Storing through the returned address replaces the value. */
+   if (ppvValue != NULL)
+      *ppvValue = acFirstBase;
+   pcValue = (char*)SymTable_get(oSymTable, acJeter);
+   ASSURE(pcValue == acFirstBase);
+
+   /* SymTable_put() agrees with SymTable_findOrInsert(). */
+   iSuccessful = SymTable_put(oSymTable, acJeter, acCenterField);
+   ASSURE(! iSuccessful);
+
+   ppvValue = SymTable_findOrInsert(oSymTable, acMantle, NULL,
+      &iInserted);
+   ASSURE(ppvValue != NULL);
+   ASSURE(iInserted);
+   ASSURE((ppvValue != NULL) && (*ppvValue == NULL));
+
+   iSuccessful = SymTable_contains(oSymTable, acMantle);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_hashKey(), SymTable_putHashed(),
+   SymTable_getHashed(), and SymTable_removeHashed() functions. */
+
+static void testHashedKeys(void)
+{
+   SymTable_T oSymTable1;
+   SymTable_T oSymTable2;
+   char acJeter[] = "Jeter";
+   char acMantle[] = "Mantle";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acRightField[] = "Right Field";
+
+   SymTable_Hash_T uJeterHash;
+   SymTable_Hash_T uMantleHash;
+   char *pcValue;
+   int iSuccessful;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the precomputed-hash functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable1 = SymTable_new();
+   ASSURE(oSymTable1 != NULL);
+   oSymTable2 = SymTable_new();
+   ASSURE(oSymTable2 != NULL);
+
+   /* A hash code depends only on the key. */
+   uJeterHash = SymTable_hashKey(acJeter);
+   uMantleHash = SymTable_hashKey(acMantle);
+   ASSURE(uJeterHash == SymTable_hashKey("Jeter"));
+
+   /* One hash code can be reused across tables. */
+   iSuccessful = SymTable_putHashed(oSymTable1, acJeter, uJeterHash,
+      acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putHashed(oSymTable2, acJeter, uJeterHash,
+      acRightField);
+   ASSURE(iSuccessful);
+
+   iSuccessful = SymTable_putHashed(oSymTable1, acJeter, uJeterHash,
+      acCenterField);
+   ASSURE(! iSuccessful);
+
+   /* The hashed and unhashed functions agree. */
+   pcValue = (char*)SymTable_get(oSymTable1, acJeter);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_getHashed(oSymTable2, acJeter,
+      uJeterHash);
+   ASSURE(pcValue == acRightField);
+
+   iSuccessful = SymTable_put(oSymTable1, acMantle, acCenterField);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_getHashed(oSymTable1, acMantle,
+      uMantleHash);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_getHashed(oSymTable2, acMantle,
+      uMantleHash);
+   ASSURE(pcValue == NULL);
+
+   pcValue = (char*)SymTable_removeHashed(oSymTable1, acJeter,
+      uJeterHash);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_removeHashed(oSymTable1, acJeter,
+      uJeterHash);
+   ASSURE(pcValue == NULL);
+
+   iSuccessful = SymTable_contains(oSymTable1, acJeter);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_contains(oSymTable2, acJeter);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable1);
+   ASSURE(uLength == 1);
+   uLength = SymTable_getLength(oSymTable2);
+   ASSURE(uLength == 1);
+
+   SymTable_free(oSymTable1);
+   SymTable_free(oSymTable2);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_putN(), SymTable_containsN(), SymTable_getN(),
+   and SymTable_removeN() functions. */
+
+static void testBinaryKeys(void)
+{
+   SymTable_T oSymTable;
+   const char acBuffer[] = "Jeter,Mantle";
+   const char acBinary[] = {'a', 'b', '\0', 'c'};
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
+   char acSecondBase[] = "Second Base";
+
+   char *pcValue;
+   int iSuccessful;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing length-delimited and binary keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Keys can be slices of a larger buffer. */
+   iSuccessful = SymTable_putN(oSymTable, acBuffer, 5, acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer + 6, 6,
+      acCenterField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer, 5, acFirstBase);
+   ASSURE(! iSuccessful);
+
+   /* A slice and a string with the same characters are one key. */
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   iSuccessful = SymTable_put(oSymTable, "Mantle", acFirstBase);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_getN(oSymTable, "Mantle", 6);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_getHashed(oSymTable, "Mantle",
+      SymTable_hashKey("Mantle"));
+   ASSURE(pcValue == acCenterField);
+
+   iSuccessful = SymTable_containsN(oSymTable, acBuffer, 4);
+   ASSURE(! iSuccessful);
+
+   /* Keys may contain '\0' bytes, and a key is distinct from its
+      prefixes. */
+   iSuccessful = SymTable_putN(oSymTable, acBinary, 4, acFirstBase);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBinary, 3, acSecondBase);
+   ASSURE(iSuccessful);
+
+   iSuccessful = SymTable_contains(oSymTable, "ab");
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_getHashed(oSymTable, "ab",
+      SymTable_hashKey("ab"));
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_getN(oSymTable, acBinary, 4);
+   ASSURE(pcValue == acFirstBase);
+   pcValue = (char*)SymTable_getN(oSymTable, acBinary, 3);
+   ASSURE(pcValue == acSecondBase);
+
+   iSuccessful = SymTable_put(oSymTable, "ab", acShortstop);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 5);
+
+   pcValue = (char*)SymTable_removeN(oSymTable, acBinary, 4);
+   ASSURE(pcValue == acFirstBase);
+   pcValue = (char*)SymTable_removeN(oSymTable, acBinary, 4);
+   ASSURE(pcValue == NULL);
+   pcValue = (char*)SymTable_removeN(oSymTable, "ab", 2);
+   ASSURE(pcValue == acShortstop);
+
+   iSuccessful = SymTable_containsN(oSymTable, acBinary, 3);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 3);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the speed of SymTable_hashKey() on keys of several lengths,
+   reporting cycles per byte where the processor's cycle counter is
+   available, and nanoseconds per byte otherwise. */
+
+static void testHashSpeed(void)
+{
+   enum {MAX_KEY_LENGTH = 4096};
+   enum {BYTES_PER_LENGTH = 1 << 26};
+   static const int aiKeyLengths[] = {8, 32, 256, 4096};
+
+   char *pcKey;
+   size_t uLengthIndex;
+   int iKeyLength;
+   int iRepetitions;
+   int i;
+   SymTable_Hash_T uSum;
+   double dPerByte;
+#if defined(__x86_64__) || defined(__i386__)
+   unsigned long long uInitialCycles;
+#else
+   clock_t iInitialClock;
+#endif
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the speed of the hash function.\n");
+   printf("No output except hashing cost should appear here:\n");
+   fflush(stdout);
+
+   pcKey = (char*)malloc(MAX_KEY_LENGTH + 1);
+   ASSURE(pcKey != NULL);
+   if (pcKey == NULL)
+      return;
+
+   for (uLengthIndex = 0;
+      uLengthIndex < sizeof(aiKeyLengths) / sizeof(aiKeyLengths[0]);
+      uLengthIndex++)
+   {
+      iKeyLength = aiKeyLengths[uLengthIndex];
+      for (i = 0; i < iKeyLength; i++)
+         pcKey[i] = (char)('a' + i % 26);
+      pcKey[iKeyLength] = '\0';
+      iRepetitions = BYTES_PER_LENGTH / iKeyLength;
+
+      /* Vary the key so that no call can be skipped, and use every
+         hash code. */
+      uSum = 0;
+#if defined(__x86_64__) || defined(__i386__)
+      uInitialCycles = __rdtsc();
+#else
+      iInitialClock = clock();
+#endif
+      for (i = 0; i < iRepetitions; i++)
+      {
+         pcKey[0] = (char)('a' + (uSum & 15));
+         uSum += SymTable_hashKey(pcKey);
+      }
+#if defined(__x86_64__) || defined(__i386__)
+      dPerByte = (double)(__rdtsc() - uInitialCycles) /
+         ((double)iRepetitions * iKeyLength);
+      printf("Cycles per byte to hash (%d-byte keys):  %f\n",
+         iKeyLength, dPerByte);
+#else
+      dPerByte = (double)(clock() - iInitialClock) * 1e9 /
+         CLOCKS_PER_SEC / ((double)iRepetitions * iKeyLength);
+      printf("Nanoseconds per byte to hash (%d-byte keys):  %f\n",
+         iKeyLength, dPerByte);
+#endif
+      ASSURE(uSum != 0);
+   }
+   fflush(stdout);
+
+   free(pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to contain an empty key. */
 
 static void testEmptyKey(void)
@@ -776,6 +1117,205 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Test the ability of a SymTable object to hold many bindings whose
+   keys were all given the same hash code, while the table grows
+   around them and while they are removed again. */
+
+static void testSharedHash(void)
+{
+   enum {SHARED_COUNT = 1000, OTHER_COUNT = 2000, KEPT_COUNT = 5};
+
+   SymTable_T oSymTable;
+   char acKey[32];
+   int aiValues[SHARED_COUNT];
+   int iSuccessful;
+   int i;
+   int iCount;
+   int *piValue;
+   size_t uLength;
+   SymTable_Hash_T uSharedHash;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing many keys with one shared hash code.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   uSharedHash = SymTable_hashKey("shared");
+
+   /* Interleave the shared-hash keys with ordinary ones, so that the
+      table resizes while the shared bucket is large. */
+   for (i = 0; i < OTHER_COUNT; i++)
+   {
+      if (i < SHARED_COUNT)
+      {
+         sprintf(acKey, "shared%d", i);
+         aiValues[i] = i;
+         iSuccessful = SymTable_putHashed(oSymTable, acKey, uSharedHash,
+            &aiValues[i]);
+         ASSURE(iSuccessful);
+      }
+      sprintf(acKey, "other%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[0]);
+      ASSURE(iSuccessful);
+   }
+
+   sprintf(acKey, "shared%d", 0);
+   iSuccessful = SymTable_putHashed(oSymTable, acKey, uSharedHash,
+      &aiValues[1]);
+   ASSURE(! iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == SHARED_COUNT + OTHER_COUNT);
+
+   for (i = 0; i < SHARED_COUNT; i++)
+   {
+      sprintf(acKey, "shared%d", i);
+      piValue = (int*)SymTable_getHashed(oSymTable, acKey, uSharedHash);
+      ASSURE(piValue == &aiValues[i]);
+   }
+   sprintf(acKey, "shared%d", SHARED_COUNT);
+   piValue = (int*)SymTable_getHashed(oSymTable, acKey, uSharedHash);
+   ASSURE(piValue == NULL);
+
+   /* Remove all but a few of the shared-hash keys, in an order that
+      is neither ascending nor descending. */
+   for (i = 0; i < SHARED_COUNT - KEPT_COUNT; i++)
+   {
+      sprintf(acKey, "shared%d", (i * 7) % (SHARED_COUNT - KEPT_COUNT));
+      piValue = (int*)SymTable_removeHashed(oSymTable, acKey,
+         uSharedHash);
+      ASSURE(piValue == &aiValues[(i * 7) % (SHARED_COUNT - KEPT_COUNT)]);
+   }
+
+   for (i = 0; i < SHARED_COUNT; i++)
+   {
+      sprintf(acKey, "shared%d", i);
+      piValue = (int*)SymTable_getHashed(oSymTable, acKey, uSharedHash);
+      if (i < SHARED_COUNT - KEPT_COUNT)
+         ASSURE(piValue == NULL);
+      else
+         ASSURE(piValue == &aiValues[i]);
+   }
+
+   for (i = 0; i < OTHER_COUNT; i++)
+   {
+      sprintf(acKey, "other%d", i);
+      iSuccessful = SymTable_contains(oSymTable, acKey);
+      ASSURE(iSuccessful);
+   }
+
+   iCount = 0;
+   SymTable_map(oSymTable, countBinding, &iCount);
+   ASSURE(iCount == OTHER_COUNT + KEPT_COUNT);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test how the cost of SymTable_get() grows with the number of
+   bindings whose keys all have the same hash code under any hash
+   function that multiplies by an odd constant per character modulo
+   2^64, such as the hash from the assignment specification. Each key
+   is a sequence of blocks, each either the Thue-Morse string of
+   length 1024 over 'a' and 'b' or its complement; all such keys of
+   the same length collide under such a hash. */
+
+static void testCollidingKeys(void)
+{
+   enum {BLOCK_LENGTH = 1024};
+   enum {BLOCK_COUNT = 11};
+   enum {KEY_SIZE = BLOCK_COUNT * BLOCK_LENGTH + 1};
+   enum {KEY_COUNT = 1 << BLOCK_COUNT};
+   enum {LOOKUPS_PER_COUNT = 1 << 11};
+   enum {MIN_KEY_COUNT = 32};
+
+   SymTable_T oSymTable;
+   char *pcKeys;
+   char *pcKey;
+   char acValue[] = "value";
+   int iKey;
+   int iBlock;
+   int iChar;
+   int iBindingCount;
+   int iLookup;
+   int iSuccessful;
+   unsigned int uParity;
+   unsigned int uBits;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the cost of lookups among keys chosen to collide\n");
+   printf("under the hash function from the assignment specification.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = (char*)malloc((size_t)KEY_COUNT * KEY_SIZE);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+
+   /* Key iKey uses the complement of the Thue-Morse string in the
+      iBlock-th block from the end if bit iBlock of iKey is set, so
+      that the first keys differ only near their ends, and comparing
+      any two of them reads most of both. */
+   for (iKey = 0; iKey < KEY_COUNT; iKey++)
+   {
+      pcKey = pcKeys + (size_t)iKey * KEY_SIZE;
+      for (iBlock = 0; iBlock < BLOCK_COUNT; iBlock++)
+         for (iChar = 0; iChar < BLOCK_LENGTH; iChar++)
+         {
+            uParity = (unsigned int)(iKey >> iBlock) & 1;
+            for (uBits = (unsigned int)iChar; uBits != 0; uBits >>= 1)
+               uParity ^= uBits & 1;
+            pcKey[(BLOCK_COUNT - 1 - iBlock) * BLOCK_LENGTH + iChar] =
+               (char)('a' + uParity);
+         }
+      pcKey[KEY_SIZE - 1] = '\0';
+   }
+
+   for (iBindingCount = MIN_KEY_COUNT; iBindingCount <= KEY_COUNT;
+      iBindingCount *= 2)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         break;
+
+      for (iKey = 0; iKey < iBindingCount; iKey++)
+      {
+         iSuccessful = SymTable_put(oSymTable,
+            pcKeys + (size_t)iKey * KEY_SIZE, acValue);
+         ASSURE(iSuccessful);
+      }
+
+      iInitialClock = clock();
+      for (iLookup = 0; iLookup < LOOKUPS_PER_COUNT; iLookup++)
+      {
+         iKey = iLookup % iBindingCount;
+         ASSURE(SymTable_get(oSymTable,
+            pcKeys + (size_t)iKey * KEY_SIZE) == acValue);
+      }
+      iFinalClock = clock();
+
+      printf("CPU time per lookup (%d colliding bindings):  "
+         "%f microseconds\n", iBindingCount,
+         ((double)(iFinalClock - iInitialClock)) * 1e6 /
+         CLOCKS_PER_SEC / LOOKUPS_PER_COUNT);
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+   }
+
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to be large, that is, to
    contain iBindingCount bindings. Write the time consumed to stdout. */
 
@@ -917,6 +1457,547 @@ static void testLargeTable(int iBindingCount)
 
 /*--------------------------------------------------------------------*/
 
+#ifndef S_SPLINT_S
+/* Build a SymTable object that contains iBindingCount bindings whose
+   keys share long prefixes, as qualified names do, and write the
+   memory that the process acquired per binding to stdout. The
+   memory is the growth of the process's peak resident set, so this
+   test must run before any test that uses more memory, and it counts
+   the allocator's overhead along with the SymTable's. */
+
+static void testMemoryPerBinding(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 40};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acValue[] = "value";
+   struct rusage sInitialUsage;
+   struct rusage sFinalUsage;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the memory used by a potentially large SymTable\n");
+   printf("object.\n");
+   printf("No output except memory used should appear here:\n");
+   fflush(stdout);
+
+   getrusage(RUSAGE_SELF, &sInitialUsage);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "symtable.module%04d.function%04d", i / 1000,
+         i % 1000);
+      iSuccessful = SymTable_put(oSymTable, acKey, acValue);
+      ASSURE(iSuccessful);
+   }
+
+   getrusage(RUSAGE_SELF, &sFinalUsage);
+
+   /* ru_maxrss is in kilobytes. */
+   if (iBindingCount > 0)
+      printf("Memory per binding (%d bindings):  %.1f bytes\n",
+         iBindingCount,
+         (double)(sFinalUsage.ru_maxrss - sInitialUsage.ru_maxrss)
+            * 1024.0 / iBindingCount);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Build a SymTable object that contains iBindingCount bindings, and
+   then free it while it still contains them. Write the time consumed
+   by each of the two phases to stdout. */
+
+static void testBuildAndFree(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acValue[] = "value";
+   int i;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iBuiltClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the cost of building and freeing a potentially\n");
+   printf("large SymTable object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iInitialClock = clock();
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acValue);
+      ASSURE(iSuccessful);
+   }
+
+   iBuiltClock = clock();
+
+   /* Free oSymTable with all of its bindings still in place. */
+   SymTable_free(oSymTable);
+
+   iFinalClock = clock();
+   printf("CPU time to build (%d bindings):  %f seconds\n",
+      iBindingCount,
+      ((double)(iBuiltClock - iInitialClock)) / CLOCKS_PER_SEC);
+   printf("CPU time to free (%d bindings):  %f seconds\n",
+      iBindingCount,
+      ((double)(iFinalClock - iBuiltClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_putBatch, and compare the CPU time it consumes to put
+   iBindingCount bindings into a SymTable object with the CPU time
+   that as many calls of SymTable_put consume. Write both to
+   stdout. */
+
+static void testPutBatch(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char *pcKeys;
+   const char **apcKeys;
+   const void **apvValues;
+   int *aiResults;
+   char acValue[] = "value";
+   const char *apcSmallKeys[] = {"aaa", "bbb", "aaa", "ccc", "bbb"};
+   const void *apvSmallValues[] = {"1", "2", "3", "4", "5"};
+   int aiSmallResults[5];
+   int i;
+   int iSuccessful;
+   size_t uAdded;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing putting bindings in batches.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   /* A batch behaves as SymTable_put would, one key after another:
+      a key that repeats within the batch or is already present keeps
+      its first value. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "ccc", "0");
+   ASSURE(iSuccessful);
+   uAdded = SymTable_putBatch(oSymTable, apcSmallKeys, apvSmallValues,
+      5, aiSmallResults);
+   ASSURE(uAdded == 2);
+   ASSURE(aiSmallResults[0] == 1);
+   ASSURE(aiSmallResults[1] == 1);
+   ASSURE(aiSmallResults[2] == 0);
+   ASSURE(aiSmallResults[3] == 0);
+   ASSURE(aiSmallResults[4] == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "aaa"), "1") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "bbb"), "2") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oSymTable, "ccc"), "0") == 0);
+
+   /* An empty batch changes nothing, and the results may be
+      ignored. */
+   ASSURE(SymTable_putBatch(oSymTable, apcSmallKeys, apvSmallValues,
+      0, aiSmallResults) == 0);
+   ASSURE(SymTable_putBatch(oSymTable, apcSmallKeys, apvSmallValues,
+      5, NULL) == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   SymTable_free(oSymTable);
+
+   if (iBindingCount == 0)
+      return;
+
+   pcKeys = (char*)malloc((size_t)iBindingCount * MAX_KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   apcKeys = (const char**)malloc((size_t)iBindingCount *
+      sizeof(const char*));
+   ASSURE(apcKeys != NULL);
+   apvValues = (const void**)malloc((size_t)iBindingCount *
+      sizeof(const void*));
+   ASSURE(apvValues != NULL);
+   aiResults = (int*)malloc((size_t)iBindingCount * sizeof(int));
+   ASSURE(aiResults != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(&pcKeys[i * MAX_KEY_LENGTH], "%d", i);
+      apcKeys[i] = &pcKeys[i * MAX_KEY_LENGTH];
+      apvValues[i] = acValue;
+   }
+
+   iInitialClock = clock();
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], apvValues[i]);
+      ASSURE(iSuccessful);
+   }
+   iFinalClock = clock();
+   printf("CPU time (%d bindings, SymTable_put):  %f seconds\n",
+      iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   SymTable_free(oSymTable);
+
+   iInitialClock = clock();
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   uAdded = SymTable_putBatch(oSymTable, apcKeys, apvValues,
+      (size_t)iBindingCount, aiResults);
+   iFinalClock = clock();
+   printf("CPU time (%d bindings, SymTable_putBatch):  %f seconds\n",
+      iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+
+   ASSURE(uAdded == (size_t)iBindingCount);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      ASSURE(aiResults[i] == 1);
+      ASSURE(SymTable_get(oSymTable, apcKeys[i]) == acValue);
+   }
+
+   /* Putting the same batch again adds nothing. */
+   uAdded = SymTable_putBatch(oSymTable, apcKeys, apvValues,
+      (size_t)iBindingCount, aiResults);
+   ASSURE(uAdded == 0);
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(aiResults[i] == 0);
+   SymTable_free(oSymTable);
+
+   free(aiResults);
+   free(apvValues);
+   free(apcKeys);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test SymTable_getBatch on a SymTable object that contains
+   iBindingCount bindings, looking up every key that is present and as
+   many that are not, in an order unrelated to the order of insertion.
+   Compare the CPU time it consumes with the CPU time that as many
+   calls of SymTable_get consume, and write both to stdout. */
+
+static void testGetBatch(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   char *pcKeys;
+   const char **apcKeys;
+   void **apvOut;
+   char acValue[] = "value";
+   const char *apcSmallKeys[] = {"aaa", "bbb", "ccc", "aaa"};
+   void *apvSmallOut[4];
+   const char *pcTemp;
+   int iKeyCount;
+   int i;
+   int j;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing getting values in batches.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   /* A batch finds what SymTable_get would find, including a NULL
+      value and a key that repeats within the batch. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "aaa", acValue);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "bbb", NULL);
+   ASSURE(iSuccessful);
+   apvSmallOut[2] = acValue;
+   SymTable_getBatch(oSymTable, apcSmallKeys, 4, apvSmallOut);
+   ASSURE(apvSmallOut[0] == acValue);
+   ASSURE(apvSmallOut[1] == NULL);
+   ASSURE(apvSmallOut[2] == NULL);
+   ASSURE(apvSmallOut[3] == acValue);
+   SymTable_getBatch(oSymTable, apcSmallKeys, 0, apvSmallOut);
+   SymTable_free(oSymTable);
+
+   if (iBindingCount == 0)
+      return;
+
+   /* Key i is "i" for the present keys and "-i" for the others. */
+   iKeyCount = 2 * iBindingCount;
+   pcKeys = (char*)malloc((size_t)iKeyCount * MAX_KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   apcKeys = (const char**)malloc((size_t)iKeyCount *
+      sizeof(const char*));
+   ASSURE(apcKeys != NULL);
+   apvOut = (void**)malloc((size_t)iKeyCount * sizeof(void*));
+   ASSURE(apvOut != NULL);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(&pcKeys[i * MAX_KEY_LENGTH], "%d", i);
+      sprintf(&pcKeys[(iBindingCount + i) * MAX_KEY_LENGTH], "-%d", i);
+      iSuccessful = SymTable_put(oSymTable,
+         &pcKeys[i * MAX_KEY_LENGTH], &pcKeys[i * MAX_KEY_LENGTH]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Look the keys up in a shuffled order. */
+   for (i = 0; i < iKeyCount; i++)
+      apcKeys[i] = &pcKeys[i * MAX_KEY_LENGTH];
+   srand(1);
+   for (i = iKeyCount - 1; i > 0; i--)
+   {
+      j = rand() % (i + 1);
+      pcTemp = apcKeys[i];
+      apcKeys[i] = apcKeys[j];
+      apcKeys[j] = pcTemp;
+   }
+
+   iInitialClock = clock();
+   for (i = 0; i < iKeyCount; i++)
+      apvOut[i] = SymTable_get(oSymTable, apcKeys[i]);
+   iFinalClock = clock();
+   printf("CPU time (%d lookups, SymTable_get):  %f seconds\n",
+      iKeyCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+
+   for (i = 0; i < iKeyCount; i++)
+      apvOut[i] = acValue;
+   iInitialClock = clock();
+   SymTable_getBatch(oSymTable, apcKeys, (size_t)iKeyCount, apvOut);
+   iFinalClock = clock();
+   printf("CPU time (%d lookups, SymTable_getBatch):  %f seconds\n",
+      iKeyCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+
+   /* The value of each present key is the address of the key. */
+   for (i = 0; i < iKeyCount; i++)
+   {
+      if (apcKeys[i][0] == '-')
+         ASSURE(apvOut[i] == NULL);
+      else
+         ASSURE(apvOut[i] == apcKeys[i]);
+   }
+
+   SymTable_free(oSymTable);
+   free(apvOut);
+   free(apcKeys);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a SymTable object created by
+   SymTable_newWithCapacity, into one created by SymTable_new, and into
+   one that reserves room for them halfway through. Make sure that
+   each SymTable object contains the bindings, and write the CPU time
+   consumed by each to stdout. */
+
+static void testCapacity(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 12};
+   enum {TABLE_COUNT = 3};
+
+   SymTable_T aoSymTable[TABLE_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   char acValue[] = "value";
+   const char *apcHow[TABLE_COUNT] =
+      {"SymTable_newWithCapacity", "SymTable_new",
+       "SymTable_reserve halfway"};
+   int i;
+   int iTable;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTable objects sized in advance.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   /* Reserving no more room than a SymTable object has succeeds. */
+   aoSymTable[0] = SymTable_newWithCapacity(0);
+   ASSURE(aoSymTable[0] != NULL);
+   ASSURE(SymTable_reserve(aoSymTable[0], 0));
+   iSuccessful = SymTable_put(aoSymTable[0], "xxx", acValue);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_reserve(aoSymTable[0], 1));
+   ASSURE(SymTable_get(aoSymTable[0], "xxx") == acValue);
+   SymTable_free(aoSymTable[0]);
+
+   for (iTable = 0; iTable < TABLE_COUNT; iTable++)
+   {
+      iInitialClock = clock();
+
+      if (iTable == 0)
+         aoSymTable[iTable] =
+            SymTable_newWithCapacity((size_t)iBindingCount);
+      else
+         aoSymTable[iTable] = SymTable_new();
+      ASSURE(aoSymTable[iTable] != NULL);
+
+      for (i = 0; i < iBindingCount; i++)
+      {
+         if (iTable == 2 && i == iBindingCount / 2)
+            ASSURE(SymTable_reserve(aoSymTable[iTable],
+               (size_t)iBindingCount));
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(aoSymTable[iTable], acKey, acValue);
+         ASSURE(iSuccessful);
+      }
+
+      iFinalClock = clock();
+      printf("CPU time (%d bindings, %s):  %f seconds\n",
+         iBindingCount, apcHow[iTable],
+         ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+      fflush(stdout);
+   }
+
+   for (iTable = 0; iTable < TABLE_COUNT; iTable++)
+   {
+      ASSURE(SymTable_getLength(aoSymTable[iTable]) ==
+         (size_t)iBindingCount);
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_get(aoSymTable[iTable], acKey) == acValue);
+      }
+      SymTable_free(aoSymTable[iTable]);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a SymTable object, remove all but
+   one in every hundred of them, and then put them all back, calling
+   SymTable_shrinkToFit along the way. Make sure that exactly the
+   expected bindings are present after each step, however the
+   implementation gives back memory. Write the CPU time consumed to
+   stdout. */
+
+static void testShrinkToFit(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 12};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acValue[] = "value";
+   int i;
+   int iSuccessful;
+   int iCount;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object that shrinks.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iInitialClock = clock();
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Shrinking an empty table leaves it usable. */
+   SymTable_shrinkToFit(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acValue);
+      ASSURE(iSuccessful);
+   }
+
+   /* Remove all but every hundredth binding. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      if (i % 100 == 0)
+         continue;
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == acValue);
+   }
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)((iBindingCount + 99) / 100));
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i % 100 == 0));
+   }
+
+   SymTable_shrinkToFit(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)((iBindingCount + 99) / 100));
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i % 100 == 0));
+   }
+   iCount = 0;
+   SymTable_map(oSymTable, countBinding, &iCount);
+   ASSURE(iCount == (iBindingCount + 99) / 100);
+
+   /* Put the removed bindings back, into the memory given up. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acValue);
+      ASSURE(iSuccessful == (i % 100 != 0));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)iBindingCount);
+
+   /* Shrinking a table that needs all of its memory changes nothing
+      visible. */
+   SymTable_shrinkToFit(oSymTable);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == acValue);
+   }
+
+   /* Empty the table, shrink it, and use it again. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == acValue);
+   }
+   SymTable_shrinkToFit(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   iSuccessful = SymTable_put(oSymTable, "xxx", acValue);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "xxx") == acValue);
+
+   SymTable_free(oSymTable);
+
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the SymTable ADT.  Write the output of the tests to stdout.
    As always, argc is the command-line argument count, argv contains
    the command-line arguments, and argv[0] is the name of the
@@ -954,13 +2035,27 @@ int main(int argc, char *argv[])
    testKeyOwnership();
    testRemove();
    testMap();
+   testFindOrInsert();
+   testHashedKeys();
+   testBinaryKeys();
    testEmptyTable();
    testEmptyKey();
    testNullValue();
    testLongKey();
    testTableOfTables();
    testCollisions();
+   testSharedHash();
+#ifndef S_SPLINT_S
+   testMemoryPerBinding(iBindingCount);
+#endif
+   testCollidingKeys();
    testLargeTable(iBindingCount);
+   testBuildAndFree(iBindingCount);
+   testCapacity(iBindingCount);
+   testPutBatch(iBindingCount);
+   testGetBatch(iBindingCount);
+   testShrinkToFit(iBindingCount);
+   testHashSpeed();
 
    printf("------------------------------------------------------\n");
    printf("End of %s.\n", argv[0]);
@@ -0,0 +1,579 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableiter.c                                                 */
+/* Author: David Wang                                                 */
+/*--------------------------------------------------------------------*/
+
+#include "symtableiter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Increment the int pointed to by pvExtra. pcKey and pvValue are
+   unused. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   (void)pvValue;
+   (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to oSymTable a binding for each of the keys "0" through
+   "iBindingCount - 1", whose value is the address of the element of
+   aiVisits with the same index. */
+
+static void addCountedBindings(SymTable_T oSymTable, int aiVisits[],
+   int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 16};
+
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iSuccessful;
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      aiVisits[i] = 0;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the basic iterator functions. */
+
+static void testBasics(void)
+{
+   enum {BINDING_COUNT = 5};
+
+   SymTable_T oSymTable;
+   SymTable_Iter_T oIter;
+   int aiVisits[BINDING_COUNT];
+   const char *pcKey;
+   void *pvValue;
+   int i;
+   int iCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the basic iterator functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* An empty table has nothing to visit, however often asked. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   SymTable_iterEnd(oIter);
+
+   addCountedBindings(oSymTable, aiVisits, BINDING_COUNT);
+
+   /* Each binding is visited once, with its own key and value. */
+   iCount = 0;
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      ASSURE(pvValue == SymTable_get(oSymTable, pcKey));
+      ASSURE(pvValue == &aiVisits[atoi(pcKey)]);
+      (*(int*)pvValue)++;
+      iCount++;
+   }
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   SymTable_iterEnd(oIter);
+   ASSURE(iCount == BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(aiVisits[i] == 1);
+
+   /* An iterator may be ended before its last binding. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(SymTable_iterNext(oIter, &pcKey, &pvValue));
+   SymTable_iterEnd(oIter);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test removing bindings while an iterator is in use. */
+
+static void testRemove(void)
+{
+   enum {BINDING_COUNT = 20};
+
+   SymTable_T oSymTable;
+   SymTable_Iter_T oIter;
+   int aiVisits[BINDING_COUNT];
+   char acKey[16];
+   const char *pcKey;
+   void *pvValue;
+   int i;
+   int iCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing removal during iteration.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   addCountedBindings(oSymTable, aiVisits, BINDING_COUNT);
+
+   /* Removing each binding just visited leaves the rest to visit. */
+   iCount = 0;
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      (*(int*)pvValue)++;
+      iCount++;
+      ASSURE(SymTable_remove(oSymTable, pcKey) == pvValue);
+   }
+   SymTable_iterEnd(oIter);
+   ASSURE(iCount == BINDING_COUNT);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE(aiVisits[i] == 1);
+
+   /* Bindings removed before they are reached are not visited. */
+   addCountedBindings(oSymTable, aiVisits, BINDING_COUNT);
+   iCount = 0;
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      iCount++;
+      if (iCount == 1)
+         for (i = 0; i < BINDING_COUNT; i++)
+            if (pvValue != &aiVisits[i])
+            {
+               sprintf(acKey, "%d", i);
+               (void)SymTable_remove(oSymTable, acKey);
+            }
+   }
+   SymTable_iterEnd(oIter);
+   ASSURE(iCount == 1);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test two iterators of one SymTable object in use at once. */
+
+static void testTwoIterators(void)
+{
+   enum {BINDING_COUNT = 50};
+
+   SymTable_T oSymTable;
+   SymTable_Iter_T oIter1;
+   SymTable_Iter_T oIter2;
+   int aiVisits[BINDING_COUNT];
+   const char *pcKey1;
+   const char *pcKey2;
+   void *pvValue1;
+   void *pvValue2;
+   int iCount = 0;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing two iterators in use at once.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   addCountedBindings(oSymTable, aiVisits, BINDING_COUNT);
+
+   /* Two iterators in lockstep visit the same bindings, and the
+      second skips a binding that the first removes. */
+   oIter1 = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter1 != NULL);
+   oIter2 = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter2 != NULL);
+   while (SymTable_iterNext(oIter1, &pcKey1, &pvValue1))
+   {
+      if (iCount % 2 == 0)
+      {
+         ASSURE(SymTable_iterNext(oIter2, &pcKey2, &pvValue2));
+         ASSURE(pvValue1 == pvValue2);
+         ASSURE(strcmp(pcKey1, pcKey2) == 0);
+      }
+      else
+         (void)SymTable_remove(oSymTable, pcKey1);
+      iCount++;
+   }
+   ASSURE(! SymTable_iterNext(oIter2, &pcKey2, &pvValue2));
+   SymTable_iterEnd(oIter2);
+   SymTable_iterEnd(oIter1);
+   ASSURE(iCount == BINDING_COUNT);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that two SymTable objects built by the same additions and
+   removals are traversed in the same order. */
+
+static void testDeterministicOrder(void)
+{
+   enum {BINDING_COUNT = 1000};
+
+   SymTable_T oSymTable1;
+   SymTable_T oSymTable2;
+   SymTable_Iter_T oIter1;
+   SymTable_Iter_T oIter2;
+   int aiVisits[BINDING_COUNT];
+   char acKey[16];
+   const char *pcKey1;
+   const char *pcKey2;
+   void *pvValue1;
+   void *pvValue2;
+   int i;
+   int iCount = 0;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of traversal.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable1 = SymTable_new();
+   ASSURE(oSymTable1 != NULL);
+   oSymTable2 = SymTable_new();
+   ASSURE(oSymTable2 != NULL);
+   addCountedBindings(oSymTable1, aiVisits, BINDING_COUNT);
+   addCountedBindings(oSymTable2, aiVisits, BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i += 3)
+   {
+      sprintf(acKey, "%d", i);
+      (void)SymTable_remove(oSymTable1, acKey);
+      (void)SymTable_remove(oSymTable2, acKey);
+   }
+
+   oIter1 = SymTable_iterBegin(oSymTable1);
+   ASSURE(oIter1 != NULL);
+   oIter2 = SymTable_iterBegin(oSymTable2);
+   ASSURE(oIter2 != NULL);
+   while (SymTable_iterNext(oIter1, &pcKey1, &pvValue1))
+   {
+      ASSURE(SymTable_iterNext(oIter2, &pcKey2, &pvValue2));
+      ASSURE(strcmp(pcKey1, pcKey2) == 0);
+      ASSURE(pvValue1 == pvValue2);
+      iCount++;
+   }
+   ASSURE(! SymTable_iterNext(oIter2, &pcKey2, &pvValue2));
+   SymTable_iterEnd(oIter2);
+   SymTable_iterEnd(oIter1);
+   ASSURE(iCount == BINDING_COUNT - (BINDING_COUNT + 2) / 3);
+
+   SymTable_free(oSymTable2);
+   SymTable_free(oSymTable1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test iteration over a SymTable object containing iBindingCount
+   bindings while bindings are looked up, added, and removed, and
+   compare the CPU time consumed by iteration with that consumed by
+   SymTable_map(). */
+
+static void testLargeIteration(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 16};
+
+   SymTable_T oSymTable;
+   SymTable_Iter_T oIter;
+   int *aiVisits;
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcKey;
+   void *pvValue;
+   int i;
+   int iCount;
+   int iAdded;
+   int iIndex;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iIteratedClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing iteration over a potentially large SymTable\n");
+   printf("object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   aiVisits = (int*)calloc((size_t)iBindingCount + 1, sizeof(int));
+   ASSURE(aiVisits != NULL);
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   addCountedBindings(oSymTable, aiVisits, iBindingCount);
+
+   /* Remove every odd binding on reaching it, and add a new binding
+      for every binding visited. Every original binding must be
+      visited exactly once, and the added ones at most once. */
+   iCount = 0;
+   iAdded = 0;
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+      (*(int*)pvValue)++;
+      iCount++;
+      if (pcKey[0] == 'x')
+         continue;
+      iIndex = atoi(pcKey);
+      sprintf(acKey, "x%d", iIndex);
+      iSuccessful = SymTable_put(oSymTable, acKey,
+         &aiVisits[iBindingCount]);
+      ASSURE(iSuccessful);
+      iAdded++;
+      if (iIndex % 2 != 0)
+         ASSURE(SymTable_remove(oSymTable, pcKey) == pvValue);
+   }
+   SymTable_iterEnd(oIter);
+
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(aiVisits[i] == 1);
+   ASSURE(iCount >= iBindingCount);
+   ASSURE(iCount - iBindingCount == aiVisits[iBindingCount]);
+   ASSURE(iAdded == iBindingCount);
+   /* The even original bindings remain, with the added ones. */
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)((iBindingCount + 1) / 2 + iBindingCount));
+
+   /* Time a plain traversal both ways. */
+   iInitialClock = clock();
+   iCount = 0;
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+      iCount++;
+   SymTable_iterEnd(oIter);
+   iIteratedClock = clock();
+   i = 0;
+   SymTable_map(oSymTable, countBinding, &i);
+   iFinalClock = clock();
+   ASSURE(iCount == i);
+   ASSURE((size_t)iCount == SymTable_getLength(oSymTable));
+
+   SymTable_free(oSymTable);
+   free(aiVisits);
+
+   printf("CPU time to iterate (%d bindings):  %f seconds\n", iCount,
+      ((double)(iIteratedClock - iInitialClock)) / CLOCKS_PER_SEC);
+   printf("CPU time to map (%d bindings):  %f seconds\n", iCount,
+      ((double)(iFinalClock - iIteratedClock)) / CLOCKS_PER_SEC);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The bindings of testResizeWithTrees: REGULAR_COUNT keys with hash
+   codes of their own, then GROUP_COUNT groups of GROUP_SIZE keys that
+   share a hash code, enough to make a tree bin, and then as many
+   groups that share the hash code of one of the first GROUP_COUNT
+   keys. */
+
+enum {REGULAR_COUNT = 1000};
+enum {GROUP_COUNT = 64};
+enum {GROUP_SIZE = 10};
+enum {MIXED_COUNT = REGULAR_COUNT + 2 * GROUP_COUNT * GROUP_SIZE};
+
+/*--------------------------------------------------------------------*/
+
+/* Store in acKey the key of the binding iIndex of testResizeWithTrees,
+   and return its hash code. */
+
+static SymTable_Hash_T mixedKey(int iIndex, char acKey[])
+{
+   char acHashKey[16];
+   int iGroup;
+
+   if (iIndex < REGULAR_COUNT)
+   {
+      sprintf(acKey, "r%d", iIndex);
+      return SymTable_hashKey(acKey);
+   }
+   iIndex -= REGULAR_COUNT;
+   iGroup = iIndex / GROUP_SIZE;
+   if (iGroup < GROUP_COUNT)
+   {
+      sprintf(acKey, "t%d-%d", iGroup, iIndex % GROUP_SIZE);
+      sprintf(acHashKey, "t%d", iGroup);
+   }
+   else
+   {
+      iGroup -= GROUP_COUNT;
+      sprintf(acKey, "a%d-%d", iGroup, iIndex % GROUP_SIZE);
+      sprintf(acHashKey, "r%d", iGroup);
+   }
+   return SymTable_hashKey(acHashKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Check that oSymTable holds exactly the bindings of
+   testResizeWithTrees, with the elements of aiValues as values, and
+   is traversed in the same order as oReference. */
+
+static void checkMixedBindings(SymTable_T oSymTable,
+   SymTable_T oReference, int aiValues[])
+{
+   SymTable_Iter_T oIter1;
+   SymTable_Iter_T oIter2;
+   char acKey[16];
+   const char *pcKey1;
+   const char *pcKey2;
+   void *pvValue1;
+   void *pvValue2;
+   int i;
+
+   ASSURE(SymTable_getLength(oSymTable) == MIXED_COUNT);
+   for (i = 0; i < MIXED_COUNT; i++)
+      ASSURE(SymTable_getHashed(oSymTable, acKey, mixedKey(i, acKey))
+         == &aiValues[i]);
+
+   oIter1 = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter1 != NULL);
+   oIter2 = SymTable_iterBegin(oReference);
+   ASSURE(oIter2 != NULL);
+   while (SymTable_iterNext(oIter1, &pcKey1, &pvValue1))
+   {
+      ASSURE(SymTable_iterNext(oIter2, &pcKey2, &pvValue2));
+      ASSURE(strcmp(pcKey1, pcKey2) == 0);
+      ASSURE(pvValue1 == pvValue2);
+   }
+   ASSURE(! SymTable_iterNext(oIter2, &pcKey2, &pvValue2));
+   SymTable_iterEnd(oIter2);
+   SymTable_iterEnd(oIter1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a resize from RESERVED_BUCKETS buckets, enough that the
+   hash implementation finishes it on several threads, loses no
+   binding and keeps the order of traversal, when it is finished by
+   SymTable_reserve or SymTable_shrinkToFit halfway through. Tree bins
+   are made both before the resize starts and during it, the latter
+   in the buckets that some bindings still in the old array are bound
+   for. */
+
+static void testResizeWithTrees(void)
+{
+   enum {RESERVED_BUCKETS = 262144};
+
+   SymTable_T oSymTable;
+   SymTable_T oReference;
+   int *aiValues;
+   char acKey[16];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing resizes of a SymTable with tree bins.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   aiValues = (int*)calloc(MIXED_COUNT, sizeof(int));
+   ASSURE(aiValues != NULL);
+   oSymTable = SymTable_newWithCapacity(RESERVED_BUCKETS);
+   ASSURE(oSymTable != NULL);
+   oReference = SymTable_new();
+   ASSURE(oReference != NULL);
+
+   for (i = 0; i < MIXED_COUNT; i++)
+   {
+      /* start a resize that the remaining bindings leave unfinished */
+      if (i == REGULAR_COUNT + GROUP_COUNT * GROUP_SIZE)
+         ASSURE(SymTable_reserve(oSymTable, 2 * RESERVED_BUCKETS));
+      ASSURE(SymTable_putHashed(oSymTable, acKey, mixedKey(i, acKey),
+         &aiValues[i]));
+      ASSURE(SymTable_putHashed(oReference, acKey, mixedKey(i, acKey),
+         &aiValues[i]));
+   }
+
+   /* finish that resize and start another */
+   ASSURE(SymTable_reserve(oSymTable, 4 * RESERVED_BUCKETS));
+   checkMixedBindings(oSymTable, oReference, aiValues);
+
+   /* finish the second resize, and shrink at once */
+   SymTable_shrinkToFit(oSymTable);
+   checkMixedBindings(oSymTable, oReference, aiValues);
+
+   SymTable_free(oReference);
+   SymTable_free(oSymTable);
+   free(aiValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the iterator functions of a SymTable implementation. The
+   command-line argument is the number of bindings for the large
+   test. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testBasics();
+   testRemove();
+   testTwoIterators();
+   testDeterministicOrder();
+   testLargeIteration(iBindingCount);
+   testResizeWithTrees();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
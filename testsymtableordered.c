@@ -0,0 +1,540 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableordered.c                                              */
+/* Author: David Wang                                                 */
+/*--------------------------------------------------------------------*/
+
+#include "symtableordered.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A KeyList collects the keys that a mapping function visits. */
+
+struct KeyList
+{
+   /* The keys visited so far, each followed by '|'. */
+   char acKeys[256];
+
+   /* The number of keys visited so far. */
+   int iCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Append pcKey and '|' to the KeyList pointed to by pvExtra. pvValue
+   is unused. */
+
+static void appendKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct KeyList *psKeyList;
+
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   (void)pvValue;
+   psKeyList = (struct KeyList*)pvExtra;
+   assert(strlen(psKeyList->acKeys) + strlen(pcKey) + 1
+      < sizeof(psKeyList->acKeys));
+   strcat(psKeyList->acKeys, pcKey);
+   strcat(psKeyList->acKeys, "|");
+   psKeyList->iCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store the keys that SymTable_mapRange() visits in oSymTable
+   between pcLo and pcHi in the KeyList *psKeyList. */
+
+static void listRange(SymTable_T oSymTable, const char *pcLo,
+   const char *pcHi, struct KeyList *psKeyList)
+{
+   assert(psKeyList != NULL);
+
+   psKeyList->acKeys[0] = '\0';
+   psKeyList->iCount = 0;
+   SymTable_mapRange(oSymTable, pcLo, pcHi, appendKey, psKeyList);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* An OrderCheck follows a traversal to make sure that it visits its
+   keys in ascending order. */
+
+struct OrderCheck
+{
+   /* The previous key visited, or NULL before the first. */
+   const char *pcPrevKey;
+
+   /* The number of keys visited so far. */
+   int iCount;
+
+   /* 1 (TRUE) while every key has been greater than the previous
+      one, 0 (FALSE) otherwise. */
+   int iAscending;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Note pcKey in the OrderCheck pointed to by pvExtra. pvValue is
+   unused. */
+
+static void checkOrder(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   struct OrderCheck *psCheck;
+
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   (void)pvValue;
+   psCheck = (struct OrderCheck*)pvExtra;
+   if (psCheck->pcPrevKey != NULL &&
+      strcmp(psCheck->pcPrevKey, pcKey) >= 0)
+      psCheck->iAscending = 0;
+   psCheck->pcPrevKey = pcKey;
+   psCheck->iCount++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_map() visits the bindings in ascending key
+   order. */
+
+static void testMapOrder(void)
+{
+   SymTable_T oSymTable;
+   struct KeyList sKeyList;
+   const char *apcKeys[] = {"b", "ab", "", "abc", "a", "B", "\x7f",
+      "aa"};
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of SymTable_map().\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < (int)(sizeof(apcKeys) / sizeof(apcKeys[0])); i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], NULL);
+      ASSURE(iSuccessful);
+   }
+
+   sKeyList.acKeys[0] = '\0';
+   sKeyList.iCount = 0;
+   SymTable_map(oSymTable, appendKey, &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "|B|a|aa|ab|abc|b|\x7f|") == 0);
+   ASSURE(sKeyList.iCount == 8);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_mapRange() function. */
+
+static void testMapRange(void)
+{
+   SymTable_T oSymTable;
+   struct KeyList sKeyList;
+   const char *apcKeys[] = {"Gehrig", "Jeter", "Mantle", "Maris",
+      "Ruth"};
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_mapRange() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   listRange(oSymTable, NULL, NULL, &sKeyList);
+   ASSURE(sKeyList.iCount == 0);
+
+   for (i = 4; i >= 0; i--)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], NULL);
+      ASSURE(iSuccessful);
+   }
+
+   /* Both ends are included. */
+   listRange(oSymTable, "Jeter", "Maris", &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "Jeter|Mantle|Maris|") == 0);
+
+   /* The ends need not be keys. */
+   listRange(oSymTable, "H", "Mb", &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "Jeter|Mantle|Maris|") == 0);
+
+   /* NULL leaves an end open. */
+   listRange(oSymTable, NULL, "Jeter", &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "Gehrig|Jeter|") == 0);
+   listRange(oSymTable, "Maris", NULL, &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "Maris|Ruth|") == 0);
+   listRange(oSymTable, NULL, NULL, &sKeyList);
+   ASSURE(sKeyList.iCount == 5);
+
+   /* An empty range visits nothing. */
+   listRange(oSymTable, "Maris", "Jeter", &sKeyList);
+   ASSURE(sKeyList.iCount == 0);
+   listRange(oSymTable, "K", "L", &sKeyList);
+   ASSURE(sKeyList.iCount == 0);
+   listRange(oSymTable, "S", NULL, &sKeyList);
+   ASSURE(sKeyList.iCount == 0);
+
+   /* A key that begins another orders before it. */
+   iSuccessful = SymTable_put(oSymTable, "Man", NULL);
+   ASSURE(iSuccessful);
+   listRange(oSymTable, "Ma", "Man", &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "Man|") == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_floor() and SymTable_ceiling() functions. */
+
+static void testFloorCeiling(void)
+{
+   SymTable_T oSymTable;
+   const char *pcKey;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_floor() and SymTable_ceiling()\n");
+   printf("functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   pcKey = SymTable_floor(oSymTable, "Jeter");
+   ASSURE(pcKey == NULL);
+   pcKey = SymTable_ceiling(oSymTable, "Jeter");
+   ASSURE(pcKey == NULL);
+
+   iSuccessful = SymTable_put(oSymTable, "Jeter", NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", NULL);
+   ASSURE(iSuccessful);
+
+   /* An exact match is its own floor and ceiling. */
+   pcKey = SymTable_floor(oSymTable, "Jeter");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "Jeter") == 0);
+   pcKey = SymTable_ceiling(oSymTable, "Jeter");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "Jeter") == 0);
+
+   pcKey = SymTable_floor(oSymTable, "Mantle");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "Jeter") == 0);
+   pcKey = SymTable_ceiling(oSymTable, "Mantle");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "Ruth") == 0);
+
+   pcKey = SymTable_floor(oSymTable, "Jet");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "Gehrig") == 0);
+   pcKey = SymTable_ceiling(oSymTable, "Jeterson");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "Ruth") == 0);
+
+   pcKey = SymTable_floor(oSymTable, "Aaron");
+   ASSURE(pcKey == NULL);
+   pcKey = SymTable_ceiling(oSymTable, "Aaron");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "Gehrig") == 0);
+   pcKey = SymTable_floor(oSymTable, "Young");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "Ruth") == 0);
+   pcKey = SymTable_ceiling(oSymTable, "Young");
+   ASSURE(pcKey == NULL);
+
+   /* The returned key is the table's own copy. */
+   pcKey = SymTable_floor(oSymTable, "Ruth");
+   ASSURE(pcKey == SymTable_ceiling(oSymTable, "Ruth"));
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_mapPrefix() function. */
+
+static void testMapPrefix(void)
+{
+   SymTable_T oSymTable;
+   struct KeyList sKeyList;
+   const char *apcKeys[] = {"module.beta", "module.alpha", "modulex",
+      "module.alpha.inner.long.name", "mod", "module.alphabet",
+      "other"};
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_mapPrefix() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   sKeyList.acKeys[0] = '\0';
+   sKeyList.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "", appendKey, &sKeyList);
+   ASSURE(sKeyList.iCount == 0);
+
+   for (i = 0; i < (int)(sizeof(apcKeys) / sizeof(apcKeys[0])); i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, apcKeys[i], NULL);
+      ASSURE(iSuccessful);
+   }
+
+   /* A key that is the prefix itself matches, and the matches are
+      visited in ascending order. */
+   SymTable_mapPrefix(oSymTable, "module.alpha", appendKey, &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "module.alpha|"
+      "module.alpha.inner.long.name|module.alphabet|") == 0);
+
+   sKeyList.acKeys[0] = '\0';
+   sKeyList.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "module.", appendKey, &sKeyList);
+   ASSURE(sKeyList.iCount == 4);
+
+   sKeyList.acKeys[0] = '\0';
+   sKeyList.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "mod", appendKey, &sKeyList);
+   ASSURE(sKeyList.iCount == 6);
+
+   sKeyList.acKeys[0] = '\0';
+   sKeyList.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "", appendKey, &sKeyList);
+   ASSURE(sKeyList.iCount == 7);
+
+   /* A prefix may end inside, or differ late in, a long shared part
+      of the keys. */
+   sKeyList.acKeys[0] = '\0';
+   sKeyList.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "module.alpha.inner.lo", appendKey,
+      &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "module.alpha.inner.long.name|") == 0);
+
+   sKeyList.acKeys[0] = '\0';
+   sKeyList.iCount = 0;
+   SymTable_mapPrefix(oSymTable, "module.alpha.inner.lonX", appendKey,
+      &sKeyList);
+   SymTable_mapPrefix(oSymTable, "module.alpha.inner.long.name.x",
+      appendKey, &sKeyList);
+   SymTable_mapPrefix(oSymTable, "module.gamma", appendKey, &sKeyList);
+   SymTable_mapPrefix(oSymTable, "n", appendKey, &sKeyList);
+   SymTable_mapPrefix(oSymTable, "zzz", appendKey, &sKeyList);
+   ASSURE(sKeyList.iCount == 0);
+
+   /* Removed keys no longer match. */
+   (void)SymTable_remove(oSymTable, "module.alpha");
+   (void)SymTable_remove(oSymTable, "module.alphabet");
+   SymTable_mapPrefix(oSymTable, "module.alpha", appendKey, &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "module.alpha.inner.long.name|") == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the order of keys that contain '\0' bytes. */
+
+static void testBinaryKeyOrder(void)
+{
+   SymTable_T oSymTable;
+   struct KeyList sKeyList;
+   const char *pcKey;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the order of keys that contain '\\0' bytes.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_putN(oSymTable, "a\0b", 3, NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, "a\0", 2, NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "a", NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "b", NULL);
+   ASSURE(iSuccessful);
+
+   /* "a" < "a\0" < "a\0b" < "b", so only "a" is at most "a". */
+   listRange(oSymTable, "a", "a", &sKeyList);
+   ASSURE(sKeyList.iCount == 1);
+   listRange(oSymTable, "a", "b", &sKeyList);
+   ASSURE(strcmp(sKeyList.acKeys, "a|a|a|b|") == 0);
+
+   pcKey = SymTable_ceiling(oSymTable, "a");
+   ASSURE(pcKey != NULL && strcmp(pcKey, "a") == 0);
+   pcKey = SymTable_floor(oSymTable, "a\x01");
+   ASSURE(pcKey != NULL && memcmp(pcKey, "a\0b", 4) == 0);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ordered functions on a SymTable object containing
+   iBindingCount bindings added in scrambled order, and report the
+   CPU time consumed. */
+
+static void testLargeOrdered(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 16};
+
+   SymTable_T oSymTable;
+   struct OrderCheck sCheck;
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcKey;
+   int i;
+   int iKey;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a potentially large ordered SymTable object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iInitialClock = clock();
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Add the keys 1 through iBindingCount, zero-padded so that their
+      order is numeric order. 1000003 is a prime greater than any
+      binding count, so multiplying by it modulo iBindingCount
+      visits every key once, in scrambled order. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iKey = (int)((long long)i * 1000003 % iBindingCount) + 1;
+      sprintf(acKey, "%08d", iKey);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+
+   sCheck.pcPrevKey = NULL;
+   sCheck.iCount = 0;
+   sCheck.iAscending = 1;
+   SymTable_map(oSymTable, checkOrder, &sCheck);
+   ASSURE(sCheck.iAscending);
+   ASSURE(sCheck.iCount == iBindingCount);
+
+   /* Remove every odd key, then check that the floor and ceiling of
+      each removed key are its surviving neighbours. */
+   for (i = 1; i <= iBindingCount; i += 2)
+   {
+      sprintf(acKey, "%08d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+      (void)SymTable_remove(oSymTable, acKey);
+   }
+   for (i = 1; i <= iBindingCount; i += 2)
+   {
+      sprintf(acKey, "%08d", i);
+      pcKey = SymTable_floor(oSymTable, acKey);
+      if (i == 1)
+         ASSURE(pcKey == NULL);
+      else
+         ASSURE(pcKey != NULL && atoi(pcKey) == i - 1);
+      pcKey = SymTable_ceiling(oSymTable, acKey);
+      if (i == iBindingCount)
+         ASSURE(pcKey == NULL);
+      else
+         ASSURE(pcKey != NULL && atoi(pcKey) == i + 1);
+   }
+
+   sCheck.pcPrevKey = NULL;
+   sCheck.iCount = 0;
+   sCheck.iAscending = 1;
+   SymTable_map(oSymTable, checkOrder, &sCheck);
+   ASSURE(sCheck.iAscending);
+   ASSURE(sCheck.iCount == iBindingCount / 2);
+
+   /* The surviving keys 2, 4, 6 and 8 are the ones that begin with
+      "0000000". */
+   sCheck.pcPrevKey = NULL;
+   sCheck.iCount = 0;
+   sCheck.iAscending = 1;
+   SymTable_mapPrefix(oSymTable, "0000000", checkOrder, &sCheck);
+   ASSURE(sCheck.iAscending);
+   ASSURE(sCheck.iCount == (iBindingCount < 9 ? iBindingCount : 9) / 2);
+   ASSURE(SymTable_getLength(oSymTable) == (size_t)(iBindingCount / 2));
+
+   SymTable_free(oSymTable);
+
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ordered functions of a SymTable implementation. The
+   command-line argument is the number of bindings for the large
+   test; it must be less than 100000000, so that every key of that
+   test has 8 digits. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0 || iBindingCount >= 100000000)
+   {
+      fprintf(stderr, "bindingcount must be between 0 and 99999999\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testMapOrder();
+   testMapRange();
+   testFloorCeiling();
+   testMapPrefix();
+   testBinaryKeyOrder();
+   testLargeOrdered(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,317 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableparallel.c                                             */
+/* Author: David Wang                                                 */
+/*--------------------------------------------------------------------*/
+
+/* clock_gettime is POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtableparallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* the length of the longest key the tests make, with its '\0' */
+enum {MAX_KEY_LENGTH = 16};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Increment the int pointed to by pvValue, which no other binding
+   shares. pcKey and pvExtra are unused. */
+
+static void countVisit(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+
+   (void)pvExtra;
+   (*(int*)pvValue)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in the unsigned long pointed to by pvValue, which no other
+   binding shares, a checksum of pcKey computed *(int*)pvExtra times
+   over, standing in for a costly pure function of the binding. */
+
+static void checksumKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   unsigned long ulSum = 0;
+   int iRound;
+   const char *pc;
+
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   for (iRound = 0; iRound < *(int*)pvExtra; iRound++)
+      for (pc = pcKey; *pc != '\0'; pc++)
+         ulSum = ulSum * 31 + (unsigned char)*pc + (unsigned long)iRound;
+   *(unsigned long*)pvValue = ulSum;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add to oSymTable a binding for each of the keys "0" through
+   "iBindingCount - 1", whose value is the address of the element of
+   aiVisits with the same index. */
+
+static void addCountedBindings(SymTable_T oSymTable, int aiVisits[],
+   int iBindingCount)
+{
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iSuccessful;
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      aiVisits[i] = 0;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiVisits[i]);
+      ASSURE(iSuccessful);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 (TRUE) if each of the first iBindingCount elements of
+   aiVisits is iExpected, and set each to 0. Otherwise return
+   0 (FALSE). */
+
+static int checkVisits(int aiVisits[], int iBindingCount, int iExpected)
+{
+   int i;
+   int iSuccessful = 1;
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      if (aiVisits[i] != iExpected)
+         iSuccessful = 0;
+      aiVisits[i] = 0;
+   }
+   return iSuccessful;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that SymTable_mapParallel visits each binding exactly once,
+   whatever the number of threads, in tables small and large, and
+   after removals. */
+
+static void testVisitsOnce(int iBindingCount)
+{
+   static const size_t auThreadCounts[] = {0, 1, 2, 3, 8, 64};
+   enum {THREAD_COUNT_COUNT =
+      sizeof(auThreadCounts) / sizeof(auThreadCounts[0])};
+
+   SymTable_T oSymTable;
+   int *aiVisits;
+   char acKey[MAX_KEY_LENGTH];
+   size_t i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing that every binding is visited once.\n");
+   fflush(stdout);
+
+   aiVisits = (int*)calloc((size_t)iBindingCount + 1, sizeof(int));
+   ASSURE(aiVisits != NULL);
+
+   /* an empty table */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < THREAD_COUNT_COUNT; i++)
+      SymTable_mapParallel(oSymTable, countVisit, NULL,
+         auThreadCounts[i]);
+
+   /* a table that grows, checked along the way */
+   for (j = 0; j < iBindingCount; j++)
+   {
+      aiVisits[j] = 0;
+      sprintf(acKey, "%d", j);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiVisits[j]));
+      if (j % 997 == 0)
+      {
+         SymTable_mapParallel(oSymTable, countVisit, NULL,
+            auThreadCounts[(size_t)j % THREAD_COUNT_COUNT]);
+         ASSURE(checkVisits(aiVisits, j + 1, 1));
+      }
+   }
+
+   for (i = 0; i < THREAD_COUNT_COUNT; i++)
+   {
+      SymTable_mapParallel(oSymTable, countVisit, NULL,
+         auThreadCounts[i]);
+      ASSURE(checkVisits(aiVisits, iBindingCount, 1));
+   }
+
+   /* remove every other binding */
+   for (j = 0; j < iBindingCount; j += 2)
+   {
+      sprintf(acKey, "%d", j);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiVisits[j]);
+   }
+   for (i = 0; i < THREAD_COUNT_COUNT; i++)
+   {
+      SymTable_mapParallel(oSymTable, countVisit, NULL,
+         auThreadCounts[i]);
+      for (j = 0; j < iBindingCount; j++)
+      {
+         ASSURE(aiVisits[j] == j % 2);
+         aiVisits[j] = 0;
+      }
+   }
+
+   SymTable_free(oSymTable);
+
+   /* a table built in one go */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   addCountedBindings(oSymTable, aiVisits, iBindingCount);
+   SymTable_mapParallel(oSymTable, countVisit, NULL, 4);
+   ASSURE(checkVisits(aiVisits, iBindingCount, 1));
+   SymTable_free(oSymTable);
+
+   free(aiVisits);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the seconds from *psStart to *psEnd. */
+
+static double elapsed(const struct timespec *psStart,
+   const struct timespec *psEnd)
+{
+   return (double)(psEnd->tv_sec - psStart->tv_sec)
+      + (double)(psEnd->tv_nsec - psStart->tv_nsec) / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Report the wall time of SymTable_mapParallel with a costly pfApply
+   over iBindingCount bindings, for several thread counts, and the
+   speedup of each over one thread. Check that every thread count
+   computes the same results. */
+
+static void testParallelSpeed(int iBindingCount)
+{
+   static const size_t auThreadCounts[] = {1, 2, 4, 8};
+   enum {THREAD_COUNT_COUNT =
+      sizeof(auThreadCounts) / sizeof(auThreadCounts[0])};
+   enum {ROUND_COUNT = 50};
+
+   SymTable_T oSymTable;
+   unsigned long *aulSums;
+   unsigned long ulTotal;
+   unsigned long ulFirstTotal = 0;
+   char acKey[MAX_KEY_LENGTH];
+   int iRoundCount = ROUND_COUNT;
+   double dFirstTime = 0.0;
+   double dTime;
+   struct timespec sStart;
+   struct timespec sEnd;
+   size_t i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing parallel speed.\n");
+   fflush(stdout);
+
+   aulSums = (unsigned long*)calloc((size_t)iBindingCount + 1,
+      sizeof(unsigned long));
+   ASSURE(aulSums != NULL);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (j = 0; j < iBindingCount; j++)
+   {
+      sprintf(acKey, "%d", j);
+      ASSURE(SymTable_put(oSymTable, acKey, &aulSums[j]));
+   }
+
+   for (i = 0; i < THREAD_COUNT_COUNT; i++)
+   {
+      clock_gettime(CLOCK_MONOTONIC, &sStart);
+      SymTable_mapParallel(oSymTable, checksumKey, &iRoundCount,
+         auThreadCounts[i]);
+      clock_gettime(CLOCK_MONOTONIC, &sEnd);
+      dTime = elapsed(&sStart, &sEnd);
+
+      ulTotal = 0;
+      for (j = 0; j < iBindingCount; j++)
+      {
+         ulTotal += aulSums[j];
+         aulSums[j] = 0;
+      }
+      if (i == 0)
+      {
+         ulFirstTotal = ulTotal;
+         dFirstTime = dTime;
+      }
+      ASSURE(ulTotal == ulFirstTotal);
+
+      printf("Wall time to map (%d bindings, %d threads):  "
+         "%f seconds, speedup %.2f\n", iBindingCount,
+         (int)auThreadCounts[i], dTime,
+         dTime > 0.0 ? dFirstTime / dTime : 1.0);
+   }
+
+   SymTable_free(oSymTable);
+   free(aulSums);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the parallel traversal of a SymTable implementation. The
+   command-line argument is the number of bindings for the tests. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testVisitsOnce(iBindingCount);
+   testParallelSpeed(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
@@ -0,0 +1,603 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablestress.c                                               */
+/* Author: David Wang                                                 */
+/*--------------------------------------------------------------------*/
+
+/* pthreads are POSIX, not C99 */
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtableconcurrent.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* the number of threads that each test starts */
+enum {THREAD_COUNT = 8};
+
+/* the length of the longest key the tests make, with its '\0' */
+enum {MAX_KEY_LENGTH = 32};
+
+/*--------------------------------------------------------------------*/
+
+/* The work of one thread of a test. */
+
+struct Worker
+{
+   /* the thread doing the work */
+   pthread_t sThread;
+
+   /* the index of the worker among those of its test */
+   int iIndex;
+
+   /* the table that the workers of a test share */
+   SymTable_T oSymTable;
+
+   /* the number of keys that the worker works on */
+   int iCount;
+
+   /* the values of the worker's own keys */
+   int *aiValues;
+
+   /* the values of the keys that all the workers work on */
+   int *aiShared;
+
+   /* the number of keys that all the workers work on */
+   int iSharedCount;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Increment the int pointed to by pvExtra. pcKey and pvValue are
+   unused. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   (void)pvValue;
+   (*(int*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Start THREAD_COUNT threads running pfRun, each on its element of
+   asWorkers, and wait for all of them to finish. */
+
+static void runWorkers(struct Worker asWorkers[],
+   void *(*pfRun)(void *pvWorker))
+{
+   int i;
+   int iStatus;
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWorkers[i].iIndex = i;
+      iStatus = pthread_create(&asWorkers[i].sThread, NULL, pfRun,
+         &asWorkers[i]);
+      ASSURE(iStatus == 0);
+   }
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      iStatus = pthread_join(asWorkers[i].sThread, NULL);
+      ASSURE(iStatus == 0);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the keys of one worker, "w-i" for its index w and each i below
+   its count, with the addresses of its values as values, and check
+   each one at once. */
+
+static void *putOwnKeys(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   for (i = 0; i < psWorker->iCount; i++)
+   {
+      sprintf(acKey, "%d-%d", psWorker->iIndex, i);
+      ASSURE(SymTable_put(psWorker->oSymTable, acKey,
+         &psWorker->aiValues[i]));
+      ASSURE(SymTable_get(psWorker->oSymTable, acKey)
+         == &psWorker->aiValues[i]);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Create tables of the worker's own, one after another, while the
+   other workers do the same, each with one binding put by its key's
+   hash code from SymTable_hashKey, and check the binding in each. */
+
+static void *createOwnTables(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+
+   for (i = 0; i < psWorker->iCount; i++)
+   {
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      if (oSymTable == NULL)
+         continue;
+      sprintf(acKey, "%d-%d", psWorker->iIndex, i);
+      ASSURE(SymTable_putHashed(oSymTable, acKey,
+         SymTable_hashKey(acKey), &psWorker->aiValues[i]));
+      ASSURE(SymTable_get(oSymTable, acKey) == &psWorker->aiValues[i]);
+      SymTable_free(oSymTable);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Look up the keys of one worker, as put by putOwnKeys, a few times
+   over. */
+
+static void *getOwnKeys(void *pvWorker)
+{
+   enum {ROUND_COUNT = 4};
+
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   char acKey[MAX_KEY_LENGTH];
+   int iRound;
+   int i;
+
+   for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+      for (i = 0; i < psWorker->iCount; i++)
+      {
+         sprintf(acKey, "%d-%d", psWorker->iIndex, i);
+         ASSURE(SymTable_get(psWorker->oSymTable, acKey)
+            == &psWorker->aiValues[i]);
+      }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the seconds from *psStart to *psEnd. */
+
+static double elapsed(const struct timespec *psStart,
+   const struct timespec *psEnd)
+{
+   return (double)(psEnd->tv_sec - psStart->tv_sec)
+      + (double)(psEnd->tv_nsec - psStart->tv_nsec) / 1e9;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that several threads may create tables at once, the first
+   tables of the process among them. */
+
+static void testConcurrentCreation(void)
+{
+   enum {TABLE_COUNT = 64};
+
+   struct Worker asWorkers[THREAD_COUNT];
+   int aiValues[THREAD_COUNT * TABLE_COUNT];
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing threads creating tables.\n");
+   fflush(stdout);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWorkers[i].iCount = TABLE_COUNT;
+      asWorkers[i].aiValues = &aiValues[i * TABLE_COUNT];
+   }
+   runWorkers(asWorkers, createOwnTables);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that bindings added by several threads at once, growing the
+   table as they go, are all there afterwards. */
+
+static void testDisjointPuts(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   struct Worker asWorkers[THREAD_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   int *aiValues;
+   int iCount;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing threads adding disjoint keys.\n");
+   fflush(stdout);
+
+   iCount = iBindingCount / THREAD_COUNT;
+   aiValues = (int*)calloc((size_t)iCount * THREAD_COUNT + 1,
+      sizeof(int));
+   ASSURE(aiValues != NULL);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].iCount = iCount;
+      asWorkers[i].aiValues = &aiValues[i * iCount];
+   }
+   runWorkers(asWorkers, putOwnKeys);
+
+   ASSURE(SymTable_getLength(oSymTable)
+      == (size_t)iCount * THREAD_COUNT);
+   for (i = 0; i < THREAD_COUNT; i++)
+      for (j = 0; j < iCount; j++)
+      {
+         sprintf(acKey, "%d-%d", i, j);
+         ASSURE(SymTable_get(oSymTable, acKey)
+            == &aiValues[i * iCount + j]);
+      }
+
+   i = 0;
+   SymTable_map(oSymTable, countBinding, &i);
+   ASSURE(i == iCount * THREAD_COUNT);
+
+   SymTable_free(oSymTable);
+   free(aiValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Work through the keys of one worker, adding, replacing and removing
+   them, while also adding and removing the keys "s-i" shared by all
+   the workers. A shared key's value is always the address of its
+   element of aiShared. Of the worker's own keys, exactly those with
+   odd i remain afterwards, with the addresses of the values as
+   values. */
+
+static void *mixOwnAndSharedKeys(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   SymTable_T oSymTable = psWorker->oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acSharedKey[MAX_KEY_LENGTH];
+   void *pvValue;
+   int iShared;
+   int i;
+
+   for (i = 0; i < psWorker->iCount; i++)
+   {
+      sprintf(acKey, "%d-%d", psWorker->iIndex, i);
+      ASSURE(SymTable_put(oSymTable, acKey, &psWorker->iIndex));
+      ASSURE(! SymTable_put(oSymTable, acKey, &psWorker->aiValues[i]));
+      ASSURE(SymTable_replace(oSymTable, acKey, &psWorker->aiValues[i])
+         == &psWorker->iIndex);
+
+      /* the shared key is added, looked up or removed, in turn */
+      iShared = (i * 7 + psWorker->iIndex) % psWorker->iSharedCount;
+      sprintf(acSharedKey, "s-%d", iShared);
+      switch ((i + psWorker->iIndex) % 3)
+      {
+         case 0:
+            (void)SymTable_put(oSymTable, acSharedKey,
+               &psWorker->aiShared[iShared]);
+            break;
+         case 1:
+            pvValue = SymTable_get(oSymTable, acSharedKey);
+            ASSURE(pvValue == NULL
+               || pvValue == &psWorker->aiShared[iShared]);
+            break;
+         default:
+            pvValue = SymTable_remove(oSymTable, acSharedKey);
+            ASSURE(pvValue == NULL
+               || pvValue == &psWorker->aiShared[iShared]);
+            break;
+      }
+
+      /* each key with even i is removed once the next one is added */
+      if (i % 2 == 1)
+      {
+         sprintf(acKey, "%d-%d", psWorker->iIndex, i - 1);
+         ASSURE(SymTable_remove(oSymTable, acKey)
+            == &psWorker->aiValues[i - 1]);
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+      }
+   }
+   /* an odd count leaves the last key, whose i is even */
+   if (psWorker->iCount % 2 == 1)
+   {
+      sprintf(acKey, "%d-%d", psWorker->iIndex, psWorker->iCount - 1);
+      ASSURE(SymTable_remove(oSymTable, acKey)
+         == &psWorker->aiValues[psWorker->iCount - 1]);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that threads adding, replacing and removing bindings at once,
+   on keys of their own and on keys they share, leave the table in the
+   state that the calls of each thread imply. */
+
+static void testMixedOperations(int iBindingCount)
+{
+   enum {SHARED_COUNT = 64};
+
+   SymTable_T oSymTable;
+   struct Worker asWorkers[THREAD_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   int aiShared[SHARED_COUNT];
+   int *aiValues;
+   void *pvValue;
+   int iCount;
+   int iSharedPresent = 0;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing threads adding, replacing and removing keys.\n");
+   fflush(stdout);
+
+   iCount = iBindingCount / THREAD_COUNT;
+   aiValues = (int*)calloc((size_t)iCount * THREAD_COUNT + 1,
+      sizeof(int));
+   ASSURE(aiValues != NULL);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].iCount = iCount;
+      asWorkers[i].aiValues = &aiValues[i * iCount];
+      asWorkers[i].aiShared = aiShared;
+      asWorkers[i].iSharedCount = SHARED_COUNT;
+   }
+   runWorkers(asWorkers, mixOwnAndSharedKeys);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+      for (j = 0; j < iCount; j++)
+      {
+         sprintf(acKey, "%d-%d", i, j);
+         if (j % 2 == 1)
+            ASSURE(SymTable_get(oSymTable, acKey)
+               == &aiValues[i * iCount + j]);
+         else
+            ASSURE(! SymTable_contains(oSymTable, acKey));
+      }
+   for (i = 0; i < SHARED_COUNT; i++)
+   {
+      sprintf(acKey, "s-%d", i);
+      pvValue = SymTable_get(oSymTable, acKey);
+      ASSURE(pvValue == NULL || pvValue == &aiShared[i]);
+      if (pvValue != NULL)
+         iSharedPresent++;
+   }
+   ASSURE(SymTable_getLength(oSymTable)
+      == (size_t)(iCount / 2 * THREAD_COUNT + iSharedPresent));
+
+   SymTable_free(oSymTable);
+   free(aiValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If the worker's index is 0, repeatedly fill the table with keys
+   "g-i" for each i below the count, with aiShared as their value, and
+   empty it again, growing and shrinking it. Otherwise, repeatedly look
+   up the keys "k-i" for each i below the shared count, whose values
+   are the addresses of their elements of aiValues, look up as many of
+   the keys "g-i", which may or may not be there, and count the
+   bindings of the table. */
+
+static void *resizeOrRead(void *pvWorker)
+{
+   enum {ROUND_COUNT = 4};
+
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   SymTable_T oSymTable = psWorker->oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int iRound;
+   int iRoundCount;
+   int iVisits;
+   void *pvValue;
+   int i;
+
+   if (psWorker->iIndex == 0)
+   {
+      for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+      {
+         for (i = 0; i < psWorker->iCount; i++)
+         {
+            sprintf(acKey, "g-%d", i);
+            ASSURE(SymTable_put(oSymTable, acKey, psWorker->aiShared));
+         }
+         for (i = 0; i < psWorker->iCount; i++)
+         {
+            sprintf(acKey, "g-%d", i);
+            ASSURE(SymTable_remove(oSymTable, acKey)
+               == psWorker->aiShared);
+         }
+      }
+      return NULL;
+   }
+
+   /* enough rounds to overlap the filling worker's, which are far
+   longer */
+   iRoundCount = psWorker->iCount / 1000 + 1;
+   for (iRound = 0; iRound < iRoundCount; iRound++)
+   {
+      for (i = 0; i < psWorker->iSharedCount; i++)
+      {
+         sprintf(acKey, "k-%d", i);
+         ASSURE(SymTable_get(oSymTable, acKey)
+            == &psWorker->aiValues[i]);
+
+         /* the filling worker may be removing this very key */
+         sprintf(acKey, "g-%d", (iRound * 997 + i * 131)
+            % (psWorker->iCount + 1));
+         pvValue = SymTable_get(oSymTable, acKey);
+         ASSURE(pvValue == NULL || pvValue == psWorker->aiShared);
+      }
+      iVisits = 0;
+      SymTable_map(oSymTable, countBinding, &iVisits);
+      ASSURE(iVisits >= psWorker->iSharedCount);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that bindings stay visible to threads looking them up while
+   another thread grows and shrinks the table around them. */
+
+static void testReadsDuringResize(int iBindingCount)
+{
+   enum {STABLE_COUNT = 100};
+
+   SymTable_T oSymTable;
+   struct Worker asWorkers[THREAD_COUNT];
+   char acKey[MAX_KEY_LENGTH];
+   int aiValues[STABLE_COUNT];
+   int iFillValue;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing lookups while the table resizes.\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < STABLE_COUNT; i++)
+   {
+      sprintf(acKey, "k-%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+   }
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].iCount = iBindingCount;
+      asWorkers[i].aiValues = aiValues;
+      asWorkers[i].aiShared = &iFillValue;
+      asWorkers[i].iSharedCount = STABLE_COUNT;
+   }
+   runWorkers(asWorkers, resizeOrRead);
+
+   ASSURE(SymTable_getLength(oSymTable) == STABLE_COUNT);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Report the time that THREAD_COUNT threads take to add iBindingCount
+   bindings between them, and then to look each up four times. */
+
+static void testConcurrentSpeed(int iBindingCount)
+{
+   SymTable_T oSymTable;
+   struct Worker asWorkers[THREAD_COUNT];
+   int *aiValues;
+   int iCount;
+   int i;
+   struct timespec sStart;
+   struct timespec sPut;
+   struct timespec sEnd;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing concurrent speed.\n");
+   fflush(stdout);
+
+   iCount = iBindingCount / THREAD_COUNT;
+   aiValues = (int*)calloc((size_t)iCount * THREAD_COUNT + 1,
+      sizeof(int));
+   ASSURE(aiValues != NULL);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].iCount = iCount;
+      asWorkers[i].aiValues = &aiValues[i * iCount];
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &sStart);
+   runWorkers(asWorkers, putOwnKeys);
+   clock_gettime(CLOCK_MONOTONIC, &sPut);
+   runWorkers(asWorkers, getOwnKeys);
+   clock_gettime(CLOCK_MONOTONIC, &sEnd);
+
+   SymTable_free(oSymTable);
+   free(aiValues);
+
+   printf("Wall time for %d threads to add %d bindings:  %f seconds\n",
+      THREAD_COUNT, iCount * THREAD_COUNT, elapsed(&sStart, &sPut));
+   printf("Wall time for %d threads to look them up 4 times:  "
+      "%f seconds\n", THREAD_COUNT, elapsed(&sPut, &sEnd));
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable implementation under calls from several threads at
+   once. The command-line argument is the number of bindings for the
+   tests. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testConcurrentCreation();
+   testDisjointPuts(iBindingCount);
+   testMixedOperations(iBindingCount);
+   testReadsDuringResize(iBindingCount);
+   testConcurrentSpeed(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}